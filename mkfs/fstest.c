@@ -0,0 +1,347 @@
+/* fstest.c - runs the kernel's file system code on the host
+ * vim:ts=4 noexpandtab
+ *
+ * Usage: fstest disk image reference_file
+ *        fstest lz4 image compressed_image
+ *
+ * The kernel's fsys, journal, block layer, buffer cache, RAM disk, LZ4 and
+ * VFS sources are built with fstest.h in place of lib.h, see the Makefile.
+ * Images and the fake pcb live below 4 GB so the kernel's 32-bit addresses
+ * work in a 64-bit process.
+ *
+ * disk mounts image from a RAM disk the way an ATA image is mounted, through
+ * the buffer cache: data blocks load on demand, file writes (one big enough
+ * for double-indirect blocks) are written back and survive a remount of the
+ * same device, unlink frees the blocks for the next file, and files that are
+ * open or mapped cannot be unlinked. reference_file is the host copy of
+ * "fish", which the image must have in the root and in "sub".
+ *
+ * lz4 mounts an image and the same files built with mkfs -z, and checks that
+ * every regular file of the root decompresses to the uncompressed bytes.
+ *
+ * Every check prints PASS or FAIL, the exit status is the number of failures.
+ */
+
+#include "fstest.h"
+#include "../student-distrib/process.h"
+#include "../student-distrib/page.h"
+#include "../student-distrib/vfs.h"
+#include "../student-distrib/drivers/ramdisk.h"
+#include "../student-distrib/drivers/bcache.h"
+
+/* the host's C library, its headers clash with the kernel's types */
+typedef struct FILE FILE;
+FILE* fopen(const char* path, const char* mode);
+unsigned long fread(void* buf, unsigned long size, unsigned long count, FILE* file);
+int fclose(FILE* file);
+int memcmp(const void* s1, const void* s2, unsigned long n);
+void* mmap(void* addr, unsigned long length, int prot, int flags, int fd, long offset);
+
+#define PROT_RW             0x3             /* PROT_READ | PROT_WRITE */
+#define MAP_LOW             0x62            /* MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT */
+#define MAP_AT              0x32            /* MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED */
+
+#define MB                  (1024 * 1024)
+#define DEV_SIZE            (8 * MB)        /* RAM disk, as big as the kernel's disk image area */
+#define BIG_FILE_SIZE       (5 * MB)        /* past the direct and single-indirect blocks */
+#define WRITE_CHUNK         100000          /* bytes per file_write, not block aligned */
+#define FISH_SIZE           36164
+#define MAPPED_BLOCK        1100            /* block of the big file whose memory copy is checked */
+
+/* what the file system code needs from the rest of the kernel */
+fops_jumptable_t rtc_jmptable;
+file_desc_t open_file_table[MAX_OPEN_FILES];
+static uint32_t mapped_page;    /* the one mmap page of pid 0, 0 for none */
+
+void schedule_yield(void) {
+}
+
+file_desc_t* get_file_desc(int32_t fd) {
+    return &open_file_table[fd];
+}
+
+uint32_t get_mmap_page(uint32_t pid, uint32_t page_idx) {
+    return (pid == 0 && page_idx == 0) ? mapped_page : 0;
+}
+
+static int failures;            /* checks that failed */
+static uint8_t pattern[BIG_FILE_SIZE];
+static uint8_t back[BIG_FILE_SIZE];
+static uint8_t fish[FISH_SIZE];
+
+/* check - reports a check
+ *
+ * Inputs: name - what was checked
+ *         ok - the check passed (nonzero) or failed (0)
+ * Outputs: None
+ * Side Effects: counts failures
+ */
+static void check(const char* name, int ok) {
+    printf("%s %s\n", ok ? "PASS" : "FAIL", name);
+    failures += !ok;
+}
+
+/* alloc_low - allocates zeroed memory below 4 GB
+ *
+ * Inputs: size - bytes
+ * Outputs: the memory
+ * Side Effects: None
+ */
+static uint8_t* alloc_low(uint32_t size) {
+    return mmap(NULL, size, PROT_RW, MAP_LOW, -1, 0);
+}
+
+/* load_file - reads a host file
+ *
+ * Inputs: path - host path
+ *         buf - buffer to fill
+ *         size - size of buf
+ * Outputs: bytes read, 0 if the file cannot be opened
+ * Side Effects: None
+ */
+static uint32_t load_file(const char* path, uint8_t* buf, uint32_t size) {
+    FILE* file = fopen(path, "rb");    /* host file */
+    uint32_t n;                         /* bytes read */
+
+    if (file == NULL) {
+        return 0;
+    }
+    n = fread(buf, 1, size, file);
+    fclose(file);
+    return n;
+}
+
+/* start_process - makes pid 0 the current process with the root of sb as its directory
+ *
+ * Inputs: sb - mounted image
+ * Outputs: None
+ * Side Effects: maps the memory the pcb of pid 0 is at
+ */
+static void start_process(vfs_sb_t* sb) {
+    pcb_t* pcb = (pcb_t*)(USER_MEM_BASE_ADDR - _8KB);  /* pcb of pid 0 */
+
+    mmap((void*)(USER_MEM_BASE_ADDR - MB), MB, PROT_RW, MAP_AT, -1, 0);
+    pcb->id = 0;
+    pcb->mmap_next = 1;
+    pcb->cwd.sb = sb;
+    pcb->cwd.inode = sb->root;
+    activeProcesses = 1;
+    currentPID = 0;
+    current_PCB = pcb;
+}
+
+/* read_path - reads the start of a file
+ *
+ * Inputs: sb - mounted image
+ *         path - path from the root
+ *         buf - buffer to fill
+ *         length - bytes to read
+ * Outputs: 0 for success, -1 if the file is missing or the read failed
+ * Side Effects: None
+ */
+static int32_t read_path(vfs_sb_t* sb, const char* path, uint8_t* buf, uint32_t length) {
+    dentry_t dentry;    /* dentry of the file */
+
+    if (sb->ops->lookup(sb, sb->root, (const uint8_t*)path, &dentry) == -1) {
+        return -1;
+    }
+    return (sb->ops->read_data(sb, dentry.inode_idx, 0, buf, length) == -1) ? -1 : 0;
+}
+
+/* write_path - writes a file through file_write, the way the write syscall does
+ *
+ * Inputs: sb - mounted image
+ *         path - path from the root
+ *         pos - byte to start at
+ *         buf - bytes to write
+ *         length - bytes to write, split into WRITE_CHUNK byte writes
+ * Outputs: 0 for success, -1 if the file is missing or a write failed
+ * Side Effects: uses fd 2
+ */
+static int32_t write_path(vfs_sb_t* sb, const char* path, uint32_t pos, const uint8_t* buf, uint32_t length) {
+    file_desc_t* file = &open_file_table[2];    /* open file of fd 2 */
+    dentry_t dentry;                            /* dentry of the file */
+    uint32_t done;                              /* bytes written */
+    uint32_t chunk;                             /* bytes of the current write */
+    int32_t ret = 0;                            /* return value */
+
+    if (sb->ops->lookup(sb, sb->root, (const uint8_t*)path, &dentry) == -1) {
+        return -1;
+    }
+    file->refs = 1;
+    file->sb = sb;
+    file->inode_num = dentry.inode_idx;
+    file->file_pos = pos;
+    file->fops_table_ptr = sb->ops->fops[REGULAR_FILE_TYPE];
+
+    for (done = 0; done < length && ret == 0; done += chunk) {
+        chunk = (length - done > WRITE_CHUNK) ? WRITE_CHUNK : length - done;
+        if (file_write(2, buf + done, chunk) != (int32_t)chunk) {
+            ret = -1;
+        }
+    }
+    file->refs = 0;
+    return ret;
+}
+
+/* disk_test - checks an image mounted from a RAM disk through the buffer cache
+ *
+ * Inputs: image_path - image built by mkfs, with "fish" in the root and in "sub"
+ *         fish_path - host copy of "fish"
+ * Outputs: None
+ * Side Effects: counts failures
+ */
+static void disk_test(const char* image_path, const char* fish_path) {
+    uint8_t* disk = alloc_low(DEV_SIZE);            /* contents of the RAM disk */
+    uint8_t* mem[3];                                /* memory of each mount */
+    blk_device_t* dev;                              /* the RAM disk */
+    vfs_sb_t* sb;                                   /* first mount */
+    vfs_sb_t* again;                                /* later mount of the same device */
+    boot_dentry_t* boot;                            /* boot block of the first mount */
+    bcache_stats_t stats;                           /* buffer cache counters */
+    file_desc_t* open_file = &open_file_table[3];   /* file kept open for the unlink check */
+    dentry_t dentry;                                /* dentry of a file */
+    uint32_t addr;                                  /* memory copy of a block */
+    uint32_t i;                                     /* loop index */
+
+    if (load_file(image_path, disk, DEV_SIZE) == 0 || load_file(fish_path, fish, FISH_SIZE) != FISH_SIZE) {
+        check("load image and fish", 0);
+        return;
+    }
+    for (i = 0; i < 3; i++) {
+        mem[i] = alloc_low(DEV_SIZE);
+    }
+    for (i = 0; i < BIG_FILE_SIZE; i++) {
+        pattern[i] = i * 7 + i / DISK_BLOCK_SIZE;
+    }
+
+    init_blkdev();
+    init_bcache();
+    dev = ramdisk_create((uint32_t)(unsigned long)disk, DEV_SIZE);
+    sb = fsys_load_disk(dev, (uint32_t)(unsigned long)mem[0], DEV_SIZE);
+    check("mount from the device", sb != NULL);
+    if (sb == NULL) {
+        return;
+    }
+    start_process(sb);
+
+    // data blocks are read from the device when they are used, not at mount
+    boot = (boot_dentry_t*)mem[0];
+    sb->ops->lookup(sb, sb->root, (const uint8_t*)"fish", &dentry);
+    addr = (uint32_t)(unsigned long)mem[0] + (1 + boot->num_inodes + ((inode_t*)(mem[0] + (1 + dentry.inode_idx) * DISK_BLOCK_SIZE))->block_idx_arr[0]) * DISK_BLOCK_SIZE;
+    for (i = 0; i < DISK_BLOCK_SIZE && ((uint8_t*)(unsigned long)addr)[i] == 0; i++);
+    check("file data not loaded at mount", i == DISK_BLOCK_SIZE);
+    check("read fish", read_path(sb, "fish", back, FISH_SIZE) == 0 && memcmp(back, fish, FISH_SIZE) == 0);
+    check("read sub/fish", read_path(sb, "sub/fish", back, FISH_SIZE) == 0 && memcmp(back, fish, FISH_SIZE) == 0);
+
+    // a file big enough for indirect and double-indirect blocks, a file in a new directory
+    check("create big", sb->ops->create(sb, sb->root, (const uint8_t*)"big") == 0);
+    check("write big", write_path(sb, "big", 0, pattern, BIG_FILE_SIZE) == 0);
+    check("mkdir d2", sb->ops->mkdir(sb, sb->root, (const uint8_t*)"d2") == 0);
+    check("create d2/x", sb->ops->create(sb, sb->root, (const uint8_t*)"d2/x") == 0);
+    check("write d2/x", write_path(sb, "d2/x", 0, (const uint8_t*)"hello", 5) == 0);
+
+    // a block mapped in memory follows later writes
+    sb->ops->lookup(sb, sb->root, (const uint8_t*)"big", &dentry);
+    check("map a block of big", sb->ops->block_addr(sb, dentry.inode_idx, MAPPED_BLOCK, &addr) == 0 &&
+          memcmp((void*)(unsigned long)addr, pattern + MAPPED_BLOCK * DISK_BLOCK_SIZE, DISK_BLOCK_SIZE) == 0);
+    memcpy(pattern + MAPPED_BLOCK * DISK_BLOCK_SIZE + 10, "ZZZ", 3);
+    check("overwrite big", write_path(sb, "big", MAPPED_BLOCK * DISK_BLOCK_SIZE + 10, (const uint8_t*)"ZZZ", 3) == 0);
+    check("mapped copy is current", memcmp((void*)(unsigned long)addr, pattern + MAPPED_BLOCK * DISK_BLOCK_SIZE, DISK_BLOCK_SIZE) == 0);
+    bcache_get_stats(&stats);
+    check("blocks written back", stats.writebacks > 0);
+
+    // everything committed is on the device
+    again = fsys_load_disk(dev, (uint32_t)(unsigned long)mem[1], DEV_SIZE);
+    check("remount", again != NULL);
+    if (again == NULL) {
+        return;
+    }
+    check("big after remount", read_path(again, "big", back, BIG_FILE_SIZE) == 0 && memcmp(back, pattern, BIG_FILE_SIZE) == 0);
+    check("d2/x after remount", read_path(again, "d2/x", back, 5) == 0 && memcmp(back, "hello", 5) == 0);
+    check("fish after remount", read_path(again, "fish", back, FISH_SIZE) == 0 && memcmp(back, fish, FISH_SIZE) == 0);
+
+    // open and mapped files stay
+    sb->ops->lookup(sb, sb->root, (const uint8_t*)"frame0.txt", &dentry);
+    open_file->refs = 1;
+    open_file->sb = sb;
+    open_file->inode_num = dentry.inode_idx;
+    open_file->fops_table_ptr = sb->ops->fops[REGULAR_FILE_TYPE];
+    check("unlink an open file fails", sb->ops->unlink(sb, sb->root, (const uint8_t*)"frame0.txt") == -1);
+    open_file->refs = 0;
+    mapped_page = addr;
+    check("unlink a mapped file fails", sb->ops->unlink(sb, sb->root, (const uint8_t*)"big") == -1);
+    mapped_page = 0;
+
+    // unlink frees the blocks, there is only room for the big file once
+    check("unlink big", sb->ops->unlink(sb, sb->root, (const uint8_t*)"big") == 0);
+    again = fsys_load_disk(dev, (uint32_t)(unsigned long)mem[2], DEV_SIZE);
+    check("remount after unlink", again != NULL);
+    if (again == NULL) {
+        return;
+    }
+    start_process(again);
+    check("big gone", again->ops->lookup(again, again->root, (const uint8_t*)"big", &dentry) == -1);
+    check("d2/x kept", read_path(again, "d2/x", back, 5) == 0 && memcmp(back, "hello", 5) == 0);
+    check("recreate big", again->ops->create(again, again->root, (const uint8_t*)"big") == 0);
+    check("rewrite big in the freed blocks", write_path(again, "big", 0, pattern, BIG_FILE_SIZE) == 0);
+}
+
+/* lz4_test - checks that a compressed image reads the same as an uncompressed one
+ *
+ * Inputs: image_path - image built by mkfs
+ *         zimage_path - image of the same files built by mkfs -z
+ * Outputs: None
+ * Side Effects: counts failures
+ */
+static void lz4_test(const char* image_path, const char* zimage_path) {
+    uint8_t* image = alloc_low(DEV_SIZE);   /* uncompressed image */
+    uint8_t* zimage = alloc_low(DEV_SIZE);  /* compressed image */
+    vfs_sb_t* sb;                           /* mount of image */
+    vfs_sb_t* zsb;                          /* mount of zimage */
+    boot_dentry_t* boot;                    /* boot block of image */
+    dentry_t* entry;                        /* root dentry of image */
+    dentry_t zentry;                        /* same file in zimage */
+    stat_t st;                              /* size of the file */
+    uint32_t i;                             /* loop index */
+
+    if (load_file(image_path, image, DEV_SIZE) == 0 || load_file(zimage_path, zimage, DEV_SIZE) == 0) {
+        check("load images", 0);
+        return;
+    }
+    sb = init_fsys((uint32_t)(unsigned long)image);
+    zsb = init_fsys((uint32_t)(unsigned long)zimage);
+    check("mount both images", sb != NULL && zsb != NULL);
+    if (sb == NULL || zsb == NULL) {
+        return;
+    }
+
+    boot = (boot_dentry_t*)image;
+    for (i = 0; i < boot->num_dir_entries; i++) {
+        entry = (dentry_t*)(image + (i + 1) * DENTRY_SIZE);
+        if (entry->file_type != REGULAR_FILE_TYPE) {
+            continue;
+        }
+        sb->ops->stat(sb, REGULAR_FILE_TYPE, entry->inode_idx, &st);
+        memset(back, 0, st.file_size);
+        memset(pattern, 0xFF, st.file_size);
+        printf("%.32s: ", entry->file_name);
+        check("decompresses to the same bytes",
+              st.file_size <= BIG_FILE_SIZE && zsb->ops->lookup(zsb, zsb->root, (const uint8_t*)entry->file_name, &zentry) == 0 &&
+              sb->ops->read_data(sb, entry->inode_idx, 0, back, st.file_size) != -1 &&
+              zsb->ops->read_data(zsb, zentry.inode_idx, 0, pattern, st.file_size) != -1 &&
+              memcmp(back, pattern, st.file_size) == 0);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc == 4 && strncmp(argv[1], "disk", 5) == 0) {
+        disk_test(argv[2], argv[3]);
+    } else if (argc == 4 && strncmp(argv[1], "lz4", 4) == 0) {
+        lz4_test(argv[2], argv[3]);
+    } else {
+        printf("usage: fstest disk image reference_file\n       fstest lz4 image compressed_image\n");
+        return 1;
+    }
+    return failures;
+}
@@ -0,0 +1,623 @@
+/* mkfs.c - builds a file system image from a host directory
+ * vim:ts=4 noexpandtab
+ *
+ * Usage: mkfs [-r] [-z] [-n inodes] [-f free_blocks] -i input_dir -o output_image
+ *
+ * Unlike createfs, the layout is fully determined by the input: dentries are
+ * sorted by name, inodes are numbered and data blocks are handed out breadth
+ * first in that order, and every file and directory gets one contiguous run
+ * of data blocks. Subdirectories become directories holding "." and "..".
+ * A file past the direct block indices of its inode gets its indirect blocks
+ * right after its data, the double-indirect block first.
+ * -r prints where every file ended up.
+ * -z compresses every 4 KB block of a regular file with LZ4 and packs the
+ * blocks back to back, for files that end up in fewer data blocks that way.
+ * The kernel decompresses them on read; compressed files are read-only.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/* image format, must match student-distrib/drivers/fsys.h */
+#define DENTRY_SIZE             64
+#define DISK_BLOCK_SIZE         4096
+#define MAX_DENTRIES            63
+#define FILENAME_LEN            32
+#define MAX_INODES              1024
+#define INODE_DIRECT_BLOCKS     1020
+#define INDIRECT_ENTRIES        (DISK_BLOCK_SIZE / 4)
+#define DIR_MAX_ENTRIES         512
+#define INODE_COMPRESSED        0x1
+#define ZINODE_DBLOCK           0
+#define ZINODE_NUM_DBLOCKS      1
+#define ZINODE_OFFSETS          2
+#define ZINODE_MAX_BLOCKS       (INODE_DIRECT_BLOCKS - ZINODE_OFFSETS - 1)
+
+/* LZ4 block format limits */
+#define LZ4_MIN_MATCH           4
+#define LZ4_RUN_MASK            15
+#define LZ4_LAST_LITERALS       5       /* a block ends with at least this many literals */
+#define LZ4_MATCH_LIMIT         12      /* no match starts in the last 12 bytes */
+#define LZ4_MAX_OFFSET          65535
+#define LZ4_HASH_BITS           12
+
+#define RTC_FILE_TYPE           0
+#define DIRECTORY_FILE_TYPE     1
+#define REGULAR_FILE_TYPE       2
+
+#define DEFAULT_INODES          64
+#define DEFAULT_FREE_BLOCKS     16      /* room for the journal and new files */
+#define MAX_HOST_PATH           4096
+
+/* one file or directory of the image */
+typedef struct node_t {
+    char name[FILENAME_LEN + 1];    /* name in the image, truncated to FILENAME_LEN */
+    char* host_path;                /* path on the host, NULL for the rtc entry */
+    uint32_t type;                  /* file type */
+    uint32_t inode;                 /* inode number */
+    uint32_t size;                  /* file size in the image */
+    uint32_t first_block;           /* first data block of the contiguous run */
+    uint32_t num_blocks;            /* data blocks of the run */
+    int32_t parent;                 /* node index of the parent directory, -1 for the root */
+    int32_t first_child;            /* node index of the first entry of a directory */
+    int32_t num_children;           /* entries of a directory, "." and ".." not included */
+    uint8_t* stream;                /* packed LZ4 blocks of a compressed file, NULL if not compressed */
+    uint32_t* offsets;              /* stream offset of every file block, then the end of the stream */
+} node_t;
+
+static node_t* nodes;           /* every node, the root first, then breadth first */
+static int32_t num_nodes;       /* nodes in use */
+static int32_t max_nodes;       /* nodes allocated */
+
+/* add_node - appends a node
+ *
+ * Inputs: name - name in the image, truncated to FILENAME_LEN characters
+ *         host_path - path on the host, copied, NULL for none
+ *         type - file type
+ *         parent - node index of the parent directory
+ * Outputs: node index
+ * Side Effects: may grow the node array, exits when out of memory
+ */
+static int32_t add_node(const char* name, const char* host_path, uint32_t type, int32_t parent) {
+    node_t* node;   /* new node */
+
+    if (num_nodes == max_nodes) {
+        max_nodes = (max_nodes == 0) ? 64 : max_nodes * 2;
+        nodes = realloc(nodes, max_nodes * sizeof(node_t));
+        if (nodes == NULL) {
+            fprintf(stderr, "mkfs: out of memory\n");
+            exit(1);
+        }
+    }
+
+    node = &nodes[num_nodes];
+    memset(node, 0, sizeof(node_t));
+    strncpy(node->name, name, FILENAME_LEN);
+    node->host_path = (host_path != NULL) ? strdup(host_path) : NULL;
+    node->type = type;
+    node->parent = parent;
+    node->first_child = -1;
+    return num_nodes++;
+}
+
+/* compare_nodes - orders nodes by name for qsort
+ *
+ * Inputs: a, b - nodes
+ * Outputs: strcmp order of the names
+ * Side Effects: None
+ */
+static int compare_nodes(const void* a, const void* b) {
+    return strcmp(((const node_t*)a)->name, ((const node_t*)b)->name);
+}
+
+/* scan_dir - adds the entries of a directory, sorted by name
+ *
+ * Inputs: dir - node index of the directory
+ * Outputs: 0 for success, -1 for an unreadable directory or a duplicate name
+ * Side Effects: appends the entries, fills first_child and num_children of dir
+ */
+static int32_t scan_dir(int32_t dir) {
+    char path[MAX_HOST_PATH];   /* host path of an entry */
+    DIR* host_dir;              /* open host directory */
+    struct dirent* entry;       /* host entry */
+    struct stat info;           /* type and size of the host entry */
+    int32_t first = num_nodes;  /* first entry of the directory */
+    int32_t i;                  /* loop index */
+
+    host_dir = opendir(nodes[dir].host_path);
+    if (host_dir == NULL) {
+        perror(nodes[dir].host_path);
+        return -1;
+    }
+
+    // the root also holds the rtc device
+    if (dir == 0) {
+        add_node("rtc", NULL, RTC_FILE_TYPE, dir);
+    }
+
+    while ((entry = readdir(host_dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "%s/%s", nodes[dir].host_path, entry->d_name);
+        if (stat(path, &info) == -1) {
+            perror(path);
+            closedir(host_dir);
+            return -1;
+        }
+
+        if (S_ISREG(info.st_mode)) {
+            if (info.st_size > (off_t)0xFFFFFFFF) {
+                fprintf(stderr, "mkfs: %s is larger than 4 GB\n", path);
+                closedir(host_dir);
+                return -1;
+            }
+            nodes[add_node(entry->d_name, path, REGULAR_FILE_TYPE, dir)].size = info.st_size;
+        } else if (S_ISDIR(info.st_mode)) {
+            add_node(entry->d_name, path, DIRECTORY_FILE_TYPE, dir);
+        } else {
+            fprintf(stderr, "mkfs: skipping %s, not a regular file or directory\n", path);
+        }
+    }
+    closedir(host_dir);
+
+    nodes[dir].first_child = first;
+    nodes[dir].num_children = num_nodes - first;
+    qsort(&nodes[first], nodes[dir].num_children, sizeof(node_t), compare_nodes);
+
+    // long names can collide once truncated
+    for (i = first + 1; i < num_nodes; i++) {
+        if (strcmp(nodes[i - 1].name, nodes[i].name) == 0) {
+            fprintf(stderr, "mkfs: %s and %s have the same name in the image\n",
+                    nodes[i - 1].host_path ? nodes[i - 1].host_path : "rtc", nodes[i].host_path);
+            return -1;
+        }
+    }
+
+    if (dir == 0 && 1 + nodes[dir].num_children > MAX_DENTRIES) {
+        fprintf(stderr, "mkfs: the root holds at most %d entries\n", MAX_DENTRIES - 1);
+        return -1;
+    }
+    if (dir != 0 && 2 + nodes[dir].num_children > DIR_MAX_ENTRIES) {
+        fprintf(stderr, "mkfs: %s holds more than %d entries\n", nodes[dir].host_path, DIR_MAX_ENTRIES - 2);
+        return -1;
+    }
+    return 0;
+}
+
+/* indirect_blocks - number of indirect blocks a file needs
+ *
+ * Inputs: num_blocks - file blocks
+ * Outputs: the indirect block, plus the double-indirect block and the indirect blocks it lists
+ * Side Effects: None
+ */
+static uint32_t indirect_blocks(uint32_t num_blocks) {
+    uint32_t count = 0; /* indirect blocks */
+
+    if (num_blocks > INODE_DIRECT_BLOCKS) {
+        count++;
+    }
+    if (num_blocks > INODE_DIRECT_BLOCKS + INDIRECT_ENTRIES) {
+        count += 1 + (num_blocks - INODE_DIRECT_BLOCKS - INDIRECT_ENTRIES + INDIRECT_ENTRIES - 1) / INDIRECT_ENTRIES;
+    }
+    return count;
+}
+
+/* put_word - stores a 32-bit word in the image
+ *
+ * Inputs: image - image being built
+ *         offset - byte offset in the image
+ *         value - word to store
+ * Outputs: None
+ * Side Effects: None
+ */
+static void put_word(uint8_t* image, size_t offset, uint32_t value) {
+    memcpy(image + offset, &value, 4);
+}
+
+/* lz4_put_length - writes the bytes extending a 4-bit length
+ *
+ * Inputs: dst - output position, moved past the bytes
+ *         end - end of the output buffer
+ *         length - full length minus the 4-bit part already in the token
+ * Outputs: 0 for success, -1 if the output is full
+ * Side Effects: None
+ */
+static int32_t lz4_put_length(uint8_t** dst, uint8_t* end, uint32_t length) {
+    for (; length >= 255; length -= 255) {
+        if (*dst >= end) {
+            return -1;
+        }
+        *(*dst)++ = 255;
+    }
+    if (*dst >= end) {
+        return -1;
+    }
+    *(*dst)++ = length;
+    return 0;
+}
+
+/* lz4_put_sequence - writes one sequence
+ *
+ * Inputs: dst - output position, moved past the sequence
+ *         end - end of the output buffer
+ *         literals - literal bytes
+ *         num_literals - number of literal bytes
+ *         offset - distance back to the match, unused for the last sequence
+ *         match_len - match length, 0 for the last sequence
+ * Outputs: 0 for success, -1 if the output is full
+ * Side Effects: None
+ */
+static int32_t lz4_put_sequence(uint8_t** dst, uint8_t* end, const uint8_t* literals, uint32_t num_literals,
+                                uint32_t offset, uint32_t match_len) {
+    uint8_t* token = *dst;  /* token of the sequence */
+    uint32_t match_code;    /* match length minus LZ4_MIN_MATCH */
+
+    if (*dst >= end) {
+        return -1;
+    }
+    (*dst)++;
+
+    *token = ((num_literals < LZ4_RUN_MASK) ? num_literals : LZ4_RUN_MASK) << 4;
+    if (num_literals >= LZ4_RUN_MASK && lz4_put_length(dst, end, num_literals - LZ4_RUN_MASK) == -1) {
+        return -1;
+    }
+    if (num_literals > (uint32_t)(end - *dst)) {
+        return -1;
+    }
+    memcpy(*dst, literals, num_literals);
+    *dst += num_literals;
+
+    if (match_len == 0) {
+        return 0;
+    }
+
+    if (end - *dst < 2) {
+        return -1;
+    }
+    *(*dst)++ = offset & 0xFF;
+    *(*dst)++ = offset >> 8;
+
+    match_code = match_len - LZ4_MIN_MATCH;
+    *token |= (match_code < LZ4_RUN_MASK) ? match_code : LZ4_RUN_MASK;
+    if (match_code >= LZ4_RUN_MASK && lz4_put_length(dst, end, match_code - LZ4_RUN_MASK) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+/* lz4_compress - compresses a block in the LZ4 block format
+ *      greedy, every position is hashed on its first 4 bytes and the last position
+ *      with the same hash is tried as a match
+ *
+ * Inputs: src - bytes to compress
+ *         length - number of bytes
+ *         dst - output buffer
+ *         capacity - size of dst
+ * Outputs: compressed length, 0 if it does not fit in capacity
+ * Side Effects: None
+ */
+static uint32_t lz4_compress(const uint8_t* src, uint32_t length, uint8_t* dst, uint32_t capacity) {
+    uint32_t table[1 << LZ4_HASH_BITS];     /* last position + 1 of each hash, 0 for none */
+    uint8_t* out = dst;                     /* next output byte */
+    uint8_t* end = dst + capacity;          /* end of the output */
+    uint32_t anchor = 0;                    /* first byte not written yet */
+    uint32_t pos = 0;                       /* position being matched */
+    uint32_t candidate;                     /* earlier position with the same hash */
+    uint32_t match_len;                     /* length of the match found */
+    uint32_t word;                          /* 4 bytes at pos */
+    uint32_t hash;                          /* hash of word */
+
+    memset(table, 0, sizeof(table));
+
+    while (length >= LZ4_MATCH_LIMIT + 1 && pos < length - LZ4_MATCH_LIMIT) {
+        memcpy(&word, src + pos, 4);
+        hash = (word * 2654435761U) >> (32 - LZ4_HASH_BITS);
+        candidate = table[hash];
+        table[hash] = pos + 1;
+
+        if (candidate == 0 || pos - (candidate - 1) > LZ4_MAX_OFFSET || memcmp(src + candidate - 1, src + pos, 4) != 0) {
+            pos++;
+            continue;
+        }
+        candidate--;
+
+        match_len = LZ4_MIN_MATCH;
+        while (pos + match_len < length - LZ4_LAST_LITERALS && src[candidate + match_len] == src[pos + match_len]) {
+            match_len++;
+        }
+
+        if (lz4_put_sequence(&out, end, src + anchor, pos - anchor, pos - candidate, match_len) == -1) {
+            return 0;
+        }
+        pos += match_len;
+        anchor = pos;
+    }
+
+    if (lz4_put_sequence(&out, end, src + anchor, length - anchor, 0, 0) == -1) {
+        return 0;
+    }
+    return out - dst;
+}
+
+/* compress_file - packs a regular file as LZ4 blocks
+ *      a block that does not get shorter is stored as it is, and the whole file is
+ *      left uncompressed unless it needs fewer data blocks packed
+ *
+ * Inputs: node - regular file with its size set
+ * Outputs: 0 for success, -1 if the file could not be read
+ * Side Effects: fills stream and offsets and shrinks num_blocks when the file is compressed
+ */
+static int32_t compress_file(node_t* node) {
+    uint8_t* raw;           /* contents of the file */
+    uint8_t* stream;        /* packed blocks */
+    uint32_t* offsets;      /* offset table */
+    uint32_t num_blocks = node->num_blocks; /* file blocks */
+    uint32_t block_len;     /* length of the current block */
+    uint32_t packed_len;    /* compressed length of the current block */
+    uint32_t i;             /* loop index */
+    FILE* file;             /* host file */
+
+    if (num_blocks == 0 || num_blocks > ZINODE_MAX_BLOCKS) {
+        return 0;
+    }
+
+    raw = malloc(node->size);
+    stream = malloc(num_blocks * DISK_BLOCK_SIZE);
+    offsets = malloc((num_blocks + 1) * sizeof(uint32_t));
+    if (raw == NULL || stream == NULL || offsets == NULL) {
+        fprintf(stderr, "mkfs: out of memory\n");
+        exit(1);
+    }
+
+    file = fopen(node->host_path, "rb");
+    if (file == NULL || fread(raw, 1, node->size, file) != node->size) {
+        perror(node->host_path);
+        return -1;
+    }
+    fclose(file);
+
+    offsets[0] = 0;
+    for (i = 0; i < num_blocks; i++) {
+        block_len = (i + 1 < num_blocks || node->size % DISK_BLOCK_SIZE == 0) ? DISK_BLOCK_SIZE : node->size % DISK_BLOCK_SIZE;
+
+        // a packed length equal to the block length means the block is stored as it is
+        packed_len = lz4_compress(raw + i * DISK_BLOCK_SIZE, block_len, stream + offsets[i], block_len - 1);
+        if (packed_len == 0) {
+            memcpy(stream + offsets[i], raw + i * DISK_BLOCK_SIZE, block_len);
+            packed_len = block_len;
+        }
+        offsets[i + 1] = offsets[i] + packed_len;
+    }
+    free(raw);
+
+    if ((offsets[num_blocks] + DISK_BLOCK_SIZE - 1) / DISK_BLOCK_SIZE >= num_blocks) {
+        free(stream);
+        free(offsets);
+        return 0;
+    }
+
+    node->stream = stream;
+    node->offsets = offsets;
+    node->num_blocks = (offsets[num_blocks] + DISK_BLOCK_SIZE - 1) / DISK_BLOCK_SIZE;
+    return 0;
+}
+
+/* fill_dentry - writes a dentry
+ *
+ * Inputs: dentry - 64 byte dentry in the image
+ *         name - file name
+ *         type - file type
+ *         inode - inode number
+ * Outputs: None
+ * Side Effects: None
+ */
+static void fill_dentry(uint8_t* dentry, const char* name, uint32_t type, uint32_t inode) {
+    memset(dentry, 0, DENTRY_SIZE);
+    strncpy((char*)dentry, name, FILENAME_LEN);
+    memcpy(dentry + FILENAME_LEN, &type, 4);
+    memcpy(dentry + FILENAME_LEN + 4, &inode, 4);
+}
+
+/* usage - prints the usage and exits
+ *
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: exits
+ */
+static void usage(void) {
+    fprintf(stderr, "usage: mkfs [-r] [-z] [-n inodes] [-f free_blocks] -i input_dir -o output_image\n");
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    char* input = NULL;                         /* host directory to copy */
+    char* output = NULL;                        /* image file to write */
+    int report = 0;                             /* print the layout */
+    int compress = 0;                           /* compress regular files */
+    uint32_t num_inodes = DEFAULT_INODES;       /* inodes in the image */
+    uint32_t free_blocks = DEFAULT_FREE_BLOCKS; /* unused data blocks at the end */
+    uint32_t used_inodes;                       /* inodes handed out, inode 0 included */
+    uint32_t num_dblocks;                       /* data blocks in the image */
+    uint32_t next_block = 0;                    /* first data block not handed out */
+    uint8_t* image;                             /* image being built */
+    uint8_t* inode_block;                       /* inode block of the current node */
+    uint8_t* data;                              /* first data block of the current node */
+    uint32_t entry;                             /* dentry count of a directory */
+    uint32_t value;                             /* word to store in the image */
+    uint32_t num_file_blocks;                   /* blocks the file size covers */
+    uint32_t meta;                              /* first indirect block of a file */
+    uint32_t rel;                               /* file block past the single-indirect blocks */
+    uint32_t saved_blocks = 0;                  /* data blocks compression saved */
+    FILE* file;                                 /* host file */
+    size_t image_size;                          /* bytes in the image */
+    int32_t i, j;                               /* loop indices */
+    int opt;                                    /* command line option */
+
+    while ((opt = getopt(argc, argv, "rzi:o:n:f:")) != -1) {
+        switch (opt) {
+            case 'r': report = 1; break;
+            case 'z': compress = 1; break;
+            case 'i': input = optarg; break;
+            case 'o': output = optarg; break;
+            case 'n': num_inodes = strtoul(optarg, NULL, 0); break;
+            case 'f': free_blocks = strtoul(optarg, NULL, 0); break;
+            default: usage();
+        }
+    }
+    if (input == NULL || output == NULL) {
+        usage();
+    }
+
+    // collect the tree breadth first, every directory's entries end up next to each other
+    add_node(".", input, DIRECTORY_FILE_TYPE, -1);
+    for (i = 0; i < num_nodes; i++) {
+        if (nodes[i].type == DIRECTORY_FILE_TYPE && scan_dir(i) == -1) {
+            return 1;
+        }
+    }
+
+    // number the inodes and hand out contiguous runs in the same order, inode 0 is the root and rtc
+    used_inodes = 1;
+    for (i = 1; i < num_nodes; i++) {
+        if (nodes[i].type == RTC_FILE_TYPE) {
+            continue;
+        }
+        nodes[i].inode = used_inodes++;
+        if (nodes[i].type == DIRECTORY_FILE_TYPE) {
+            nodes[i].size = (2 + nodes[i].num_children) * DENTRY_SIZE;
+        }
+        nodes[i].num_blocks = (nodes[i].size + DISK_BLOCK_SIZE - 1) / DISK_BLOCK_SIZE;
+        if (compress && nodes[i].type == REGULAR_FILE_TYPE) {
+            value = nodes[i].num_blocks;
+            if (compress_file(&nodes[i]) == -1) {
+                return 1;
+            }
+            saved_blocks += value - nodes[i].num_blocks;
+        }
+        if (nodes[i].stream == NULL) {
+            nodes[i].num_blocks += indirect_blocks(nodes[i].num_blocks);
+        }
+        nodes[i].first_block = next_block;
+        next_block += nodes[i].num_blocks;
+    }
+    if (used_inodes > num_inodes || num_inodes > MAX_INODES) {
+        fprintf(stderr, "mkfs: %u inodes needed, %u requested, at most %d\n", used_inodes, num_inodes, MAX_INODES);
+        return 1;
+    }
+    num_dblocks = next_block + free_blocks;
+
+    image_size = (size_t)(1 + num_inodes + num_dblocks) * DISK_BLOCK_SIZE;
+    image = calloc(1, image_size);
+    if (image == NULL) {
+        fprintf(stderr, "mkfs: out of memory\n");
+        return 1;
+    }
+
+    // boot block, the journal is set up by the kernel at the first mount
+    value = 1 + nodes[0].num_children;
+    memcpy(image, &value, 4);
+    memcpy(image + 4, &num_inodes, 4);
+    memcpy(image + 8, &num_dblocks, 4);
+    fill_dentry(image + DENTRY_SIZE, ".", DIRECTORY_FILE_TYPE, 0);
+    for (j = 0; j < nodes[0].num_children; j++) {
+        node_t* child = &nodes[nodes[0].first_child + j];  /* root entry */
+        fill_dentry(image + (2 + j) * DENTRY_SIZE, child->name, child->type, child->inode);
+    }
+
+    for (i = 1; i < num_nodes; i++) {
+        if (nodes[i].type == RTC_FILE_TYPE) {
+            continue;
+        }
+
+        inode_block = image + (1 + nodes[i].inode) * DISK_BLOCK_SIZE;
+        data = image + (1 + num_inodes + nodes[i].first_block) * DISK_BLOCK_SIZE;
+        memcpy(inode_block, &nodes[i].size, 4);
+
+        // the run and the offset table take the place of the block indices
+        if (nodes[i].stream != NULL) {
+            num_file_blocks = (nodes[i].size + DISK_BLOCK_SIZE - 1) / DISK_BLOCK_SIZE;
+            value = INODE_COMPRESSED;
+            memcpy(inode_block + DISK_BLOCK_SIZE - 4, &value, 4);
+            memcpy(inode_block + 4 + 4 * ZINODE_DBLOCK, &nodes[i].first_block, 4);
+            memcpy(inode_block + 4 + 4 * ZINODE_NUM_DBLOCKS, &nodes[i].num_blocks, 4);
+            memcpy(inode_block + 4 + 4 * ZINODE_OFFSETS, nodes[i].offsets, (num_file_blocks + 1) * 4);
+            memcpy(data, nodes[i].stream, nodes[i].offsets[num_file_blocks]);
+            continue;
+        }
+
+        // data blocks first, the indirect blocks follow them
+        num_file_blocks = (nodes[i].size + DISK_BLOCK_SIZE - 1) / DISK_BLOCK_SIZE;
+        meta = nodes[i].first_block + num_file_blocks;
+        for (j = 0; j < (int32_t)num_file_blocks; j++) {
+            value = nodes[i].first_block + j;
+            if (j < INODE_DIRECT_BLOCKS) {
+                memcpy(inode_block + 4 + 4 * j, &value, 4);
+            } else if (j < INODE_DIRECT_BLOCKS + INDIRECT_ENTRIES) {
+                put_word(image, (size_t)(1 + num_inodes + meta) * DISK_BLOCK_SIZE + 4 * (j - INODE_DIRECT_BLOCKS), value);
+            } else {
+                rel = j - INODE_DIRECT_BLOCKS - INDIRECT_ENTRIES;
+                put_word(image, (size_t)(1 + num_inodes + meta + 2 + rel / INDIRECT_ENTRIES) * DISK_BLOCK_SIZE + 4 * (rel % INDIRECT_ENTRIES), value);
+            }
+        }
+        if (num_file_blocks > INODE_DIRECT_BLOCKS) {
+            memcpy(inode_block + 4 + 4 * INODE_DIRECT_BLOCKS, &meta, 4);
+        }
+        if (num_file_blocks > INODE_DIRECT_BLOCKS + INDIRECT_ENTRIES) {
+            value = meta + 1;
+            memcpy(inode_block + 4 + 4 * (INODE_DIRECT_BLOCKS + 1), &value, 4);
+            for (j = 0; j < (int32_t)indirect_blocks(num_file_blocks) - 2; j++) {
+                put_word(image, (size_t)(1 + num_inodes + meta + 1) * DISK_BLOCK_SIZE + 4 * j, meta + 2 + j);
+            }
+        }
+
+        if (nodes[i].type == DIRECTORY_FILE_TYPE) {
+            fill_dentry(data, ".", DIRECTORY_FILE_TYPE, nodes[i].inode);
+            fill_dentry(data + DENTRY_SIZE, "..", DIRECTORY_FILE_TYPE, (nodes[i].parent == 0) ? 0 : nodes[nodes[i].parent].inode);
+            for (entry = 0; entry < (uint32_t)nodes[i].num_children; entry++) {
+                node_t* child = &nodes[nodes[i].first_child + entry];  /* directory entry */
+                fill_dentry(data + (2 + entry) * DENTRY_SIZE, child->name, child->type, child->inode);
+            }
+            continue;
+        }
+
+        file = fopen(nodes[i].host_path, "rb");
+        if (file == NULL || fread(data, 1, nodes[i].size, file) != nodes[i].size) {
+            perror(nodes[i].host_path);
+            return 1;
+        }
+        fclose(file);
+    }
+
+    file = fopen(output, "wb");
+    if (file == NULL || fwrite(image, 1, image_size, file) != image_size || fclose(file) != 0) {
+        perror(output);
+        return 1;
+    }
+
+    if (report) {
+        printf("%-6s %-6s %-6s %-8s %s\n", "inode", "block", "count", "size", "path");
+        for (i = 1; i < num_nodes; i++) {
+            if (nodes[i].type == RTC_FILE_TYPE) {
+                printf("%-6u %-6s %-6s %-8s %s\n", 0, "-", "-", "-", "rtc");
+                continue;
+            }
+            printf("%-6u %-6u %-6u %-8u %s%s\n", nodes[i].inode, nodes[i].first_block, nodes[i].num_blocks,
+                   nodes[i].size, nodes[i].host_path + strlen(input),
+                   (nodes[i].type == DIRECTORY_FILE_TYPE) ? "/" : (nodes[i].stream != NULL) ? " (lz4)" : "");
+        }
+        printf("%u of %u inodes, %u of %u data blocks used, %lu bytes\n",
+               used_inodes, num_inodes, next_block, num_dblocks, (unsigned long)image_size);
+        if (compress) {
+            printf("compression saved %u data blocks\n", saved_blocks);
+        }
+    }
+
+    return 0;
+}
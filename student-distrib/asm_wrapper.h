@@ -41,6 +41,15 @@
         popl %fs;  \
         popl %gs;  \
 
+/* DELIVER_SIGNALS
+ * delivers pending signals to the current process, must run right before RESTORE_REG
+ * so the stack holds a full hw_context_t that iret will return into
+ */
+#define DELIVER_SIGNALS         \
+        pushl %esp;             \
+        call deliver_signals;   \
+        addl $4, %esp;          \
+
 #endif /* ASM */
 
 #endif /* _ASM_WRAPPER_H */
@@ -0,0 +1,413 @@
+#include "ata.h"
+#include "pci.h"
+#include "../page.h"
+
+static ata_drive_t ata_drives[2];       /* master and slave of the primary channel */
+static uint32_t ata_bm_base;            /* bus master registers, 0 when there is no bus master */
+
+/* the channel works on one drive at a time */
+static ata_drive_t* ata_current;        /* drive whose request is on the channel */
+static ata_drive_t* ata_deferred;       /* drive whose request waits for the channel */
+static uint32_t ata_current_dma;        /* the current transfer uses DMA (1) or PIO (0) */
+
+/* progress of a PIO transfer */
+static blk_bio_t* ata_pio_bio;          /* bio holding the next sector */
+static uint32_t ata_pio_sector;         /* next sector within that bio */
+static uint32_t ata_pio_left;           /* sectors of the request not transferred yet */
+
+/* descriptor table, aligned to its size so it never crosses a 64 KB boundary */
+static ata_prd_t ata_prdt[ATA_MAX_PRDS] __attribute__ ((aligned (ATA_MAX_PRDS * 8)));
+
+/* ata_delay - waits about 400ns for the drive to update its status
+ *
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: None
+ */
+static void ata_delay(void) {
+    uint32_t i; /* loop index */
+
+    for (i = 0; i < 4; i++) {
+        inb(ATA_CTRL_BASE + ATA_REG_ALT_STATUS);
+    }
+}
+
+/* ata_wait - waits for the drive to stop being busy
+ *
+ * Inputs: mask - status bits that also have to be set, 0 for none
+ * Outputs: status, -1 on a timeout or an error
+ * Side Effects: None
+ */
+static int32_t ata_wait(uint32_t mask) {
+    uint32_t status;    /* status register */
+    uint32_t i;         /* loop index */
+
+    for (i = 0; i < ATA_TIMEOUT; i++) {
+        status = inb(ATA_CTRL_BASE + ATA_REG_ALT_STATUS);
+        if (status & ATA_SR_BSY) {
+            continue;
+        }
+        if (status & (ATA_SR_ERR | ATA_SR_DF)) {
+            return -1;
+        }
+        if ((status & mask) == mask) {
+            return status;
+        }
+    }
+
+    return -1;
+}
+
+/* ata_dma_able - checks if the bus master can reach a buffer
+ *      only identity mapped kernel memory has the same virtual and physical address
+ *
+ * Inputs: buf - buffer
+ *         num_bytes - buffer size
+ * Outputs: 1 if the buffer can be used for DMA, 0 otherwise
+ * Side Effects: None
+ */
+static uint32_t ata_dma_able(uint8_t* buf, uint32_t num_bytes) {
+    uint32_t start = (uint32_t)buf; /* first byte */
+
+    return (start >= KERNEL_MEM_BASE_ADDR && start + num_bytes <= USER_MEM_BASE_ADDR) ||
+           (start >= DISK_MEM_BASE_ADDR && start + num_bytes <= DISK_MEM_BASE_ADDR + DISK_MEM_SIZE);
+}
+
+/* ata_build_prdt - describes the bios of a request in the descriptor table
+ *      every bio is split at 64 KB boundaries
+ *
+ * Inputs: req - request
+ * Outputs: 0 for success, -1 if a buffer cannot be used for DMA or the table is too small
+ * Side Effects: fills ata_prdt
+ */
+static int32_t ata_build_prdt(blk_request_t* req) {
+    blk_bio_t* bio;         /* current bio */
+    uint32_t addr;          /* start of the next region */
+    uint32_t left;          /* bytes of the bio not described yet */
+    uint32_t num_bytes;     /* bytes in the current region */
+    uint32_t num_prds = 0;  /* descriptors used */
+
+    for (bio = req->bios; bio != NULL; bio = bio->next) {
+        if (!ata_dma_able(bio->buf, bio->num_sectors * BLK_SECTOR_SIZE)) {
+            return -1;
+        }
+
+        addr = (uint32_t)bio->buf;
+        left = bio->num_sectors * BLK_SECTOR_SIZE;
+        while (left != 0) {
+            if (num_prds == ATA_MAX_PRDS) {
+                return -1;
+            }
+            num_bytes = ATA_PRD_BOUNDARY - (addr & (ATA_PRD_BOUNDARY - 1));
+            if (num_bytes > left) {
+                num_bytes = left;
+            }
+
+            ata_prdt[num_prds].addr = addr;
+            ata_prdt[num_prds].num_bytes = num_bytes & 0xFFFF;
+            ata_prdt[num_prds].flags = 0;
+            num_prds++;
+
+            addr += num_bytes;
+            left -= num_bytes;
+        }
+    }
+
+    ata_prdt[num_prds - 1].flags = ATA_PRD_EOT;
+    return 0;
+}
+
+/* ata_pio_transfer - moves one sector between the data register and the request's buffers
+ *
+ * Inputs: write - write to the drive (1) or read from it (0)
+ * Outputs: None
+ * Side Effects: advances the PIO position
+ */
+static void ata_pio_transfer(uint32_t write) {
+    uint16_t* data = (uint16_t*)(ata_pio_bio->buf + ata_pio_sector * BLK_SECTOR_SIZE); /* sector in the buffer */
+    uint32_t i;                                                                         /* loop index */
+
+    for (i = 0; i < BLK_SECTOR_SIZE / 2; i++) {
+        if (write) {
+            outw(data[i], ATA_IO_BASE + ATA_REG_DATA);
+        } else {
+            data[i] = inw(ATA_IO_BASE + ATA_REG_DATA);
+        }
+    }
+
+    ata_pio_left--;
+    if (++ata_pio_sector == ata_pio_bio->num_sectors) {
+        ata_pio_bio = ata_pio_bio->next;
+        ata_pio_sector = 0;
+    }
+}
+
+/* ata_issue - sends the active request of a drive to the channel
+ *      uses DMA when the drive supports it and every buffer is reachable, PIO otherwise
+ *      must be called with interrupts disabled while the channel is free
+ *
+ * Inputs: drive - drive with an active request
+ * Outputs: 0 for success, -1 if the drive does not respond
+ * Side Effects: the channel belongs to the drive until the request is done
+ */
+static int32_t ata_issue(ata_drive_t* drive) {
+    blk_request_t* req = drive->blk.active; /* request to send */
+
+    // select the drive and wait for it to be ready for a command
+    outb(ATA_DRIVE_LBA | (drive->slave ? ATA_DRIVE_SLAVE : 0) | ((req->sector >> 24) & 0x0F), ATA_IO_BASE + ATA_REG_DRIVE);
+    ata_delay();
+    if (ata_wait(0) == -1) {
+        return -1;
+    }
+
+    ata_current = drive;
+    ata_current_dma = drive->dma && ata_build_prdt(req) == 0;
+
+    // BLK_MAX_SECTORS is 256, which the sector count register holds as 0
+    outb(req->num_sectors & 0xFF, ATA_IO_BASE + ATA_REG_SECCOUNT);
+    outb(req->sector & 0xFF, ATA_IO_BASE + ATA_REG_LBA_LO);
+    outb((req->sector >> 8) & 0xFF, ATA_IO_BASE + ATA_REG_LBA_MID);
+    outb((req->sector >> 16) & 0xFF, ATA_IO_BASE + ATA_REG_LBA_HI);
+
+    if (ata_current_dma) {
+        outb(0, ata_bm_base + ATA_BM_COMMAND);
+        outl((uint32_t)ata_prdt, ata_bm_base + ATA_BM_PRDT);
+        outb(ATA_BM_SR_IRQ | ATA_BM_SR_ERR, ata_bm_base + ATA_BM_STATUS);   // write 1 to clear
+        outb((req->write) ? 0 : ATA_BM_CMD_READ, ata_bm_base + ATA_BM_COMMAND);
+        outb((req->write) ? ATA_CMD_WRITE_DMA : ATA_CMD_READ_DMA, ATA_IO_BASE + ATA_REG_COMMAND);
+        outb(((req->write) ? 0 : ATA_BM_CMD_READ) | ATA_BM_CMD_START, ata_bm_base + ATA_BM_COMMAND);
+        return 0;
+    }
+
+    ata_pio_bio = req->bios;
+    ata_pio_sector = 0;
+    ata_pio_left = req->num_sectors;
+    outb((req->write) ? ATA_CMD_WRITE_PIO : ATA_CMD_READ_PIO, ATA_IO_BASE + ATA_REG_COMMAND);
+
+    // the first sector of a write goes out right away, the rest one per interrupt
+    if (req->write) {
+        ata_delay();
+        if (ata_wait(ATA_SR_DRQ) == -1) {
+            ata_current = NULL;
+            return -1;
+        }
+        ata_pio_transfer(1);
+    }
+    return 0;
+}
+
+/* ata_done - ends the transfer on the channel
+ *      a request waiting for the channel goes first so neither drive can starve the other
+ *
+ * Inputs: error - the transfer failed (1) or not (0)
+ * Outputs: None
+ * Side Effects: may start the next transfer
+ */
+static void ata_done(uint32_t error) {
+    ata_drive_t* drive = ata_current;   /* drive that finished */
+    ata_drive_t* next = ata_deferred;   /* drive waiting for the channel */
+
+    ata_current = NULL;
+    ata_deferred = NULL;
+
+    if (next != NULL && ata_issue(next) == -1) {
+        blk_complete(&next->blk, 1);
+    }
+    blk_complete(&drive->blk, error);
+}
+
+/* ata_service - moves the transfer on the channel forward
+ *      runs from the interrupt handler and from polling, does nothing when the drive
+ *      has not finished its current step
+ *      must be called with interrupts disabled
+ *
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: acknowledges the drive interrupt, may finish a request
+ */
+static void ata_service(void) {
+    blk_request_t* req;     /* request on the channel */
+    uint32_t bm_status;     /* bus master status */
+    uint32_t status;        /* drive status */
+
+    if (ata_current == NULL) {
+        inb(ATA_IO_BASE + ATA_REG_STATUS);
+        return;
+    }
+    req = ata_current->blk.active;
+
+    if (ata_current_dma) {
+        bm_status = inb(ata_bm_base + ATA_BM_STATUS);
+        if (!(bm_status & (ATA_BM_SR_IRQ | ATA_BM_SR_ERR))) {
+            return;
+        }
+
+        outb(0, ata_bm_base + ATA_BM_COMMAND);
+        status = inb(ATA_IO_BASE + ATA_REG_STATUS);
+        outb(ATA_BM_SR_IRQ | ATA_BM_SR_ERR, ata_bm_base + ATA_BM_STATUS);
+        ata_done((status & (ATA_SR_ERR | ATA_SR_DF)) || (bm_status & ATA_BM_SR_ERR));
+        return;
+    }
+
+    ata_delay();
+    status = inb(ATA_CTRL_BASE + ATA_REG_ALT_STATUS);
+    if (status & ATA_SR_BSY) {
+        return;
+    }
+    status = inb(ATA_IO_BASE + ATA_REG_STATUS);
+    if (status & (ATA_SR_ERR | ATA_SR_DF)) {
+        ata_done(1);
+        return;
+    }
+
+    if (req->write) {
+        // the drive wrote the last sector
+        if (ata_pio_left == 0) {
+            ata_done(0);
+        } else if (status & ATA_SR_DRQ) {
+            ata_pio_transfer(1);
+        }
+    } else if (status & ATA_SR_DRQ) {
+        ata_pio_transfer(0);
+        if (ata_pio_left == 0) {
+            ata_done(0);
+        }
+    }
+}
+
+/* ata_start - block layer hook that starts a request
+ *
+ * Inputs: dev - block device of a drive
+ *         req - its active request
+ * Outputs: 0 for success, -1 if the drive does not respond
+ * Side Effects: the request waits if the other drive has the channel
+ */
+static int32_t ata_start(blk_device_t* dev, blk_request_t* req) {
+    ata_drive_t* drive = (ata_drive_t*)dev->driver_data; /* drive of the device */
+
+    if (ata_current != NULL) {
+        ata_deferred = drive;
+        return 0;
+    }
+    return ata_issue(drive);
+}
+
+/* ata_poll - block layer hook that checks the channel without waiting for the interrupt
+ *
+ * Inputs: dev - unused, both drives share the channel
+ * Outputs: None
+ * Side Effects: may finish a request
+ */
+static void ata_poll(blk_device_t* dev) {
+    ata_service();
+}
+
+/* ata_identify - detects one drive of the channel
+ *
+ * Inputs: drive - drive to fill, its slave field picks the drive
+ * Outputs: 0 if an ATA disk answered, -1 if there is nothing or a non-ATA device
+ * Side Effects: fills the drive's size and DMA support
+ */
+static int32_t ata_identify(ata_drive_t* drive) {
+    uint16_t id[256];   /* IDENTIFY data */
+    uint32_t i;         /* loop index */
+
+    outb(ATA_DRIVE_LBA | (drive->slave ? ATA_DRIVE_SLAVE : 0), ATA_IO_BASE + ATA_REG_DRIVE);
+    ata_delay();
+    outb(0, ATA_IO_BASE + ATA_REG_SECCOUNT);
+    outb(0, ATA_IO_BASE + ATA_REG_LBA_LO);
+    outb(0, ATA_IO_BASE + ATA_REG_LBA_MID);
+    outb(0, ATA_IO_BASE + ATA_REG_LBA_HI);
+    outb(ATA_CMD_IDENTIFY, ATA_IO_BASE + ATA_REG_COMMAND);
+    ata_delay();
+
+    // no drive, or a floating bus with no channel at all
+    i = inb(ATA_IO_BASE + ATA_REG_STATUS);
+    if (i == 0 || i == 0xFF) {
+        return -1;
+    }
+
+    // ATAPI and SATA devices abort and leave their signature in the LBA registers
+    for (i = 0; i < ATA_TIMEOUT && (inb(ATA_CTRL_BASE + ATA_REG_ALT_STATUS) & ATA_SR_BSY); i++);
+    if (inb(ATA_IO_BASE + ATA_REG_LBA_MID) != 0 || inb(ATA_IO_BASE + ATA_REG_LBA_HI) != 0) {
+        return -1;
+    }
+    if (ata_wait(ATA_SR_DRQ) == -1) {
+        return -1;
+    }
+
+    for (i = 0; i < 256; i++) {
+        id[i] = inw(ATA_IO_BASE + ATA_REG_DATA);
+    }
+    inb(ATA_IO_BASE + ATA_REG_STATUS);
+
+    drive->blk.num_sectors = id[ATA_ID_LBA28_SECTORS] | ((uint32_t)id[ATA_ID_LBA28_SECTORS + 1] << 16);
+    drive->dma = (ata_bm_base != 0 && (id[ATA_ID_CAPS] & ATA_ID_CAPS_DMA));
+    return (drive->blk.num_sectors != 0) ? 0 : -1;
+}
+
+/* init_ATA - ATA initialization
+ *      finds the bus master registers of the IDE controller on PCI, then detects the
+ *      master and slave of the primary channel; without a bus master only PIO is used
+ *
+ * Inputs: None
+ * Outputs: number of drives registered
+ * Side Effects: registers block devices "hda" and "hdb", enables the ATA interrupt
+ */
+int32_t init_ATA(void) {
+    pci_addr_t pci;             /* location of the IDE controller */
+    uint32_t num_drives = 0;    /* drives found */
+    uint32_t i;                 /* loop index */
+
+    ata_current = NULL;
+    ata_deferred = NULL;
+
+    // let the controller master the bus so it can do DMA
+    ata_bm_base = 0;
+    if (pci_find_class(PCI_CLASS_STORAGE, PCI_SUBCLASS_IDE, &pci) == 0) {
+        ata_bm_base = pci_config_read(&pci, PCI_BAR0 + 4*PCI_IDE_BM_BAR) & PCI_BAR_IO_MASK;
+        pci_config_write(&pci, PCI_COMMAND, pci_config_read(&pci, PCI_COMMAND) | PCI_COMMAND_IO | PCI_COMMAND_MASTER);
+    }
+
+    // drives interrupt on completion
+    outb(0, ATA_CTRL_BASE + ATA_REG_DEV_CTRL);
+
+    for (i = 0; i < 2; i++) {
+        memset(&ata_drives[i], 0, sizeof(ata_drive_t));
+        ata_drives[i].slave = i;
+        if (ata_identify(&ata_drives[i]) == -1) {
+            continue;
+        }
+        if (ata_drives[i].blk.num_sectors > ATA_MAX_LBA) {
+            ata_drives[i].blk.num_sectors = ATA_MAX_LBA;
+        }
+
+        strcpy(ata_drives[i].blk.name, (i == 0) ? "hda" : "hdb");
+        ata_drives[i].blk.start = ata_start;
+        ata_drives[i].blk.poll = ata_poll;
+        ata_drives[i].blk.driver_data = &ata_drives[i];
+        if (blk_register(&ata_drives[i].blk) != -1) {
+            num_drives++;
+        }
+    }
+
+    if (num_drives != 0) {
+        enable_irq(ATA_IRQ);
+    }
+    return num_drives;
+}
+
+/* ATA_Handler - ATA interrupt handler
+ *
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: finishes DMA transfers and moves PIO transfers one sector forward
+ */
+void ATA_Handler(void) {
+    cli();
+
+    ata_service();
+
+    send_eoi(ATA_IRQ);
+    sti();
+}
@@ -0,0 +1,91 @@
+/* ata.h - ATA disk driver for the primary channel of the PIIX IDE controller
+ * vim:ts=4 noexpandtab
+ */
+#ifndef _ATA_H
+#define _ATA_H
+
+#include "../lib.h"
+#include "i8259.h"
+#include "blkdev.h"
+
+#define ATA_IRQ                 14
+#define ATA_IO_BASE             0x1F0   /* legacy command block of the primary channel */
+#define ATA_CTRL_BASE           0x3F6   /* legacy control block of the primary channel */
+
+/* command block registers, offsets from ATA_IO_BASE */
+#define ATA_REG_DATA            0
+#define ATA_REG_ERROR           1
+#define ATA_REG_SECCOUNT        2
+#define ATA_REG_LBA_LO          3
+#define ATA_REG_LBA_MID         4
+#define ATA_REG_LBA_HI          5
+#define ATA_REG_DRIVE           6
+#define ATA_REG_STATUS          7       /* reading it acknowledges the interrupt */
+#define ATA_REG_COMMAND         7
+
+/* control block, reading the alternate status does not acknowledge the interrupt */
+#define ATA_REG_ALT_STATUS      0
+#define ATA_REG_DEV_CTRL        0
+
+/* status bits */
+#define ATA_SR_ERR              0x01
+#define ATA_SR_DRQ              0x08
+#define ATA_SR_DF               0x20
+#define ATA_SR_BSY              0x80
+
+/* commands */
+#define ATA_CMD_READ_PIO        0x20
+#define ATA_CMD_WRITE_PIO       0x30
+#define ATA_CMD_READ_DMA        0xC8
+#define ATA_CMD_WRITE_DMA       0xCA
+#define ATA_CMD_IDENTIFY        0xEC
+
+#define ATA_DRIVE_LBA           0xE0    /* drive register with LBA addressing, OR the slave bit and LBA [27:24] */
+#define ATA_DRIVE_SLAVE         0x10
+#define ATA_MAX_LBA             0x10000000  /* LBA28 addresses */
+#define ATA_TIMEOUT             1000000     /* status reads before giving up on a busy drive */
+
+/* IDENTIFY words */
+#define ATA_ID_CAPS             49
+#define ATA_ID_CAPS_DMA         0x0100
+#define ATA_ID_LBA28_SECTORS    60
+
+/* bus master registers of the primary channel, offsets from BAR4 of the controller */
+#define ATA_BM_COMMAND          0
+#define ATA_BM_STATUS           2
+#define ATA_BM_PRDT             4
+#define ATA_BM_CMD_START        0x01
+#define ATA_BM_CMD_READ         0x08    /* the controller writes to memory */
+#define ATA_BM_SR_ERR           0x02
+#define ATA_BM_SR_IRQ           0x04
+
+/* physical region descriptors */
+#define ATA_MAX_PRDS            32
+#define ATA_PRD_EOT             0x8000  /* last descriptor of the table */
+#define ATA_PRD_BOUNDARY        0x10000 /* a region must not cross a 64 KB boundary */
+
+#define PCI_CLASS_STORAGE       0x01
+#define PCI_SUBCLASS_IDE        0x01
+#define PCI_IDE_BM_BAR          4
+
+/* physical region descriptor, one contiguous piece of a DMA transfer */
+typedef struct ata_prd_t {
+    uint32_t addr;          /* physical address */
+    uint16_t num_bytes;     /* bytes in the region, 0 means 64 KB */
+    uint16_t flags;         /* ATA_PRD_EOT on the last descriptor */
+} ata_prd_t;
+
+/* one drive on the channel */
+typedef struct ata_drive_t {
+    blk_device_t blk;       /* block device of the drive */
+    uint32_t slave;         /* master (0) or slave (1) */
+    uint32_t dma;           /* the drive and the controller can do DMA (1) or only PIO (0) */
+} ata_drive_t;
+
+/* detects the drives on the primary channel and registers them as block devices */
+int32_t init_ATA(void);
+
+/* ATA interrupt handler, finishes transfers */
+void ATA_Handler(void);
+
+#endif /* _ATA_H */
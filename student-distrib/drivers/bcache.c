@@ -0,0 +1,545 @@
+#include "bcache.h"
+
+static bcache_buf_t bcache_bufs[BCACHE_NUM_BUFS];   /* every buffer of the cache */
+static bcache_buf_t* bcache_hash[BCACHE_HASH_SIZE]; /* hash chains of the cached blocks */
+static bcache_buf_t* bcache_lru_head;               /* least recently used unheld buffer */
+static bcache_buf_t* bcache_lru_tail;               /* most recently used unheld buffer */
+static bcache_stats_t bcache_stats;                 /* counters */
+
+/* block data, in the kernel page so a disk can DMA into it */
+static uint8_t bcache_data[BCACHE_NUM_BUFS][BCACHE_BLOCK_SIZE] __attribute__ ((aligned (BCACHE_BLOCK_SIZE)));
+
+/* hash chain of a block, consecutive blocks of a device land in consecutive chains */
+#define BCACHE_HASH(dev, block)     (((block) ^ ((uint32_t)(dev) >> 6)) & (BCACHE_HASH_SIZE - 1))
+
+/* bcache_lru_remove - takes a buffer off the LRU list
+ *
+ * Inputs: buf - buffer on the list
+ * Outputs: None
+ * Side Effects: None
+ */
+static void bcache_lru_remove(bcache_buf_t* buf) {
+    if (buf->lru_prev != NULL) {
+        buf->lru_prev->lru_next = buf->lru_next;
+    } else {
+        bcache_lru_head = buf->lru_next;
+    }
+    if (buf->lru_next != NULL) {
+        buf->lru_next->lru_prev = buf->lru_prev;
+    } else {
+        bcache_lru_tail = buf->lru_prev;
+    }
+    buf->lru_prev = NULL;
+    buf->lru_next = NULL;
+}
+
+/* bcache_lru_add - puts a buffer on the LRU list
+ *
+ * Inputs: buf - buffer not on the list
+ *         oldest - add as the least (1) or the most (0) recently used buffer
+ * Outputs: None
+ * Side Effects: None
+ */
+static void bcache_lru_add(bcache_buf_t* buf, uint32_t oldest) {
+    if (oldest) {
+        buf->lru_prev = NULL;
+        buf->lru_next = bcache_lru_head;
+        if (bcache_lru_head != NULL) {
+            bcache_lru_head->lru_prev = buf;
+        } else {
+            bcache_lru_tail = buf;
+        }
+        bcache_lru_head = buf;
+    } else {
+        buf->lru_next = NULL;
+        buf->lru_prev = bcache_lru_tail;
+        if (bcache_lru_tail != NULL) {
+            bcache_lru_tail->lru_next = buf;
+        } else {
+            bcache_lru_head = buf;
+        }
+        bcache_lru_tail = buf;
+    }
+}
+
+/* bcache_hash_remove - takes a buffer out of its hash chain
+ *
+ * Inputs: buf - buffer of a cached block
+ * Outputs: None
+ * Side Effects: None
+ */
+static void bcache_hash_remove(bcache_buf_t* buf) {
+    bcache_buf_t** link = &bcache_hash[BCACHE_HASH(buf->dev, buf->block)]; /* link pointing at the current buffer */
+
+    while (*link != NULL && *link != buf) {
+        link = &(*link)->hash_next;
+    }
+    if (*link != NULL) {
+        *link = buf->hash_next;
+    }
+    buf->hash_next = NULL;
+}
+
+/* bcache_lookup - finds the buffer of a block
+ *
+ * Inputs: dev - device
+ *         block - block number on the device
+ * Outputs: the buffer, NULL if the block is not cached
+ * Side Effects: None
+ */
+static bcache_buf_t* bcache_lookup(blk_device_t* dev, uint32_t block) {
+    bcache_buf_t* buf;  /* buffer being checked */
+
+    for (buf = bcache_hash[BCACHE_HASH(dev, block)]; buf != NULL; buf = buf->hash_next) {
+        if (buf->dev == dev && buf->block == block) {
+            return buf;
+        }
+    }
+    return NULL;
+}
+
+/* bcache_hold - takes a reference to a buffer
+ *
+ * Inputs: buf - buffer
+ * Outputs: None
+ * Side Effects: takes the buffer off the LRU list
+ */
+static void bcache_hold(bcache_buf_t* buf) {
+    if (buf->ref_count++ == 0) {
+        bcache_lru_remove(buf);
+    }
+}
+
+/* bcache_put - drops a reference to a buffer
+ *
+ * Inputs: buf - held buffer
+ * Outputs: None
+ * Side Effects: puts the buffer on the LRU list once nobody holds it
+ */
+static void bcache_put(bcache_buf_t* buf) {
+    if (--buf->ref_count == 0) {
+        bcache_lru_add(buf, 0);
+    }
+}
+
+/* bcache_start_io - submits the bio of a buffer
+ *
+ * Inputs: buf - buffer of a cached block
+ *         write - write the block (1) or read it (0)
+ * Outputs: 0 for success, -1 if the device refused the bio
+ * Side Effects: sets BCACHE_IO until bcache_finish_io
+ */
+static int32_t bcache_start_io(bcache_buf_t* buf, uint32_t write) {
+    buf->bio.sector = buf->block * BCACHE_BLOCK_SECTORS;
+    buf->bio.num_sectors = BCACHE_BLOCK_SECTORS;
+    buf->bio.buf = buf->data;
+    buf->bio.write = write;
+    if (blk_submit(buf->dev, &buf->bio) == -1) {
+        return -1;
+    }
+
+    buf->flags |= BCACHE_IO;
+    return 0;
+}
+
+/* bcache_finish_io - takes the result of a finished bio
+ *      does nothing while the bio is in flight
+ *
+ * Inputs: buf - buffer
+ * Outputs: None
+ * Side Effects: a read makes the buffer valid, a failed write makes it dirty again
+ */
+static void bcache_finish_io(bcache_buf_t* buf) {
+    if (!(buf->flags & BCACHE_IO) || buf->bio.status == BLK_PENDING) {
+        return;
+    }
+
+    buf->flags &= ~BCACHE_IO;
+    if (buf->bio.write) {
+        if (buf->bio.status == BLK_ERROR) {
+            buf->flags |= BCACHE_DIRTY;
+        }
+    } else if (buf->bio.status == BLK_DONE) {
+        buf->flags |= BCACHE_VALID;
+    }
+}
+
+/* bcache_wait_io - waits until a buffer is not in flight
+ *      must be called with interrupts disabled, they are enabled while waiting if they were before
+ *
+ * Inputs: buf - held buffer
+ *         save - flags saved when interrupts were disabled
+ * Outputs: None
+ * Side Effects: may switch to another process while waiting
+ */
+static void bcache_wait_io(bcache_buf_t* buf, uint32_t save) {
+    while (buf->flags & BCACHE_IO) {
+        restore_flags(save);
+        blk_wait(buf->dev, &buf->bio);
+        cli();
+        bcache_finish_io(buf);
+    }
+}
+
+/* bcache_take - gets a buffer for a block that is not cached
+ *      reuses the least recently used clean buffer that is not in flight; dirty
+ *      buffers found on the way are written back and can be reused once the write is done
+ *      must be called with interrupts disabled
+ *
+ * Inputs: dev - device
+ *         block - block number on the device
+ * Outputs: held buffer without valid data, NULL if every buffer is held
+ * Side Effects: may evict a block, may wait for the device
+ */
+static bcache_buf_t* bcache_take(blk_device_t* dev, uint32_t block) {
+    bcache_buf_t* buf;  /* buffer being checked */
+    bcache_buf_t* next; /* newer buffer on the LRU list */
+    uint32_t tries;     /* waits for a buffer in flight */
+
+    for (tries = 0; tries < BCACHE_NUM_BUFS; tries++) {
+        for (buf = bcache_lru_head; buf != NULL; buf = next) {
+            next = buf->lru_next;
+            bcache_finish_io(buf);
+            if (buf->flags & BCACHE_IO) {
+                continue;
+            }
+            if (!(buf->flags & BCACHE_DIRTY)) {
+                break;
+            }
+
+            // write the block back and look further, the buffer is free once the write is done
+            buf->flags &= ~BCACHE_DIRTY;
+            if (bcache_start_io(buf, 1) == -1) {
+                buf->flags |= BCACHE_DIRTY;
+            } else {
+                bcache_stats.writebacks++;
+            }
+        }
+
+        // every unheld buffer is in flight, wait for the oldest one
+        if (buf == NULL) {
+            if (bcache_lru_head == NULL) {
+                return NULL;
+            }
+            blk_wait(bcache_lru_head->dev, &bcache_lru_head->bio);
+            continue;
+        }
+
+        bcache_lru_remove(buf);
+        if (buf->dev != NULL) {
+            bcache_hash_remove(buf);
+            bcache_stats.evictions++;
+        }
+
+        buf->dev = dev;
+        buf->block = block;
+        buf->flags = 0;
+        buf->ref_count = 1;
+        buf->hash_next = bcache_hash[BCACHE_HASH(dev, block)];
+        bcache_hash[BCACHE_HASH(dev, block)] = buf;
+        return buf;
+    }
+
+    return NULL;
+}
+
+/* bcache_drop - forgets the block of an unheld buffer that is not in flight
+ *
+ * Inputs: buf - buffer on the LRU list
+ * Outputs: None
+ * Side Effects: the buffer becomes the first to be reused
+ */
+static void bcache_drop(bcache_buf_t* buf) {
+    bcache_hash_remove(buf);
+    buf->dev = NULL;
+    buf->flags = 0;
+    bcache_lru_remove(buf);
+    bcache_lru_add(buf, 1);
+}
+
+/* init_bcache - buffer cache initialization
+ *
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: empties the cache, clears the counters
+ */
+void init_bcache(void) {
+    uint32_t i; /* loop index */
+
+    for (i = 0; i < BCACHE_HASH_SIZE; i++) {
+        bcache_hash[i] = NULL;
+    }
+
+    bcache_lru_head = NULL;
+    bcache_lru_tail = NULL;
+    for (i = 0; i < BCACHE_NUM_BUFS; i++) {
+        memset(&bcache_bufs[i], 0, sizeof(bcache_buf_t));
+        bcache_bufs[i].data = bcache_data[i];
+        bcache_lru_add(&bcache_bufs[i], 0);
+    }
+
+    memset(&bcache_stats, 0, sizeof(bcache_stats_t));
+}
+
+/* bcache_read - gets a block
+ *      a block being read ahead is waited for instead of read again
+ *
+ * Inputs: dev - device
+ *         block - block number on the device
+ * Outputs: held buffer with the block's data, NULL if the read failed or every buffer is held
+ * Side Effects: may evict a block, may switch to another process while waiting
+ */
+bcache_buf_t* bcache_read(blk_device_t* dev, uint32_t block) {
+    bcache_buf_t* buf;  /* buffer of the block */
+    uint32_t save;      /* variable to store flags */
+
+    cli_and_save(save);
+
+    buf = bcache_lookup(dev, block);
+    if (buf != NULL) {
+        bcache_stats.hits++;
+        if (buf->flags & BCACHE_AHEAD) {
+            bcache_stats.ahead_hits++;
+        }
+        bcache_hold(buf);
+    } else {
+        bcache_stats.misses++;
+        buf = bcache_take(dev, block);
+        if (buf == NULL) {
+            restore_flags(save);
+            return NULL;
+        }
+    }
+    buf->flags &= ~BCACHE_AHEAD;
+
+    // whoever finds the block neither valid nor in flight reads it
+    if (!(buf->flags & BCACHE_VALID)) {
+        if (!(buf->flags & BCACHE_IO)) {
+            bcache_start_io(buf, 0);
+        }
+        bcache_wait_io(buf, save);
+    }
+
+    if (!(buf->flags & BCACHE_VALID)) {
+        bcache_put(buf);
+        if (buf->ref_count == 0 && !(buf->flags & BCACHE_IO)) {
+            bcache_drop(buf);
+        }
+        buf = NULL;
+    }
+
+    restore_flags(save);
+    return buf;
+}
+
+/* bcache_zero - gets a block filled with 0s
+ *      for blocks that are about to be overwritten, the device is not read
+ *
+ * Inputs: dev - device
+ *         block - block number on the device
+ * Outputs: held dirty buffer, NULL if every buffer is held
+ * Side Effects: may evict a block
+ */
+bcache_buf_t* bcache_zero(blk_device_t* dev, uint32_t block) {
+    bcache_buf_t* buf;  /* buffer of the block */
+    uint32_t save;      /* variable to store flags */
+
+    cli_and_save(save);
+
+    buf = bcache_lookup(dev, block);
+    if (buf != NULL) {
+        bcache_hold(buf);
+    } else {
+        buf = bcache_take(dev, block);
+        if (buf == NULL) {
+            restore_flags(save);
+            return NULL;
+        }
+    }
+
+    // a read in flight would overwrite the 0s
+    bcache_wait_io(buf, save);
+    memset(buf->data, 0, BCACHE_BLOCK_SIZE);
+    buf->flags = BCACHE_VALID | BCACHE_DIRTY;
+
+    restore_flags(save);
+    return buf;
+}
+
+/* bcache_mark_dirty - marks a held buffer as changed
+ *
+ * Inputs: buf - held buffer
+ * Outputs: None
+ * Side Effects: the block is written back by bcache_sync or before it is evicted
+ */
+void bcache_mark_dirty(bcache_buf_t* buf) {
+    uint32_t save;  /* variable to store flags */
+
+    cli_and_save(save);
+    buf->flags |= BCACHE_DIRTY;
+    restore_flags(save);
+}
+
+/* bcache_release - releases a held buffer
+ *
+ * Inputs: buf - buffer from bcache_read or bcache_zero
+ * Outputs: None
+ * Side Effects: the buffer becomes the most recently used one once nobody holds it
+ */
+void bcache_release(bcache_buf_t* buf) {
+    uint32_t save;  /* variable to store flags */
+
+    cli_and_save(save);
+    bcache_put(buf);
+    restore_flags(save);
+}
+
+/* bcache_readahead - starts reading a block that is not cached
+ *
+ * Inputs: dev - device
+ *         block - block number on the device
+ * Outputs: None
+ * Side Effects: may evict a block
+ */
+void bcache_readahead(blk_device_t* dev, uint32_t block) {
+    bcache_buf_t* buf;  /* buffer of the block */
+    uint32_t save;      /* variable to store flags */
+
+    cli_and_save(save);
+
+    if (bcache_lookup(dev, block) != NULL) {
+        restore_flags(save);
+        return;
+    }
+
+    buf = bcache_take(dev, block);
+    if (buf == NULL) {
+        restore_flags(save);
+        return;
+    }
+
+    bcache_put(buf);
+    if (bcache_start_io(buf, 0) == -1) {
+        bcache_drop(buf);
+    } else {
+        buf->flags |= BCACHE_AHEAD;
+        bcache_stats.ahead_reads++;
+    }
+
+    restore_flags(save);
+}
+
+/* bcache_in_map - checks if a buffer holds one of the blocks of a bitmap
+ *
+ * Inputs: buf - buffer
+ *         map - one bit per block from first, NULL for every block
+ *         first - block of bit 0 of map
+ *         num - blocks map covers
+ * Outputs: 1 if the block of buf is in map, 0 otherwise
+ * Side Effects: None
+ */
+static uint32_t bcache_in_map(bcache_buf_t* buf, const uint32_t* map, uint32_t first, uint32_t num) {
+    if (map == NULL) {
+        return 1;
+    }
+    return buf->block >= first && buf->block - first < num && CHECK_FLAG(map[(buf->block - first) / 32], (buf->block - first) % 32);
+}
+
+/* bcache_sync - writes every dirty block of a device
+ *
+ * Inputs: dev - device
+ * Outputs: 0 for success, -1 if a write failed
+ * Side Effects: may switch to another process while waiting
+ */
+int32_t bcache_sync(blk_device_t* dev) {
+    return bcache_sync_blocks(dev, NULL, 0, 0);
+}
+
+/* bcache_sync_blocks - writes the dirty blocks of a device that are set in a bitmap
+ *      every write is submitted before the first wait so the device can merge them
+ *
+ * Inputs: dev - device
+ *         map - one bit per block from first, NULL for every block
+ *         first - block of bit 0 of map
+ *         num - blocks map covers
+ * Outputs: 0 for success, -1 if a write failed
+ * Side Effects: may switch to another process while waiting
+ */
+int32_t bcache_sync_blocks(blk_device_t* dev, const uint32_t* map, uint32_t first, uint32_t num) {
+    bcache_buf_t* buf;  /* buffer being checked */
+    uint32_t i;         /* loop index */
+    int32_t ret = 0;    /* return value */
+    uint32_t save;      /* variable to store flags */
+
+    cli_and_save(save);
+
+    for (i = 0; i < BCACHE_NUM_BUFS; i++) {
+        buf = &bcache_bufs[i];
+        if (buf->dev != dev || !bcache_in_map(buf, map, first, num) || !(buf->flags & BCACHE_DIRTY) || (buf->flags & BCACHE_IO)) {
+            continue;
+        }
+
+        buf->flags &= ~BCACHE_DIRTY;
+        if (bcache_start_io(buf, 1) == -1) {
+            buf->flags |= BCACHE_DIRTY;
+            ret = -1;
+        } else {
+            bcache_stats.writebacks++;
+        }
+    }
+
+    for (i = 0; i < BCACHE_NUM_BUFS; i++) {
+        buf = &bcache_bufs[i];
+        while (buf->dev == dev && bcache_in_map(buf, map, first, num) && (buf->flags & BCACHE_IO)) {
+            restore_flags(save);
+            blk_wait(dev, &buf->bio);
+            cli();
+            if (buf->bio.write && buf->bio.status == BLK_ERROR) {
+                ret = -1;
+            }
+            bcache_finish_io(buf);
+        }
+    }
+
+    restore_flags(save);
+    return ret;
+}
+
+/* bcache_forget - drops a block that is no longer used
+ *      its dirty data is thrown away, the block may be reused for something else
+ *
+ * Inputs: dev - device
+ *         block - block number on the device
+ * Outputs: None
+ * Side Effects: a buffer nobody uses becomes the first to be reused
+ */
+void bcache_forget(blk_device_t* dev, uint32_t block) {
+    bcache_buf_t* buf;  /* buffer of the block */
+    uint32_t save;      /* variable to store flags */
+
+    cli_and_save(save);
+
+    buf = bcache_lookup(dev, block);
+    if (buf != NULL) {
+        buf->flags &= ~BCACHE_DIRTY;
+        if (buf->ref_count == 0 && !(buf->flags & BCACHE_IO)) {
+            bcache_drop(buf);
+        }
+    }
+
+    restore_flags(save);
+}
+
+/* bcache_get_stats - copies the counters
+ *
+ * Inputs: stats - struct to fill
+ * Outputs: None
+ * Side Effects: None
+ */
+void bcache_get_stats(bcache_stats_t* stats) {
+    uint32_t save;  /* variable to store flags */
+
+    cli_and_save(save);
+    memcpy(stats, &bcache_stats, sizeof(bcache_stats_t));
+    restore_flags(save);
+}
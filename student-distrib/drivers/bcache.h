@@ -0,0 +1,80 @@
+/* bcache.h - buffer cache of device blocks
+ * vim:ts=4 noexpandtab
+ */
+#ifndef _BCACHE_H
+#define _BCACHE_H
+
+#include "../lib.h"
+#include "blkdev.h"
+
+#define BCACHE_BLOCK_SIZE       4096
+#define BCACHE_BLOCK_SECTORS    (BCACHE_BLOCK_SIZE / BLK_SECTOR_SIZE)
+#define BCACHE_NUM_BUFS         64      /* memory budget, 256 KB of cached blocks */
+#define BCACHE_HASH_SIZE        64      /* power of 2 so the hash can be masked */
+
+/* buffer flags */
+#define BCACHE_VALID            0x1     /* data holds the block */
+#define BCACHE_DIRTY            0x2     /* data is newer than the device */
+#define BCACHE_IO               0x4     /* the bio of the buffer is in flight */
+#define BCACHE_AHEAD            0x8     /* read ahead and not used yet */
+
+/*
+ * Every cached block lives in one buffer, found through a hash of
+ * (device, block). Buffers nobody holds sit on an LRU list, oldest first;
+ * a block that is not cached takes over the oldest buffer that is not in
+ * flight, writing it back first if it is dirty. Read-ahead submits reads
+ * without waiting, the first bcache_read of such a block waits for it.
+ */
+typedef struct bcache_buf_t {
+    blk_device_t* dev;              /* device of the block, NULL for an unused buffer */
+    uint32_t block;                 /* block number on the device */
+    uint32_t flags;                 /* BCACHE_* flags */
+    uint32_t ref_count;             /* holders, the buffer is on the LRU list when 0 */
+    blk_bio_t bio;                  /* transfer of the block */
+    uint8_t* data;                  /* BCACHE_BLOCK_SIZE bytes */
+    struct bcache_buf_t* hash_next; /* next buffer in the same hash chain */
+    struct bcache_buf_t* lru_prev;  /* older buffer on the LRU list */
+    struct bcache_buf_t* lru_next;  /* newer buffer on the LRU list */
+} bcache_buf_t;
+
+/* counters since init_bcache */
+typedef struct bcache_stats_t {
+    uint32_t hits;                  /* bcache_read found the block */
+    uint32_t misses;                /* bcache_read had to read the block */
+    uint32_t ahead_reads;           /* blocks read ahead */
+    uint32_t ahead_hits;            /* read-ahead blocks bcache_read used later */
+    uint32_t writebacks;            /* dirty blocks written to their device */
+    uint32_t evictions;             /* blocks dropped to make room */
+} bcache_stats_t;
+
+/* initializes the buffer cache */
+void init_bcache(void);
+
+/* gets a block, reading it from the device if it is not cached */
+bcache_buf_t* bcache_read(blk_device_t* dev, uint32_t block);
+
+/* gets a block filled with 0s and marked dirty, without reading it */
+bcache_buf_t* bcache_zero(blk_device_t* dev, uint32_t block);
+
+/* marks a held buffer as changed */
+void bcache_mark_dirty(bcache_buf_t* buf);
+
+/* releases a buffer returned by bcache_read or bcache_zero */
+void bcache_release(bcache_buf_t* buf);
+
+/* starts reading a block that is not cached, without waiting for it */
+void bcache_readahead(blk_device_t* dev, uint32_t block);
+
+/* writes every dirty block of a device */
+int32_t bcache_sync(blk_device_t* dev);
+
+/* writes the dirty blocks of a device that are set in a bitmap */
+int32_t bcache_sync_blocks(blk_device_t* dev, const uint32_t* map, uint32_t first, uint32_t num);
+
+/* drops a block that is no longer used, even if it is dirty */
+void bcache_forget(blk_device_t* dev, uint32_t block);
+
+/* copies the counters */
+void bcache_get_stats(bcache_stats_t* stats);
+
+#endif /* _BCACHE_H */
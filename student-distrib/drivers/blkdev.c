@@ -0,0 +1,357 @@
+#include "blkdev.h"
+#include "pit.h"
+
+#define EFLAGS_IF_BIT       9       /* interrupt enable flag in EFLAGS */
+#define BLK_RW_BATCH        8       /* bios blk_rw keeps queued at once */
+
+static blk_device_t* blk_devices[BLK_MAX_DEVICES];  /* registered devices */
+static uint32_t blk_num_devices;                    /* number of registered devices */
+
+static blk_request_t blk_requests[BLK_MAX_REQUESTS];    /* request pool */
+static blk_request_t* blk_free_requests;                /* unused requests */
+
+/* init_blkdev - block layer initialization
+ *
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: forgets every device, puts every request on the free list
+ */
+void init_blkdev(void) {
+    uint32_t i; /* loop index */
+
+    blk_num_devices = 0;
+    blk_free_requests = NULL;
+    for (i = 0; i < BLK_MAX_REQUESTS; i++) {
+        blk_requests[i].next = blk_free_requests;
+        blk_free_requests = &blk_requests[i];
+    }
+}
+
+/* blk_register - registers a block device
+ *
+ * Inputs: dev - device with its name, size, start and poll filled in
+ * Outputs: index of the device, -1 if there is no room
+ * Side Effects: empties the device's queue
+ */
+int32_t blk_register(blk_device_t* dev) {
+    if (blk_num_devices == BLK_MAX_DEVICES) {
+        return -1;
+    }
+
+    dev->queue = NULL;
+    dev->active = NULL;
+    dev->head_pos = 0;
+    dev->num_merges = 0;
+    dev->num_dispatches = 0;
+
+    blk_devices[blk_num_devices] = dev;
+    return blk_num_devices++;
+}
+
+/* blk_get - gets a registered block device
+ *
+ * Inputs: idx - index returned by blk_register
+ * Outputs: the device, NULL if there is none
+ * Side Effects: None
+ */
+blk_device_t* blk_get(uint32_t idx) {
+    return (idx < blk_num_devices) ? blk_devices[idx] : NULL;
+}
+
+/* blk_idle - waits a little for a device
+ *      the device is polled so waiting also works with interrupts disabled,
+ *      and the time slice is given up if interrupts were enabled and the
+ *      poll did not already finish what is being waited for
+ *
+ * Inputs: dev - device being waited on
+ *         bio - bio being waited for, NULL when waiting for a free request
+ * Outputs: None
+ * Side Effects: may finish requests, may switch to another process
+ */
+static void blk_idle(blk_device_t* dev, blk_bio_t* bio) {
+    uint32_t save;  /* variable to store flags */
+
+    cli_and_save(save);
+    dev->poll(dev);
+    restore_flags(save);
+
+    if (CHECK_FLAG(save, EFLAGS_IF_BIT) && ((bio != NULL) ? bio->status == BLK_PENDING : blk_free_requests == NULL)) {
+        schedule_yield();
+    }
+}
+
+/* blk_join - merges a queued request into the one right before it on the device
+ *
+ * Inputs: dev - device the requests are queued on
+ *         req - earlier request
+ *         next - request following req in the queue, may be NULL
+ * Outputs: None
+ * Side Effects: frees next if it was merged
+ */
+static void blk_join(blk_device_t* dev, blk_request_t* req, blk_request_t* next) {
+    if (next == NULL || next->write != req->write || req->sector + req->num_sectors != next->sector ||
+        req->num_sectors + next->num_sectors > BLK_MAX_SECTORS || req->num_bios + next->num_bios > BLK_MAX_BIOS) {
+        return;
+    }
+
+    req->last_bio->next = next->bios;
+    req->last_bio = next->last_bio;
+    req->num_sectors += next->num_sectors;
+    req->num_bios += next->num_bios;
+    req->next = next->next;
+
+    next->next = blk_free_requests;
+    blk_free_requests = next;
+    dev->num_merges++;
+}
+
+/* blk_merge - merges a bio into a queued request it continues or precedes
+ *      must be called with interrupts disabled
+ *
+ * Inputs: dev - device to queue on
+ *         bio - bio to merge
+ * Outputs: 1 if the bio was merged, 0 if it needs a request of its own
+ * Side Effects: may grow a request and join it with its neighbour
+ */
+static uint32_t blk_merge(blk_device_t* dev, blk_bio_t* bio) {
+    blk_request_t* prev = NULL; /* request before req */
+    blk_request_t* req;         /* request being checked */
+
+    for (req = dev->queue; req != NULL; prev = req, req = req->next) {
+        if (req->write != bio->write || req->num_sectors + bio->num_sectors > BLK_MAX_SECTORS ||
+            req->num_bios == BLK_MAX_BIOS) {
+            continue;
+        }
+
+        // back merge, the bio continues the request
+        if (req->sector + req->num_sectors == bio->sector) {
+            req->last_bio->next = bio;
+            req->last_bio = bio;
+            req->num_sectors += bio->num_sectors;
+            req->num_bios++;
+            dev->num_merges++;
+            blk_join(dev, req, req->next);
+            return 1;
+        }
+
+        // front merge, the request continues the bio
+        if (bio->sector + bio->num_sectors == req->sector) {
+            bio->next = req->bios;
+            req->bios = bio;
+            req->sector = bio->sector;
+            req->num_sectors += bio->num_sectors;
+            req->num_bios++;
+            dev->num_merges++;
+            if (prev != NULL) {
+                blk_join(dev, prev, req);
+            }
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* blk_finish - ends the active request of a device
+ *      must be called with interrupts disabled
+ *
+ * Inputs: dev - device
+ *         error - the transfer failed (1) or not (0)
+ * Outputs: None
+ * Side Effects: marks every bio of the request, frees the request
+ */
+static void blk_finish(blk_device_t* dev, uint32_t error) {
+    blk_request_t* req = dev->active;   /* finished request */
+    blk_bio_t* bio;                     /* current bio */
+    blk_bio_t* next;                    /* bio after the current one */
+
+    if (req == NULL) {
+        return;
+    }
+    dev->active = NULL;
+
+    // the owner may reuse a bio as soon as its status changes
+    for (bio = req->bios; bio != NULL; bio = next) {
+        next = bio->next;
+        bio->status = (error) ? BLK_ERROR : BLK_DONE;
+    }
+
+    req->next = blk_free_requests;
+    blk_free_requests = req;
+}
+
+/* blk_dispatch - starts the next request if the device is idle
+ *      picks requests in C-LOOK order: the first one at or past the last transfer,
+ *      or the lowest one once the head has passed them all
+ *      must be called with interrupts disabled
+ *
+ * Inputs: dev - device
+ * Outputs: None
+ * Side Effects: starts a transfer on the device
+ */
+static void blk_dispatch(blk_device_t* dev) {
+    blk_request_t* prev;    /* request before req */
+    blk_request_t* req;     /* request to start */
+
+    while (dev->active == NULL && dev->queue != NULL) {
+        for (prev = NULL, req = dev->queue; req != NULL && req->sector < dev->head_pos; prev = req, req = req->next);
+        if (req == NULL) {
+            prev = NULL;
+            req = dev->queue;
+        }
+
+        if (prev == NULL) {
+            dev->queue = req->next;
+        } else {
+            prev->next = req->next;
+        }
+        req->next = NULL;
+
+        dev->active = req;
+        dev->head_pos = req->sector + req->num_sectors;
+        dev->num_dispatches++;
+        if (dev->start(dev, req) == -1) {
+            blk_finish(dev, 1);
+        }
+    }
+}
+
+/* blk_complete - ends the active request and starts the next one
+ *      called by drivers, usually from their interrupt handler
+ *      must be called with interrupts disabled
+ *
+ * Inputs: dev - device
+ *         error - the transfer failed (1) or not (0)
+ * Outputs: None
+ * Side Effects: marks the bios of the request, may start a transfer
+ */
+void blk_complete(blk_device_t* dev, uint32_t error) {
+    blk_finish(dev, error);
+    blk_dispatch(dev);
+}
+
+/* blk_submit - queues a bio
+ *      the bio is merged into a queued request when it is contiguous with one,
+ *      otherwise it gets a request of its own in sector order
+ *
+ * Inputs: dev - device
+ *         bio - bio with its sector, num_sectors, buf and write filled in, must stay
+ *               untouched until it finishes
+ * Outputs: 0 for success, -1 for a bad bio
+ * Side Effects: may wait for a free request, may start a transfer
+ */
+int32_t blk_submit(blk_device_t* dev, blk_bio_t* bio) {
+    blk_request_t* req;     /* new request */
+    blk_request_t* prev;    /* request to insert after */
+    uint32_t i;             /* loop index */
+    uint32_t save;          /* variable to store flags */
+
+    if (dev == NULL || bio == NULL || bio->buf == NULL || bio->num_sectors == 0 || bio->num_sectors > BLK_MAX_SECTORS ||
+        bio->sector >= dev->num_sectors || bio->num_sectors > dev->num_sectors - bio->sector) {
+        return -1;
+    }
+    bio->status = BLK_PENDING;
+    bio->next = NULL;
+
+    cli_and_save(save);
+
+    if (blk_merge(dev, bio)) {
+        restore_flags(save);
+        return 0;
+    }
+
+    // every request is in flight, let the devices finish some
+    while (blk_free_requests == NULL) {
+        restore_flags(save);
+        for (i = 0; i < blk_num_devices; i++) {
+            blk_idle(blk_devices[i], NULL);
+        }
+        cli_and_save(save);
+    }
+    req = blk_free_requests;
+    blk_free_requests = req->next;
+
+    req->sector = bio->sector;
+    req->num_sectors = bio->num_sectors;
+    req->write = bio->write;
+    req->num_bios = 1;
+    req->bios = bio;
+    req->last_bio = bio;
+
+    // keep the queue sorted by sector
+    if (dev->queue == NULL || dev->queue->sector > req->sector) {
+        req->next = dev->queue;
+        dev->queue = req;
+    } else {
+        for (prev = dev->queue; prev->next != NULL && prev->next->sector <= req->sector; prev = prev->next);
+        req->next = prev->next;
+        prev->next = req;
+    }
+
+    blk_dispatch(dev);
+
+    restore_flags(save);
+    return 0;
+}
+
+/* blk_wait - waits for a bio to finish
+ *
+ * Inputs: dev - device the bio was submitted to
+ *         bio - submitted bio
+ * Outputs: 0 for success, -1 if the transfer failed
+ * Side Effects: may switch to another process while waiting
+ */
+int32_t blk_wait(blk_device_t* dev, blk_bio_t* bio) {
+    while (bio->status == BLK_PENDING) {
+        blk_idle(dev, bio);
+    }
+
+    return (bio->status == BLK_DONE) ? 0 : -1;
+}
+
+/* blk_rw - reads or writes sectors and waits for them
+ *      keeps several bios queued at once so the device can work through them back to back
+ *
+ * Inputs: dev - device
+ *         sector - first sector
+ *         num_sectors - number of sectors
+ *         buf - kernel buffer of num_sectors * BLK_SECTOR_SIZE bytes
+ *         write - write to the device (1) or read from it (0)
+ * Outputs: 0 for success, -1 if any transfer failed
+ * Side Effects: may switch to another process while waiting
+ */
+int32_t blk_rw(blk_device_t* dev, uint32_t sector, uint32_t num_sectors, uint8_t* buf, uint32_t write) {
+    blk_bio_t bios[BLK_RW_BATCH];   /* bios in flight */
+    uint32_t num_bios;              /* bios used in this batch */
+    uint32_t i;                     /* loop index */
+    int32_t ret = 0;                /* return value */
+
+    while (num_sectors != 0) {
+        for (num_bios = 0; num_bios < BLK_RW_BATCH && num_sectors != 0; num_bios++) {
+            bios[num_bios].sector = sector;
+            bios[num_bios].num_sectors = (num_sectors < BLK_MAX_SECTORS) ? num_sectors : BLK_MAX_SECTORS;
+            bios[num_bios].buf = buf;
+            bios[num_bios].write = write;
+            if (blk_submit(dev, &bios[num_bios]) == -1) {
+                ret = -1;
+                break;
+            }
+
+            sector += bios[num_bios].num_sectors;
+            buf += bios[num_bios].num_sectors * BLK_SECTOR_SIZE;
+            num_sectors -= bios[num_bios].num_sectors;
+        }
+
+        // every submitted bio has to finish before its stack slot goes away
+        for (i = 0; i < num_bios; i++) {
+            if (blk_wait(dev, &bios[i]) == -1) {
+                ret = -1;
+            }
+        }
+        if (ret == -1) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+/* blkdev.h - generic block devices and their request queues
+ * vim:ts=4 noexpandtab
+ */
+#ifndef _BLKDEV_H
+#define _BLKDEV_H
+
+#include "../lib.h"
+
+#define BLK_SECTOR_SIZE     512
+#define BLK_MAX_DEVICES     5       /* the RAM disks and the two ATA drives */
+#define BLK_MAX_REQUESTS    32      /* requests queued over all devices */
+#define BLK_MAX_SECTORS     256     /* sectors in one request, 128 KB */
+#define BLK_MAX_BIOS        16      /* bios merged into one request */
+
+/* bio states */
+#define BLK_PENDING         0
+#define BLK_DONE            1
+#define BLK_ERROR           2
+
+/*
+ * A bio is one caller's transfer of contiguous sectors to or from one
+ * kernel buffer. Bios are queued as requests sorted by sector; a bio that
+ * continues a queued request in the same direction is merged into it, so
+ * the device sees one larger transfer. Requests are dispatched in C-LOOK
+ * order: upwards from the last sector transferred, then back to the lowest.
+ */
+typedef struct blk_bio_t {
+    uint32_t sector;                /* first sector */
+    uint32_t num_sectors;           /* sectors to transfer, 1 to BLK_MAX_SECTORS */
+    uint8_t* buf;                   /* kernel buffer of num_sectors * BLK_SECTOR_SIZE bytes */
+    uint32_t write;                 /* write to the device (1) or read from it (0) */
+    volatile uint32_t status;       /* BLK_PENDING until the device finishes it */
+    struct blk_bio_t* next;         /* next bio of the same request, in sector order */
+} blk_bio_t;
+
+/* one transfer the device carries out, made of one or more bios */
+typedef struct blk_request_t {
+    uint32_t sector;                /* first sector */
+    uint32_t num_sectors;           /* sectors of every bio together */
+    uint32_t write;                 /* direction shared by every bio */
+    uint32_t num_bios;              /* bios in the list */
+    blk_bio_t* bios;                /* first bio */
+    blk_bio_t* last_bio;            /* last bio, for back merges */
+    struct blk_request_t* next;     /* next request in the queue or the free list */
+} blk_request_t;
+
+/* a block device, filled in by its driver and registered with blk_register */
+typedef struct blk_device_t {
+    char name[8];                   /* device name, such as "hda" */
+    uint32_t num_sectors;           /* device size */
+    /* starts a request, the driver calls blk_complete when it is done; interrupts are disabled */
+    int32_t (*start)(struct blk_device_t* dev, blk_request_t* req);
+    /* checks the device for a finished request without waiting for its interrupt */
+    void (*poll)(struct blk_device_t* dev);
+    void* driver_data;              /* driver state of the device */
+
+    /* request queue, owned by the block layer */
+    blk_request_t* queue;           /* waiting requests sorted by sector */
+    blk_request_t* active;          /* request the device is working on */
+    uint32_t head_pos;              /* sector after the last dispatched request */
+    uint32_t num_merges;            /* bios merged into a queued request */
+    uint32_t num_dispatches;        /* requests started on the device */
+} blk_device_t;
+
+/* initializes the block layer */
+void init_blkdev(void);
+
+/* registers a device filled in by a driver */
+int32_t blk_register(blk_device_t* dev);
+
+/* gets a registered device */
+blk_device_t* blk_get(uint32_t idx);
+
+/* queues a bio without waiting for it */
+int32_t blk_submit(blk_device_t* dev, blk_bio_t* bio);
+
+/* waits for a submitted bio to finish */
+int32_t blk_wait(blk_device_t* dev, blk_bio_t* bio);
+
+/* reads or writes sectors and waits for them */
+int32_t blk_rw(blk_device_t* dev, uint32_t sector, uint32_t num_sectors, uint8_t* buf, uint32_t write);
+
+/* called by a driver when the active request is done, interrupts must be disabled */
+void blk_complete(blk_device_t* dev, uint32_t error);
+
+#endif /* _BLKDEV_H */
@@ -1,5 +1,12 @@
 #include "fsys.h"
+#include "journal.h"
+#include "blkdev.h"
+#include "bcache.h"
+#include "lz4.h"
+#include "pit.h"
 #include "../process.h"
+#include "../page.h"
+#include "../vfs.h"
 
 extern pcb_t* current_PCB;
 
@@ -8,7 +15,9 @@ fops_jumptable_t file_jmptable = {
     file_read,
     file_write,
     file_open,
-    file_close
+    file_close,
+    NULL,
+    NULL
 };
 
 /* file operations jumptable for directories */
@@ -16,196 +25,2029 @@ fops_jumptable_t directory_jmptable = {
     directory_read,
     directory_write,
     directory_open,
-    directory_close
+    directory_close,
+    NULL,
+    NULL
 };
 
-/* important addresses */
-static uint32_t disk_mem_base_addr;     /* base address of the whole disk */
-static uint32_t file_dir_arr_base_addr; /* base address of the directory table within boot block */
-static uint32_t inodes_arr_base_addr;   /* base address of inodes array */
+/* file operations jumptable for the rtc, from its driver */
+extern fops_jumptable_t rtc_jmptable;
 
-/* structs */
-static boot_dentry_t* boot_block;   // 0th directory block containing the number of inodes, dentries, and datablocks
-static dentry_t* file_dir_arr;      // dentry array of length 63 for the directory 
-static inode_t* inodes_arr;         // inode array of dynamic length
+/* operations the VFS uses on every mounted image, jumptables are indexed by file type */
+static vfs_ops_t fsys_vfs_ops = {
+    fsys_lookup,
+    fsys_check_dir,
+    fsys_stat,
+    fsys_read_inode,
+    fsys_block_addr,
+    fsys_create,
+    fsys_mkdir,
+    fsys_unlink,
+    { &rtc_jmptable, &directory_jmptable, &file_jmptable }
+};
+
+/* name hash index of one directory, chains hold dentry indices in directory order */
+typedef struct dir_index_t {
+    uint32_t valid;                         // the index matches the directory (1) or the slot is free (0)
+    uint32_t dir;                           // directory inode the index was built for
+    uint32_t last_use;                      // dir_index_clock at the last lookup, for LRU replacement
+    uint32_t num_entries;                   // dentries in the directory when the index was built
+    uint32_t name_hash[DIR_MAX_ENTRIES];    // precomputed hash of each dentry name
+    uint16_t heads[DIR_HASH_SIZE];          // first dentry index of each chain
+    uint16_t next[DIR_MAX_ENTRIES];         // next dentry index in the same chain
+} dir_index_t;
+
+/* state of one mounted image */
+typedef struct fsys_sb_t {
+    vfs_sb_t vfs;                   // what the VFS sees of the image, fs_data points back here
+
+    /* important addresses */
+    uint32_t disk_mem_base_addr;     // base address of the whole disk
+    uint32_t file_dir_arr_base_addr; // base address of the directory table within boot block
+    uint32_t inodes_arr_base_addr;   // base address of inodes array
+
+    /* structs */
+    boot_dentry_t* boot_block;      // 0th directory block containing the number of inodes, dentries, and datablocks
+    dentry_t* file_dir_arr;         // dentry array of length 63 for the directory
+    inode_t* inodes_arr;            // inode array of dynamic length
+
+    /* slot 0 always holds the root index, the others cache recently used subdirectories */
+    dir_index_t dir_indexes[DIR_INDEX_SLOTS];
+    uint32_t dir_index_clock;
+
+    uint32_t dir_inode_map[MAX_INODES / 32];    // one bit per inode, set when a reachable directory uses it
+    uint32_t inode_bad_map[MAX_INODES / 32];    // one bit per inode, set when the inode was found bad at mount
+
+    /* allocation bitmaps, rebuilt from the directory at mount so they never need journaling */
+    uint32_t inode_used_map[MAX_INODES / 32];   // one bit per inode, set when a dentry uses it
+    uint32_t dblock_used_map[MAX_DBLOCKS / 32]; // one bit per data block, set when a file or the journal uses it
+
+    uint32_t writable;              // the image has a journal (1) or is read-only (0)
+    uint32_t writing;               // a file write is between its journal_begin and commit (1) or not (0)
+    blk_device_t* dev;              // device file data goes through the buffer cache to, NULL for an image resident in memory
+    journal_t journal;              // journal of the image, valid when writable
+
+    /* for an image on a device, memory only holds the metadata and mapped blocks */
+    uint32_t dblock_mem_map[MAX_DBLOCKS / 32];      // one bit per data block, set when its copy in memory is current
+    uint32_t dblock_dirty_map[MAX_DBLOCKS / 32];    // one bit per data block, set when it was changed in memory but not on the device
+    uint32_t dblock_write_map[MAX_DBLOCKS / 32];    // one bit per data block, set when the current file write changed it in the cache
+} fsys_sb_t;
+
+/* mounted images, the first one is what read_dentry_by_name and read_data look at */
+static fsys_sb_t fsys_sbs[FSYS_MAX_IMAGES];
+static uint32_t fsys_num_sbs;
+
+/* directories waiting to be scanned while the free maps are built */
+static uint16_t dir_scan_queue[MAX_INODES];
+
+/* data blocks of the file being unlinked, to find mappings of it */
+static uint32_t unlink_dblock_map[MAX_DBLOCKS / 32];
+
+/* one decompressed block of a compressed file */
+typedef struct zcache_slot_t {
+    uint32_t valid;                 // data holds the block (1) or the slot is free (0)
+    fsys_sb_t* sb;                  // image holding the file
+    uint32_t inode;                 // inode of the file
+    uint32_t block;                 // block index within the file
+    uint32_t last_use;              // zcache_clock at the last use, for LRU replacement
+    uint8_t data[DISK_BLOCK_SIZE];  // decompressed bytes
+} zcache_slot_t;
+
+static zcache_slot_t zcache_slots[FSYS_ZCACHE_SLOTS];
+static uint32_t zcache_clock;
+static uint8_t zcache_packed[DISK_BLOCK_SIZE];      // packed bytes of the block being decompressed
+
+static uint32_t fsys_map_epoch = 1; /* changes whenever blocks are freed, older map caches are not used */
+
+/* bitmap helpers */
+#define MAP_TEST(map, i)    CHECK_FLAG((map)[(i) / 32], (i) % 32)
+#define MAP_SET(map, i)     ((map)[(i) / 32] |= 1 << ((i) % 32))
+#define MAP_CLEAR(map, i)   ((map)[(i) / 32] &= ~(1 << ((i) % 32)))
+
+/* image block numbers of metadata, the journal works on whole image blocks */
+#define BOOT_BLOCK_NUM          0
+#define INODE_BLOCK_NUM(i)      (1 + (i))
+#define DBLOCK_NUM(sb, d)       (1 + (sb)->boot_block->num_inodes + (d))
+
+/* address of a data block in the image */
+#define DBLOCK_ADDR(sb, d)      ((sb)->inodes_arr_base_addr + ((sb)->boot_block->num_inodes + (d))*DISK_BLOCK_SIZE)
+
+/* fsys_name_hash - hashes a file name
+ *      FNV-1a over at most FILENAME_LEN characters, names that long have no NUL
+ * 
+ * Inputs: name - file name
+ * Outputs: 32-bit hash of the name
+ * Side Effects: None
+ */
+static uint32_t fsys_name_hash(const char* name) {
+    uint32_t hash = 2166136261U;    /* FNV offset basis */
+    uint32_t i;                     /* loop index */
+
+    for (i = 0; i < FILENAME_LEN && name[i] != '\0'; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619;           /* FNV prime */
+    }
+
+    return hash;
+}
+
+/* fsys_indirect_entry - reads one index of an indirect block
+ *      indirect blocks are metadata, read from the image like directory blocks
+ *
+ * Inputs: sb - mounted image
+ *         dblock - data block of the indirect block
+ *         idx - entry index, below INDIRECT_ENTRIES
+ * Outputs: the index stored there, FSYS_NO_BLOCK if dblock is not a data block
+ * Side Effects: None
+ */
+static uint32_t fsys_indirect_entry(fsys_sb_t* sb, uint32_t dblock, uint32_t idx) {
+    if (dblock >= sb->boot_block->num_dblocks) {
+        return FSYS_NO_BLOCK;
+    }
+    return ((uint32_t*)DBLOCK_ADDR(sb, dblock))[idx];
+}
+
+/* fsys_bmap - finds the data block of a file block
+ *      blocks past the direct indices are looked up in the indirect block, then in one of
+ *      the indirect blocks the double-indirect block lists; the cache keeps the last
+ *      indirect block so the next block of a sequential read is found in one step
+ *
+ * Inputs: sb - mounted image
+ *         inode - inode in the image or its journal copy, not compressed
+ *         block - block index within the file, must be inside the file size
+ *         cache - map cache of the file descriptor, NULL for none
+ * Outputs: data block index, FSYS_NO_BLOCK if an indirect block is not a data block
+ * Side Effects: may refill the cache
+ */
+static uint32_t fsys_bmap(fsys_sb_t* sb, inode_t* inode, uint32_t block, fsys_map_cache_t* cache) {
+    uint32_t leaf;      /* indirect block holding the index of block */
+    uint32_t first;     /* first file block leaf maps */
+
+    if (block < INODE_DIRECT_BLOCKS) {
+        return inode->block_idx_arr[block];
+    }
+
+    if (cache != NULL && cache->epoch == fsys_map_epoch && block >= cache->first && block - cache->first < INDIRECT_ENTRIES) {
+        return fsys_indirect_entry(sb, cache->dblock, block - cache->first);
+    }
+
+    if (block < INODE_DIRECT_BLOCKS + INDIRECT_ENTRIES) {
+        leaf = inode->indirect;
+        first = INODE_DIRECT_BLOCKS;
+    } else {
+        first = block - INODE_DIRECT_BLOCKS - INDIRECT_ENTRIES;
+        leaf = fsys_indirect_entry(sb, inode->double_indirect, first / INDIRECT_ENTRIES);
+        first = block - first % INDIRECT_ENTRIES;
+    }
+
+    if (cache != NULL && leaf < sb->boot_block->num_dblocks) {
+        cache->epoch = fsys_map_epoch;
+        cache->first = first;
+        cache->dblock = leaf;
+    }
+    return fsys_indirect_entry(sb, leaf, block - first);
+}
+
+/* fsys_is_dir - checks if an inode is a directory
+ *
+ * Inputs: sb - mounted image
+ *         inode - inode number
+ * Outputs: 1 for the root or a directory reachable from it, 0 otherwise
+ * Side Effects: None
+ */
+static uint32_t fsys_is_dir(fsys_sb_t* sb, uint32_t inode) {
+    return inode == FSYS_ROOT_DIR || (inode < MAX_INODES && MAP_TEST(sb->dir_inode_map, inode));
+}
+
+/* fsys_dir_size - number of dentries in a directory
+ *
+ * Inputs: sb - mounted image
+ *         dir - directory inode
+ * Outputs: number of dentries, 0 if dir is not a directory
+ * Side Effects: None
+ */
+static uint32_t fsys_dir_size(fsys_sb_t* sb, uint32_t dir) {
+    uint32_t num_entries;   /* dentries the directory size covers */
+
+    if (dir == FSYS_ROOT_DIR) {
+        return (sb->boot_block->num_dir_entries < MAX_DENTRIES) ? sb->boot_block->num_dir_entries : MAX_DENTRIES;
+    }
+    if (dir >= sb->boot_block->num_inodes || dir >= MAX_INODES || MAP_TEST(sb->inode_bad_map, dir)) {
+        return 0;
+    }
+
+    num_entries = sb->inodes_arr[dir].file_size / DENTRY_SIZE;
+    return (num_entries < DIR_MAX_ENTRIES) ? num_entries : DIR_MAX_ENTRIES;
+}
+
+/* fsys_dir_entry - gets a dentry of a directory
+ *      root dentries live in the boot block, subdirectory dentries are packed in the data blocks
+ *
+ * Inputs: sb - mounted image
+ *         dir - directory inode
+ *         idx - dentry index, must be below fsys_dir_size(sb, dir)
+ * Outputs: pointer to the dentry in the image
+ * Side Effects: None
+ */
+static dentry_t* fsys_dir_entry(fsys_sb_t* sb, uint32_t dir, uint32_t idx) {
+    if (dir == FSYS_ROOT_DIR) {
+        return &sb->file_dir_arr[idx];
+    }
+    return (dentry_t*)DBLOCK_ADDR(sb, sb->inodes_arr[dir].block_idx_arr[idx / DENTRIES_PER_BLOCK]) + idx % DENTRIES_PER_BLOCK;
+}
+
+/* fsys_index_build - builds the name hash index of a directory
+ *      goes backwards so each chain keeps directory order and the first duplicate wins
+ *
+ * Inputs: sb - mounted image
+ *         index - index slot to fill
+ *         dir - directory inode
+ * Outputs: None
+ * Side Effects: overwrites the slot
+ */
+static void fsys_index_build(fsys_sb_t* sb, dir_index_t* index, uint32_t dir) {
+    uint32_t i;     /* loop index */
+    uint32_t slot;  /* hash chain of a dentry */
+
+    for (i = 0; i < DIR_HASH_SIZE; i++) {
+        index->heads[i] = DIR_HASH_END;
+    }
+
+    index->valid = 1;
+    index->dir = dir;
+    index->num_entries = fsys_dir_size(sb, dir);
+    i = index->num_entries;
+    while (i-- > 0) {
+        index->name_hash[i] = fsys_name_hash(fsys_dir_entry(sb, dir, i)->file_name);
+        slot = index->name_hash[i] & (DIR_HASH_SIZE - 1);
+        index->next[i] = index->heads[slot];
+        index->heads[slot] = i;
+    }
+}
+
+/* fsys_index_get - gets the name hash index of a directory
+ *      the root index is pinned, a subdirectory index is built on first use
+ *      into the least recently used slot
+ *      must be called with interrupts disabled
+ *
+ * Inputs: sb - mounted image
+ *         dir - directory inode
+ * Outputs: index of the directory
+ * Side Effects: may replace a cached index
+ */
+static dir_index_t* fsys_index_get(fsys_sb_t* sb, uint32_t dir) {
+    dir_index_t* victim = &sb->dir_indexes[1];  /* slot to replace if dir is not cached */
+    uint32_t i;                             /* loop index */
+
+    if (dir == FSYS_ROOT_DIR) {
+        return &sb->dir_indexes[0];
+    }
+
+    for (i = 1; i < DIR_INDEX_SLOTS; i++) {
+        if (sb->dir_indexes[i].valid && sb->dir_indexes[i].dir == dir) {
+            sb->dir_indexes[i].last_use = ++sb->dir_index_clock;
+            return &sb->dir_indexes[i];
+        }
+        if (!sb->dir_indexes[i].valid || (victim->valid && sb->dir_indexes[i].last_use < victim->last_use)) {
+            victim = &sb->dir_indexes[i];
+        }
+    }
+
+    fsys_index_build(sb, victim, dir);
+    victim->last_use = ++sb->dir_index_clock;
+    return victim;
+}
+
+/* fsys_index_drop - forgets the index of a directory that changed
+ *
+ * Inputs: sb - mounted image
+ *         dir - directory inode
+ * Outputs: None
+ * Side Effects: rebuilds the root index, or frees the slot of a subdirectory
+ */
+static void fsys_index_drop(fsys_sb_t* sb, uint32_t dir) {
+    uint32_t i; /* loop index */
+
+    if (dir == FSYS_ROOT_DIR) {
+        fsys_index_build(sb, &sb->dir_indexes[0], FSYS_ROOT_DIR);
+        return;
+    }
+
+    for (i = 1; i < DIR_INDEX_SLOTS; i++) {
+        if (sb->dir_indexes[i].dir == dir) {
+            sb->dir_indexes[i].valid = 0;
+        }
+    }
+}
+
+/* fsys_dir_lookup - finds a name in a directory
+ *      only dentries in the name's hash chain with the same hash get compared
+ *
+ * Inputs: sb - mounted image
+ *         dir - directory inode
+ *         name - file name
+ * Outputs: dentry index within the directory, -1 if the name is not found
+ * Side Effects: may replace a cached index
+ */
+static int32_t fsys_dir_lookup(fsys_sb_t* sb, uint32_t dir, const char* name) {
+    uint32_t hash = fsys_name_hash(name);   /* hash of the name to find */
+    dir_index_t* index;                     /* index of the directory */
+    uint32_t i;                             /* dentry index in the chain */
+    int32_t found = -1;                     /* dentry index of the name */
+    uint32_t save;                          /* variable to store flags */
+
+    if (!fsys_is_dir(sb, dir)) {
+        return -1;
+    }
+
+    cli_and_save(save);
+
+    // walk the name's hash chain
+    index = fsys_index_get(sb, dir);
+    for (i = index->heads[hash & (DIR_HASH_SIZE - 1)]; i != DIR_HASH_END; i = index->next[i]) {
+        if (index->name_hash[i] == hash && strncmp(fsys_dir_entry(sb, dir, i)->file_name, (int8_t*)name, FILENAME_LEN) == 0) {
+            found = i;
+            break;
+        }
+    }
+
+    restore_flags(save);
+    return found;
+}
+
+/* fsys_num_dblocks - number of data blocks the allocator can hand out
+ *
+ * Inputs: sb - mounted image
+ * Outputs: data blocks covered by the free-block bitmap
+ * Side Effects: None
+ */
+static uint32_t fsys_num_dblocks(fsys_sb_t* sb) {
+    return (sb->boot_block->num_dblocks < MAX_DBLOCKS) ? sb->boot_block->num_dblocks : MAX_DBLOCKS;
+}
+
+/* fsys_file_blocks - number of blocks a file size covers
+ *
+ * Inputs: inode - inode in the image or its journal copy
+ * Outputs: number of file blocks
+ * Side Effects: None
+ */
+static uint32_t fsys_file_blocks(inode_t* inode) {
+    return inode->file_size / DISK_BLOCK_SIZE + (inode->file_size % DISK_BLOCK_SIZE != 0);
+}
+
+/* fsys_inode_blocks - number of data blocks an inode uses
+ *      the blocks its file size covers followed by the indirect blocks mapping them,
+ *      or the run of a compressed inode
+ *
+ * Inputs: sb - mounted image
+ *         inode - inode number, must be in range
+ * Outputs: number of blocks, at most MAX_DBLOCKS
+ * Side Effects: None
+ */
+static uint32_t fsys_inode_blocks(fsys_sb_t* sb, uint32_t inode) {
+    uint32_t num_used;  /* number of blocks */
+
+    if (sb->inodes_arr[inode].flags & INODE_COMPRESSED) {
+        num_used = sb->inodes_arr[inode].block_idx_arr[ZINODE_NUM_DBLOCKS];
+        return (num_used < MAX_DBLOCKS) ? num_used : MAX_DBLOCKS;
+    }
+
+    num_used = fsys_file_blocks(&sb->inodes_arr[inode]);
+    if (num_used > INODE_DIRECT_BLOCKS + INDIRECT_ENTRIES) {
+        // the double-indirect block and the indirect blocks it lists
+        num_used += 1 + (num_used - INODE_DIRECT_BLOCKS - INDIRECT_ENTRIES + INDIRECT_ENTRIES - 1) / INDIRECT_ENTRIES;
+    }
+    if (num_used > INODE_DIRECT_BLOCKS) {
+        num_used++;
+    }
+    return (num_used < MAX_DBLOCKS) ? num_used : MAX_DBLOCKS;
+}
+
+/* fsys_inode_dblock - gets one of the data blocks an inode uses
+ *      file blocks come first, then the indirect block, the double-indirect block
+ *      and the indirect blocks it lists
+ *
+ * Inputs: sb - mounted image
+ *         inode - inode number, must be in range
+ *         j - index below fsys_inode_blocks(sb, inode)
+ * Outputs: data block index, FSYS_NO_BLOCK if an indirect block on the way is not a data block
+ * Side Effects: None
+ */
+static uint32_t fsys_inode_dblock(fsys_sb_t* sb, uint32_t inode, uint32_t j) {
+    inode_t* curr_inode = &sb->inodes_arr[inode];                   /* pointer to inode in disk */
+    uint32_t num_blocks = fsys_file_blocks(curr_inode);         /* file blocks */
+
+    if (curr_inode->flags & INODE_COMPRESSED) {
+        return curr_inode->block_idx_arr[ZINODE_DBLOCK] + j;
+    }
+    if (j < num_blocks) {
+        return fsys_bmap(sb, curr_inode, j, NULL);
+    }
+
+    j -= num_blocks;
+    if (j == 0) {
+        return curr_inode->indirect;
+    }
+    if (j == 1) {
+        return curr_inode->double_indirect;
+    }
+    return fsys_indirect_entry(sb, curr_inode->double_indirect, j - 2);
+}
+
+/* fsys_free_dblock - returns a data block of a file to the allocator
+ *
+ * Inputs: sb - mounted image
+ *         dblock - data block index, must be below fsys_num_dblocks(sb)
+ * Outputs: None
+ * Side Effects: drops the block from the buffer cache
+ */
+static void fsys_free_dblock(fsys_sb_t* sb, uint32_t dblock) {
+    if (sb->dev != NULL) {
+        bcache_forget(sb->dev, DBLOCK_NUM(sb, dblock));
+        MAP_CLEAR(sb->dblock_mem_map, dblock);
+        MAP_CLEAR(sb->dblock_dirty_map, dblock);
+    }
+    MAP_CLEAR(sb->dblock_used_map, dblock);
+}
+
+/* fsys_sync_block - writes an image block from memory to the device of the image
+ *
+ * Inputs: sb - mounted image
+ *         block - image block number
+ * Outputs: 0 for success or an image resident in memory, -1 if the write failed
+ * Side Effects: writes the device
+ */
+static int32_t fsys_sync_block(fsys_sb_t* sb, uint32_t block) {
+    if (sb->dev == NULL) {
+        return 0;
+    }
+    return blk_rw(sb->dev, block*BCACHE_BLOCK_SECTORS, BCACHE_BLOCK_SECTORS, (uint8_t*)(sb->disk_mem_base_addr + block*DISK_BLOCK_SIZE), 1);
+}
+
+/* fsys_meta_written - notes a data block of metadata that was written in place in memory
+ *      such as a new directory block or an indirect block, fsys_sync_meta writes it out
+ *
+ * Inputs: sb - mounted image
+ *         dblock - data block index, must be below fsys_num_dblocks(sb)
+ * Outputs: None
+ * Side Effects: marks the block current in memory and changed
+ */
+static void fsys_meta_written(fsys_sb_t* sb, uint32_t dblock) {
+    if (sb->dev != NULL) {
+        MAP_SET(sb->dblock_mem_map, dblock);
+        MAP_SET(sb->dblock_dirty_map, dblock);
+    }
+}
+
+/* fsys_sync_meta - writes the metadata blocks changed in place to the device
+ *      called before a journal commit, so the committed inodes never point at blocks
+ *      the device does not have yet
+ *
+ * Inputs: sb - mounted image
+ * Outputs: 0 for success, -1 if a write failed
+ * Side Effects: writes the device, clears the written blocks from sb->dblock_dirty_map
+ */
+static int32_t fsys_sync_meta(fsys_sb_t* sb) {
+    uint32_t i; /* loop index */
+
+    if (sb->dev == NULL) {
+        return 0;
+    }
+
+    for (i = 0; i < fsys_num_dblocks(sb); i++) {
+        if (MAP_TEST(sb->dblock_dirty_map, i)) {
+            if (fsys_sync_block(sb, DBLOCK_NUM(sb, i)) == -1) {
+                return -1;
+            }
+            MAP_CLEAR(sb->dblock_dirty_map, i);
+        }
+    }
+    return 0;
+}
+
+/* fsys_wait_writer - waits for the file write in progress on an image to commit
+ *      file_write enables interrupts while its blocks reach the device, nothing else may
+ *      start a journal transaction on the image until it is done
+ *
+ * Inputs: sb - mounted image
+ *         save - flags saved by the caller, which has interrupts disabled
+ * Outputs: None
+ * Side Effects: may switch to another process, returns with interrupts disabled
+ */
+static void fsys_wait_writer(fsys_sb_t* sb, uint32_t save) {
+    while (sb->writing) {
+        restore_flags(save);
+        schedule_yield();
+        cli();
+    }
+}
+
+/* fsys_load_dblock - reads a data block from the device into memory
+ *
+ * Inputs: sb - image on a device
+ *         dblock - data block index, ignored if it is not a data block or already in memory
+ * Outputs: 0 for success, -1 if the read failed
+ * Side Effects: marks the block current in memory
+ */
+static int32_t fsys_load_dblock(fsys_sb_t* sb, uint32_t dblock) {
+    if (dblock >= fsys_num_dblocks(sb) || MAP_TEST(sb->dblock_mem_map, dblock)) {
+        return 0;
+    }
+    if (blk_rw(sb->dev, DBLOCK_NUM(sb, dblock)*BCACHE_BLOCK_SECTORS, BCACHE_BLOCK_SECTORS, (uint8_t*)DBLOCK_ADDR(sb, dblock), 0) == -1) {
+        return -1;
+    }
+    MAP_SET(sb->dblock_mem_map, dblock);
+    return 0;
+}
+
+/* fsys_load_meta - reads the metadata kept in data blocks of an image on a device
+ *      indirect blocks and the blocks of every directory reachable from the root are kept
+ *      in memory and written through from then on, file data is read through the buffer cache
+ *      must run after the journal replay, which can change the inodes
+ *
+ * Inputs: sb - image on a device with its boot block and inodes in memory
+ * Outputs: 0 for success, -1 if a read failed
+ * Side Effects: fills data blocks in memory, uses sb->dir_inode_map and dir_scan_queue as scratch
+ */
+static int32_t fsys_load_meta(fsys_sb_t* sb) {
+    uint32_t i;             /* loop index */
+    uint32_t j;             /* block index within an inode */
+    uint32_t num_used;      /* blocks of the current inode */
+    uint32_t head = 0;      /* next directory to scan in the queue */
+    uint32_t tail = 0;      /* end of the queue */
+    uint32_t dir;           /* directory being scanned */
+    uint32_t num_entries;   /* dentries in the directory */
+    dentry_t* entry;        /* current dentry */
+    inode_t* curr_inode;    /* inode of the current file */
+
+    for (i = 0; i < MAX_INODES / 32; i++) {
+        sb->inode_bad_map[i] = 0;
+        sb->dir_inode_map[i] = 0;
+    }
+
+    // indirect blocks come after the file blocks, the double-indirect block before the blocks it lists
+    for (i = 0; i < sb->boot_block->num_inodes && i < MAX_INODES; i++) {
+        curr_inode = &sb->inodes_arr[i];
+        if ((curr_inode->flags & INODE_COMPRESSED) || fsys_file_blocks(curr_inode) > sb->boot_block->num_dblocks) {
+            continue;
+        }
+        num_used = fsys_inode_blocks(sb, i);
+        for (j = fsys_file_blocks(curr_inode); j < num_used; j++) {
+            if (fsys_load_dblock(sb, fsys_inode_dblock(sb, i, j)) == -1) {
+                return -1;
+            }
+        }
+    }
+
+    // directory blocks, walked like fsys_build_free_maps walks them
+    dir_scan_queue[tail++] = FSYS_ROOT_DIR;
+    while (head < tail) {
+        dir = dir_scan_queue[head++];
+        num_entries = fsys_dir_size(sb, dir);
+
+        for (i = 0; i < num_entries; i++) {
+            entry = fsys_dir_entry(sb, dir, i);
+            if (entry->file_type != DIRECTORY_FILE_TYPE || entry->inode_idx >= sb->boot_block->num_inodes ||
+                entry->inode_idx >= MAX_INODES || fsys_is_dir(sb, entry->inode_idx)) {
+                continue;
+            }
+            curr_inode = &sb->inodes_arr[entry->inode_idx];
+            if (curr_inode->flags & INODE_COMPRESSED) {
+                continue;
+            }
+
+            // a directory with a block outside of the image is marked bad later, its dentries are not read
+            num_used = (fsys_dir_size(sb, entry->inode_idx) + DENTRIES_PER_BLOCK - 1) / DENTRIES_PER_BLOCK;
+            for (j = 0; j < num_used && curr_inode->block_idx_arr[j] < sb->boot_block->num_dblocks; j++) {
+                if (fsys_load_dblock(sb, curr_inode->block_idx_arr[j]) == -1) {
+                    return -1;
+                }
+            }
+            if (j == num_used) {
+                MAP_SET(sb->dir_inode_map, entry->inode_idx);
+                dir_scan_queue[tail++] = entry->inode_idx;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* fsys_mark_inode - marks an inode and its data blocks in use
+ *
+ * Inputs: sb - mounted image
+ *         inode - inode number, must be in range
+ * Outputs: None
+ * Side Effects: updates sb->inode_used_map and sb->dblock_used_map
+ */
+static void fsys_mark_inode(fsys_sb_t* sb, uint32_t inode) {
+    uint32_t num_used = fsys_inode_blocks(sb, inode);   /* number of blocks the file size covers */
+    uint32_t j;                                     /* block index within the inode */
+
+    MAP_SET(sb->inode_used_map, inode);
+    for (j = 0; j < num_used; j++) {
+        if (fsys_inode_dblock(sb, inode, j) < fsys_num_dblocks(sb)) {
+            MAP_SET(sb->dblock_used_map, fsys_inode_dblock(sb, inode, j));
+        }
+    }
+}
+
+/* fsys_validate_zinode - checks the run and offset table of a compressed inode
+ *      the table has to start at 0 and grow by at most the length of each file block,
+ *      and the stream has to fit in a run of data blocks inside the image
+ * 
+ * Inputs: sb - mounted image
+ *         inode - compressed inode in the image
+ * Outputs: 0 for a good inode, -1 for a bad one
+ * Side Effects: None
+ */
+static int32_t fsys_validate_zinode(fsys_sb_t* sb, inode_t* inode) {
+    uint32_t* offsets = &inode->block_idx_arr[ZINODE_OFFSETS];  /* offset table */
+    uint32_t num_blocks;    /* number of file blocks */
+    uint32_t block_len;     /* uncompressed length of a file block */
+    uint32_t i;             /* loop index */
+
+    num_blocks = inode->file_size / DISK_BLOCK_SIZE + (inode->file_size % DISK_BLOCK_SIZE != 0);
+    if (num_blocks > ZINODE_MAX_BLOCKS || offsets[0] != 0) {
+        return -1;
+    }
+
+    for (i = 0; i < num_blocks; i++) {
+        block_len = (i + 1 < num_blocks || inode->file_size % DISK_BLOCK_SIZE == 0) ? DISK_BLOCK_SIZE : inode->file_size % DISK_BLOCK_SIZE;
+        if (offsets[i + 1] < offsets[i] || offsets[i + 1] - offsets[i] > block_len) {
+            return -1;
+        }
+    }
+
+    // the table keeps the stream below 4 MB, so the run length cannot overflow
+    if (inode->block_idx_arr[ZINODE_NUM_DBLOCKS] > sb->boot_block->num_dblocks ||
+        inode->block_idx_arr[ZINODE_DBLOCK] > sb->boot_block->num_dblocks - inode->block_idx_arr[ZINODE_NUM_DBLOCKS] ||
+        (offsets[num_blocks] + DISK_BLOCK_SIZE - 1) / DISK_BLOCK_SIZE > inode->block_idx_arr[ZINODE_NUM_DBLOCKS]) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/* fsys_validate_inodes - checks every inode once at mount
+ *      an inode is bad if its file size needs more blocks than the image has, or if any
+ *      block it uses, indirect blocks included, is not a data block
+ *      compressed inodes are checked by fsys_validate_zinode instead
+ * 
+ * Inputs: sb - mounted image
+ * Outputs: None
+ * Side Effects: fills sb->inode_bad_map
+ */
+static void fsys_validate_inodes(fsys_sb_t* sb) {
+    uint32_t i;         /* inode index */
+    uint32_t j;         /* block index within the inode */
+    uint32_t num_used;  /* number of data blocks the inode uses */
+
+    for (i = 0; i < MAX_INODES / 32; i++) {
+        sb->inode_bad_map[i] = 0;
+    }
+
+    for (i = 0; i < sb->boot_block->num_inodes && i < MAX_INODES; i++) {
+        if (sb->inodes_arr[i].flags & INODE_COMPRESSED) {
+            if (fsys_validate_zinode(sb, &sb->inodes_arr[i]) == -1) {
+                sb->inode_bad_map[i / 32] |= 1 << (i % 32);
+            }
+            continue;
+        }
+
+        if (fsys_file_blocks(&sb->inodes_arr[i]) > sb->boot_block->num_dblocks) {
+            sb->inode_bad_map[i / 32] |= 1 << (i % 32);
+            continue;
+        }
+
+        num_used = fsys_inode_blocks(sb, i);
+        for (j = 0; j < num_used; j++) {
+            if (fsys_inode_dblock(sb, i, j) >= sb->boot_block->num_dblocks) {
+                sb->inode_bad_map[i / 32] |= 1 << (i % 32);
+                break;
+            }
+        }
+    }
+}
+
+/* fsys_build_free_maps - marks the inodes and data blocks in use
+ *      walks the directory tree breadth first from the root, every directory is
+ *      scanned once so "." and ".." and other cycles end the walk
+ *      blocks of bad inodes are kept as used so they are never handed out twice
+ *
+ * Inputs: sb - mounted image
+ * Outputs: None
+ * Side Effects: fills sb->inode_used_map, sb->dblock_used_map and sb->dir_inode_map
+ */
+static void fsys_build_free_maps(fsys_sb_t* sb) {
+    uint32_t i;             /* loop index */
+    uint32_t head = 0;      /* next directory to scan in the queue */
+    uint32_t tail = 0;      /* end of the queue */
+    uint32_t dir;           /* directory being scanned */
+    uint32_t num_entries;   /* dentries in the directory */
+    dentry_t* entry;        /* current dentry */
+
+    for (i = 0; i < MAX_INODES / 32; i++) {
+        sb->inode_used_map[i] = 0;
+        sb->dir_inode_map[i] = 0;
+    }
+    for (i = 0; i < MAX_DBLOCKS / 32; i++) {
+        sb->dblock_used_map[i] = 0;
+    }
+
+    // inode 0 is shared by the root directory and rtc entries
+    MAP_SET(sb->inode_used_map, 0);
+
+    dir_scan_queue[tail++] = FSYS_ROOT_DIR;
+    while (head < tail) {
+        dir = dir_scan_queue[head++];
+        num_entries = fsys_dir_size(sb, dir);
+
+        for (i = 0; i < num_entries; i++) {
+            entry = fsys_dir_entry(sb, dir, i);
+            if (entry->inode_idx >= sb->boot_block->num_inodes || entry->inode_idx >= MAX_INODES) {
+                continue;
+            }
+
+            if (entry->file_type == REGULAR_FILE_TYPE) {
+                fsys_mark_inode(sb, entry->inode_idx);
+            } else if (entry->file_type == DIRECTORY_FILE_TYPE && !fsys_is_dir(sb, entry->inode_idx)) {
+                // blocks of a bad directory are still marked, its dentries are not trusted
+                fsys_mark_inode(sb, entry->inode_idx);
+                if (!MAP_TEST(sb->inode_bad_map, entry->inode_idx) && !(sb->inodes_arr[entry->inode_idx].flags & INODE_COMPRESSED)) {
+                    MAP_SET(sb->dir_inode_map, entry->inode_idx);
+                    dir_scan_queue[tail++] = entry->inode_idx;
+                }
+            }
+        }
+    }
+}
+
+/* fsys_find_run - finds the first run of free data blocks
+ * 
+ * Inputs: sb - mounted image
+ *         count - number of contiguous blocks needed
+ * Outputs: first data block of the run, -1 if there is none
+ * Side Effects: None
+ */
+static int32_t fsys_find_run(fsys_sb_t* sb, uint32_t count) {
+    uint32_t start = 0;     /* first block of the current run */
+    uint32_t i;             /* loop index */
+
+    for (i = 0; i < fsys_num_dblocks(sb); i++) {
+        if (MAP_TEST(sb->dblock_used_map, i)) {
+            start = i + 1;
+        } else if (i + 1 - start == count) {
+            return start;
+        }
+    }
+
+    return -1;
+}
+
+/* fsys_alloc_blocks - allocates data blocks, contiguous whenever possible
+ *      tries to continue right after hint, then the first free run long enough,
+ *      and only then scattered free blocks
+ * 
+ * Inputs: sb - mounted image
+ *         hint - data block the new blocks should follow, MAX_DBLOCKS for none
+ *         count - number of blocks to allocate
+ *         blocks - array to fill with the allocated data block indices
+ * Outputs: 0 for success, -1 if there are not enough free blocks
+ * Side Effects: marks the blocks used
+ */
+static int32_t fsys_alloc_blocks(fsys_sb_t* sb, uint32_t hint, uint32_t count, uint32_t* blocks) {
+    uint32_t i;         /* loop index */
+    uint32_t found;     /* blocks found so far */
+    int32_t start;      /* first block of a free run */
+
+    // extend the previous block in place
+    for (i = 0; i < count; i++) {
+        if (hint + 1 + i >= fsys_num_dblocks(sb) || MAP_TEST(sb->dblock_used_map, hint + 1 + i)) {
+            break;
+        }
+    }
+    if (hint < MAX_DBLOCKS && i == count) {
+        start = hint + 1;
+    } else {
+        start = fsys_find_run(sb, count);
+    }
+
+    if (start != -1) {
+        for (i = 0; i < count; i++) {
+            blocks[i] = start + i;
+            MAP_SET(sb->dblock_used_map, start + i);
+        }
+        return 0;
+    }
+
+    // no run is long enough, take whatever is free
+    found = 0;
+    for (i = 0; i < fsys_num_dblocks(sb) && found < count; i++) {
+        if (!MAP_TEST(sb->dblock_used_map, i)) {
+            blocks[found++] = i;
+        }
+    }
+    if (found < count) {
+        return -1;
+    }
+    for (i = 0; i < count; i++) {
+        MAP_SET(sb->dblock_used_map, blocks[i]);
+    }
+    return 0;
+}
+
+/* fsys_format_journal - sets up a journal in free data blocks
+ * 
+ * Inputs: sb - mounted image
+ * Outputs: 0 for success, -1 if there is no room and the image stays read-only
+ * Side Effects: writes the journal blocks and the boot block
+ */
+static int32_t fsys_format_journal(fsys_sb_t* sb) {
+    int32_t start = fsys_find_run(sb, JOURNAL_BLOCKS); /* first data block of the journal */
+    uint32_t i;                                     /* loop index */
+
+    if (start == -1) {
+        return -1;
+    }
+
+    // the journal lives in memory, its blocks are written through to a device
+    journal_format(&sb->journal, sb->disk_mem_base_addr, DBLOCK_NUM(sb, start), sb->dev);
+    for (i = 0; i < JOURNAL_BLOCKS; i++) {
+        MAP_SET(sb->dblock_used_map, start + i);
+        if (sb->dev != NULL) {
+            MAP_SET(sb->dblock_mem_map, start + i);
+        }
+    }
+
+    // the magic goes in last, it is what marks the journal as valid
+    sb->boot_block->journal_dblock = start;
+    sb->boot_block->journal_magic = JOURNAL_MAGIC;
+    return fsys_sync_block(sb, BOOT_BLOCK_NUM);
+}
+
+/* fsys_mount - sets up an instance for an image
+ *      each image gets its own instance, up to FSYS_MAX_IMAGES
+ * 
+ * Inputs: starting_addr - memory holding the image, or only its boot block and inodes for an image on a device
+ *         dev - device holding the image from sector 0, NULL for an image resident in memory
+ * Outputs: the instance to mount, NULL if every instance is in use or a read from dev failed
+ * Side Effects: sets the base address for the memory mapped disk as well as useful base addresses,
+ *               replays the journal, reads the metadata of an image on a device,
+ *               validates every inode, walks the directory tree to build the allocation bitmaps
+ *               and builds the root name hash index
+ */
+static vfs_sb_t* fsys_mount(uint32_t starting_addr, blk_device_t* dev) {
+    fsys_sb_t* sb;  /* instance of the image */
+    uint32_t i;     /* loop index */
+
+    if (fsys_num_sbs == FSYS_MAX_IMAGES) {
+        return NULL;
+    }
+    sb = &fsys_sbs[fsys_num_sbs];
+    sb->vfs.ops = &fsys_vfs_ops;
+    sb->vfs.root = FSYS_ROOT_DIR;
+    sb->vfs.fs_data = sb;
+
+    sb->disk_mem_base_addr = starting_addr;
+    sb->file_dir_arr_base_addr = sb->disk_mem_base_addr + DENTRY_SIZE;  // dentry directory base address
+    sb->inodes_arr_base_addr = sb->disk_mem_base_addr + DISK_BLOCK_SIZE; // inode blocks base address
+    
+    sb->boot_block = (boot_dentry_t*) sb->disk_mem_base_addr;           // 64 byte bootblock
+    sb->file_dir_arr = (dentry_t*) sb->file_dir_arr_base_addr;
+    sb->inodes_arr = (inode_t*) sb->inodes_arr_base_addr;
+
+    // file data of an image on a device goes through the buffer cache, an image
+    // already in memory is used directly since caching it would only add a copy
+    sb->dev = dev;
+    for (i = 0; i < MAX_DBLOCKS / 32; i++) {
+        sb->dblock_mem_map[i] = 0;
+        sb->dblock_dirty_map[i] = 0;
+    }
+
+    // finish a metadata update cut off by a crash before any metadata is read
+    sb->writable = 0;
+    sb->writing = 0;
+    if (sb->boot_block->journal_magic == JOURNAL_MAGIC && sb->boot_block->journal_dblock < fsys_num_dblocks(sb) &&
+        sb->boot_block->journal_dblock + JOURNAL_BLOCKS <= fsys_num_dblocks(sb)) {
+        for (i = 0; sb->dev != NULL && i < JOURNAL_BLOCKS; i++) {
+            if (fsys_load_dblock(sb, sb->boot_block->journal_dblock + i) == -1) {
+                return NULL;
+            }
+        }
+        sb->writable = (journal_mount(&sb->journal, sb->disk_mem_base_addr, DBLOCK_NUM(sb, sb->boot_block->journal_dblock), sb->dev) == 0);
+    }
+    if (sb->dev != NULL && fsys_load_meta(sb) == -1) {
+        return NULL;
+    }
+
+    fsys_validate_inodes(sb);
+    fsys_build_free_maps(sb);
+
+    for (i = 0; i < DIR_INDEX_SLOTS; i++) {
+        sb->dir_indexes[i].valid = 0;
+    }
+    fsys_map_epoch++;
+    fsys_index_build(sb, &sb->dir_indexes[0], FSYS_ROOT_DIR);
+
+    if (sb->writable) {
+        for (i = 0; i < JOURNAL_BLOCKS; i++) {
+            MAP_SET(sb->dblock_used_map, sb->boot_block->journal_dblock + i);
+        }
+    } else {
+        sb->writable = (fsys_format_journal(sb) == 0);
+    }
+
+    fsys_num_sbs++;
+    return &sb->vfs;
+}
+
+/* init_fsys - file system initialization for an image resident in memory
+ * 
+ * Inputs: uint32_t starting addr
+ * Outputs: the instance to mount, NULL if every instance is in use
+ * Side Effects: see fsys_mount
+ */
+vfs_sb_t* init_fsys(uint32_t starting_addr) {
+    return fsys_mount(starting_addr, NULL);
+}
+
+/* fsys_load_disk - mounts a file system image from a block device
+ *      the boot block is checked first so a disk holding something else is left alone
+ *      the boot block, inodes, journal, directories and indirect blocks are read into memory
+ *      and written through to the device; file data is read and written back through the
+ *      buffer cache, memory only keeps copies of the blocks mmap maps
+ *
+ * Inputs: dev - block device holding the image from sector 0
+ *         addr - identity mapped kernel memory the image is laid out in
+ *         max_size - bytes available at addr, the whole image has to fit
+ * Outputs: the instance to mount, NULL if the device holds no image, a read failed
+ *          or every instance is in use
+ * Side Effects: overwrites the memory at addr, sets up the image on success
+ */
+vfs_sb_t* fsys_load_disk(blk_device_t* dev, uint32_t addr, uint32_t max_size) {
+    boot_dentry_t* boot = (boot_dentry_t*)addr;                 /* boot block once it is read */
+    dentry_t* root = (dentry_t*)(addr + DENTRY_SIZE);           /* "." dentry of the root */
+    uint32_t sectors_per_block = DISK_BLOCK_SIZE / BLK_SECTOR_SIZE;   /* sectors in a block */
+    uint32_t num_blocks;                                        /* blocks in the image */
+
+    if (dev == NULL || max_size < DISK_BLOCK_SIZE || dev->num_sectors < sectors_per_block) {
+        return NULL;
+    }
+    if (blk_rw(dev, 0, sectors_per_block, (uint8_t*)addr, 0) == -1) {
+        return NULL;
+    }
+
+    if (boot->num_dir_entries == 0 || boot->num_dir_entries > MAX_DENTRIES ||
+        boot->num_inodes == 0 || boot->num_inodes > MAX_INODES || boot->num_dblocks > MAX_DBLOCKS ||
+        root->file_type != DIRECTORY_FILE_TYPE || strncmp(root->file_name, ".", FILENAME_LEN) != 0) {
+        return NULL;
+    }
+
+    num_blocks = 1 + boot->num_inodes + boot->num_dblocks;
+    if (num_blocks > max_size / DISK_BLOCK_SIZE || num_blocks > dev->num_sectors / sectors_per_block) {
+        return NULL;
+    }
+    if (blk_rw(dev, sectors_per_block, boot->num_inodes * sectors_per_block, (uint8_t*)addr + DISK_BLOCK_SIZE, 0) == -1) {
+        return NULL;
+    }
+
+    return fsys_mount(addr, dev);
+}
+
+/* fsys_walk_step - moves from a directory into one of its subdirectories
+ * 
+ * Inputs: sb - mounted image
+ *         dir - directory to move from, updated to the subdirectory
+ *         name - name of the subdirectory, ".." of the root is the root
+ * Outputs: 0 for success, -1 if name is missing or not a directory
+ * Side Effects: None
+ */
+static int32_t fsys_walk_step(fsys_sb_t* sb, uint32_t* dir, const char* name) {
+    int32_t idx;        /* dentry index of name */
+    dentry_t* entry;    /* dentry of name */
+
+    if (*dir == FSYS_ROOT_DIR && strncmp((int8_t*)name, "..", FILENAME_LEN) == 0) {
+        return 0;
+    }
+
+    idx = fsys_dir_lookup(sb, *dir, name);
+    if (idx == -1) {
+        return -1;
+    }
+    entry = fsys_dir_entry(sb, *dir, idx);
+    if (entry->file_type != DIRECTORY_FILE_TYPE || !fsys_is_dir(sb, entry->inode_idx)) {
+        return -1;
+    }
+
+    *dir = entry->inode_idx;
+    return 0;
+}
+
+/* fsys_walk - walks a path up to its last component
+ *      components are separated by one or more '/' and cut at FILENAME_LEN characters,
+ *      a path starting with '/' begins at the root, any other at start
+ * 
+ * Inputs: sb - mounted image
+ *         start - directory a relative path begins at, the root if it was removed
+ *         path - path to walk
+ *         dir - filled with the directory holding the last component
+ *         leaf - FILENAME_LEN + 1 bytes, filled with the last component, empty for
+ *                a path naming the starting directory such as "/"
+ * Outputs: 0 for success, -1 if a directory on the way is missing
+ * Side Effects: None
+ */
+static int32_t fsys_walk(fsys_sb_t* sb, uint32_t start, const uint8_t* path, uint32_t* dir, char* leaf) {
+    uint32_t len;   /* length of the current component */
+
+    *dir = (path[0] == '/' || !fsys_is_dir(sb, start)) ? FSYS_ROOT_DIR : start;
+    leaf[0] = '\0';
+
+    while (1) {
+        while (*path == '/') {
+            path++;
+        }
+        if (*path == '\0') {
+            return 0;
+        }
+
+        // the previous component was not the last one, it has to be a directory
+        if (leaf[0] != '\0' && fsys_walk_step(sb, dir, leaf) == -1) {
+            return -1;
+        }
+
+        for (len = 0; path[len] != '/' && path[len] != '\0'; len++) {
+            if (len < FILENAME_LEN) {
+                leaf[len] = path[len];
+            }
+        }
+        leaf[(len < FILENAME_LEN) ? len : FILENAME_LEN] = '\0';
+        path += len;
+    }
+}
+
+/* read_dentry_by_name - finding the dentry by the user readable name
+ *      only looks in the root directory of the first image
+ * 
+ * Inputs: uint8_t* fname - dentry name, dentry_t* dentry - empty dentry struct
+ * Outputs: int32_t = 0 indicates if the read was successful else return -1
+ * Side Effects: Populates the input dentry pointer with dentry items from the file read
+ */
+int32_t read_dentry_by_name(uint8_t* fname, dentry_t* dentry) {
+    fsys_sb_t* sb = &fsys_sbs[0];                                   /* first image */
+    int32_t i = fsys_dir_lookup(sb, FSYS_ROOT_DIR, (char*)fname);  /* index of the dentry */
+    
+    // failure when fname not found
+    if (i == -1) {
+        return -1;
+    }
+
+    memcpy(dentry, &sb->file_dir_arr[i], DENTRY_SIZE); // copy the whole dentry
+    return 0;
+}
+
+/* fsys_lookup - finding the dentry by a '/' separated path, the VFS lookup of an image
+ *      a path naming a directory itself, such as "/" or "..", gets a "." dentry of that directory
+ * 
+ * Inputs: vfs - instance of the image
+ *         start - directory a relative path begins at
+ *         path - path relative to start, or to the root if it starts with '/'
+ *         dentry - dentry struct to fill
+ * Outputs: 0 for success, -1 if the path is empty or not found
+ * Side Effects: Populates the input dentry pointer with dentry items from the file read
+ */
+int32_t fsys_lookup(vfs_sb_t* vfs, uint32_t start, const uint8_t* path, dentry_t* dentry) {
+    fsys_sb_t* sb = (fsys_sb_t*)vfs->fs_data; /* image of the instance */
+    uint32_t dir;                   /* directory holding the last component */
+    char leaf[FILENAME_LEN + 1];    /* last component of the path */
+    int32_t idx;                    /* dentry index of the last component */
+    int32_t ret = -1;               /* return value */
+    uint32_t save;                  /* variable to store flags */
+
+    if (path == NULL || path[0] == '\0') {
+        return -1;
+    }
+
+    // dentries of subdirectories move when a file is removed
+    cli_and_save(save);
+
+    if (fsys_walk(sb, start, path, &dir, leaf) == 0) {
+        if (leaf[0] == '\0' || fsys_walk_step(sb, &dir, leaf) == 0) {
+            memset(dentry, 0, DENTRY_SIZE);
+            strcpy(dentry->file_name, ".");
+            dentry->file_type = DIRECTORY_FILE_TYPE;
+            dentry->inode_idx = dir;
+            ret = 0;
+        } else if ((idx = fsys_dir_lookup(sb, dir, leaf)) != -1 && fsys_dir_entry(sb, dir, idx)->file_type != DIRECTORY_FILE_TYPE) {
+            memcpy(dentry, fsys_dir_entry(sb, dir, idx), DENTRY_SIZE);
+            ret = 0;
+        }
+    }
+
+    restore_flags(save);
+    return ret;
+}
+
+/* read_dentry_by_index - finding the dentry by the index in the directory
+ *      note that index is the index in the boot block of the first image, NOT the inode index
+ * 
+ * Inputs:  uint32_t index - target index in boot block
+ *          dentry_t* dentry - dentry struct to fill
+ * Outputs: int32_t = 0 indicates if the read was successful else return -1
+ * Side Effects: Populates the input dentry pointer with dentry items from the file read
+ */
+int32_t read_dentry_by_index(uint32_t index, dentry_t* dentry) {
+    fsys_sb_t* sb = &fsys_sbs[0];   /* first image */
+
+    // failure if index is boot dentry or outside the number of dentries
+    if (index == 0 || index > sb->boot_block->num_dir_entries) {
+        return -1;                                              
+    }
+
+    // copy the whole dentry
+    memcpy(dentry, &sb->file_dir_arr[index-1], DENTRY_SIZE);
+    return 0;
+}
+
+/* fsys_read_block - copies bytes out of a data block
+ *      goes through the buffer cache when the image is a block device
+ * 
+ * Inputs: sb - mounted image
+ *         dblock - data block index
+ *         offset - first byte within the block
+ *         buf - buffer to fill
+ *         length - number of bytes, offset + length must not pass the end of the block
+ * Outputs: 0 for success, -1 if the block could not be read
+ * Side Effects: may read the block into the cache
+ */
+static int32_t fsys_read_block(fsys_sb_t* sb, uint32_t dblock, uint32_t offset, uint8_t* buf, uint32_t length) {
+    bcache_buf_t* cached;   /* cached copy of the block */
+
+    if (sb->dev == NULL) {
+        memcpy(buf, (void*)(DBLOCK_ADDR(sb, dblock) + offset), length);
+        return 0;
+    }
+
+    cached = bcache_read(sb->dev, DBLOCK_NUM(sb, dblock));
+    if (cached == NULL) {
+        return -1;
+    }
+    memcpy(buf, cached->data + offset, length);
+    bcache_release(cached);
+    return 0;
+}
 
-/* init_fsys - file system initialization
+/* fsys_write_block - copies bytes into a data block
+ *      the cached copy is only marked dirty, bcache_sync writes it to the device;
+ *      a block with a copy in memory has that copy updated too, so mappings stay current
  * 
- * Inputs: uint32_t starting addr
+ * Inputs: sb - mounted image
+ *         dblock - data block index
+ *         offset - first byte within the block
+ *         buf - bytes to write, NULL to write 0s
+ *         length - number of bytes, offset + length must not pass the end of the block
+ * Outputs: 0 for success, -1 if the block could not be read
+ * Side Effects: may read the block into the cache
+ */
+static int32_t fsys_write_block(fsys_sb_t* sb, uint32_t dblock, uint32_t offset, const uint8_t* buf, uint32_t length) {
+    bcache_buf_t* cached = NULL;    /* cached copy of the block */
+    uint8_t* dest;                  /* first byte to write */
+
+    if (sb->dev == NULL) {
+        dest = (uint8_t*)(DBLOCK_ADDR(sb, dblock) + offset);
+    } else {
+        // a block that is overwritten completely does not have to be read first
+        cached = (offset == 0 && length == DISK_BLOCK_SIZE) ? bcache_zero(sb->dev, DBLOCK_NUM(sb, dblock)) : bcache_read(sb->dev, DBLOCK_NUM(sb, dblock));
+        if (cached == NULL) {
+            return -1;
+        }
+        dest = cached->data + offset;
+    }
+
+    if (buf != NULL) {
+        memcpy(dest, buf, length);
+    } else {
+        memset(dest, 0, length);
+    }
+
+    if (sb->dev != NULL) {
+        if (MAP_TEST(sb->dblock_mem_map, dblock)) {
+            memcpy((void*)(DBLOCK_ADDR(sb, dblock) + offset), dest, length);
+        }
+        bcache_mark_dirty(cached);
+        bcache_release(cached);
+    }
+    return 0;
+}
+
+/* fsys_zcache_fill - decompresses one block of a compressed file
+ *      the packed bytes may cross into the next data block of the run
+ * 
+ * Inputs: sb - mounted image
+ *         inode - compressed inode that passed validation
+ *         block - block index within the file
+ *         data - DISK_BLOCK_SIZE bytes to fill
+ * Outputs: 0 for success, -1 if a data block could not be read or the block is corrupt
+ * Side Effects: overwrites zcache_packed
+ */
+static int32_t fsys_zcache_fill(fsys_sb_t* sb, uint32_t inode, uint32_t block, uint8_t* data) {
+    inode_t* curr_inode = &sb->inodes_arr[inode];                   /* pointer to inode in disk */
+    uint32_t* offsets = &curr_inode->block_idx_arr[ZINODE_OFFSETS]; /* offset table */
+    uint32_t packed_len = offsets[block + 1] - offsets[block];  /* bytes of the block in the stream */
+    uint32_t block_len;                                         /* uncompressed length of the block */
+    uint8_t* packed;                                            /* buffer for the packed bytes */
+    uint32_t pos;                                               /* stream offset being copied */
+    uint32_t bytes_to_copy;                                     /* bytes to copy from the current data block */
+
+    block_len = curr_inode->file_size - block * DISK_BLOCK_SIZE;
+    if (block_len > DISK_BLOCK_SIZE) {
+        block_len = DISK_BLOCK_SIZE;
+    }
+
+    // a block stored uncompressed is copied straight into the slot
+    packed = (packed_len == block_len) ? data : zcache_packed;
+    for (pos = offsets[block]; pos < offsets[block + 1]; pos += bytes_to_copy) {
+        bytes_to_copy = DISK_BLOCK_SIZE - pos % DISK_BLOCK_SIZE;
+        if (bytes_to_copy > offsets[block + 1] - pos) {
+            bytes_to_copy = offsets[block + 1] - pos;
+        }
+        if (fsys_read_block(sb, curr_inode->block_idx_arr[ZINODE_DBLOCK] + pos / DISK_BLOCK_SIZE, pos % DISK_BLOCK_SIZE,
+                            packed + pos - offsets[block], bytes_to_copy) == -1) {
+            return -1;
+        }
+    }
+
+    if (packed == zcache_packed && lz4_decompress(zcache_packed, packed_len, data, block_len) != block_len) {
+        return -1;
+    }
+    return 0;
+}
+
+/* fsys_zcache_get - gets a decompressed block of a compressed file
+ *      a block that is not cached is decompressed into the least recently used slot
+ *      must be called with interrupts disabled
+ * 
+ * Inputs: sb - mounted image
+ *         inode - compressed inode that passed validation
+ *         block - block index within the file
+ * Outputs: the decompressed block, NULL if it could not be read
+ * Side Effects: may replace a cached block
+ */
+static uint8_t* fsys_zcache_get(fsys_sb_t* sb, uint32_t inode, uint32_t block) {
+    zcache_slot_t* victim = &zcache_slots[0];   /* slot to replace if the block is not cached */
+    uint32_t i;                                 /* loop index */
+
+    for (i = 0; i < FSYS_ZCACHE_SLOTS; i++) {
+        if (zcache_slots[i].valid && zcache_slots[i].sb == sb && zcache_slots[i].inode == inode && zcache_slots[i].block == block) {
+            zcache_slots[i].last_use = ++zcache_clock;
+            return zcache_slots[i].data;
+        }
+        if (!zcache_slots[i].valid || (victim->valid && zcache_slots[i].last_use < victim->last_use)) {
+            victim = &zcache_slots[i];
+        }
+    }
+
+    victim->valid = 0;
+    if (fsys_zcache_fill(sb, inode, block, victim->data) == -1) {
+        return NULL;
+    }
+    victim->valid = 1;
+    victim->sb = sb;
+    victim->inode = inode;
+    victim->block = block;
+    victim->last_use = ++zcache_clock;
+    return victim->data;
+}
+
+/* fsys_zcache_drop - forgets the decompressed blocks of a file that was removed
+ * 
+ * Inputs: sb - mounted image
+ *         inode - inode number
  * Outputs: None
- * Side Effects: sets the base address for the memory mapped disk as well as useful base addresses
+ * Side Effects: frees the slots of the inode
  */
-void init_fsys(uint32_t starting_addr) {
-    disk_mem_base_addr = starting_addr;
-    file_dir_arr_base_addr = disk_mem_base_addr + DENTRY_SIZE;  // dentry directory base address
-    inodes_arr_base_addr = disk_mem_base_addr + DISK_BLOCK_SIZE; // inode blocks base address
-    
-    boot_block = (boot_dentry_t*) disk_mem_base_addr;           // 64 byte bootblock
-    file_dir_arr = (dentry_t*) file_dir_arr_base_addr;
-    inodes_arr = (inode_t*) inodes_arr_base_addr;
+static void fsys_zcache_drop(fsys_sb_t* sb, uint32_t inode) {
+    uint32_t i; /* loop index */
+
+    for (i = 0; i < FSYS_ZCACHE_SLOTS; i++) {
+        if (zcache_slots[i].sb == sb && zcache_slots[i].inode == inode) {
+            zcache_slots[i].valid = 0;
+        }
+    }
 }
 
-/* read_dentry_by_name - finding the dentry by the user readable name
+/* fsys_read_file_block - copies bytes out of one block of a file
+ *      compressed files are read through the decompressed block cache
  * 
- * Inputs: uint8_t* fname - dentry name, dentry_t* dentry - empty dentry struct
- * Outputs: int32_t = 0 indicates if the read was successful else return -1
- * Side Effects: Populates the input dentry pointer with dentry items from the file read
+ * Inputs: sb - mounted image
+ *         inode - inode that passed validation
+ *         block - block index within the file, must be inside the file size
+ *         offset - first byte within the block
+ *         buf - buffer to fill
+ *         length - number of bytes, offset + length must not pass the end of the block
+ *         cache - map cache of the file descriptor, NULL for none
+ * Outputs: 0 for success, -1 if the block could not be read
+ * Side Effects: may read the block into the cache
  */
-int32_t read_dentry_by_name(uint8_t* fname, dentry_t* dentry) {
-    uint32_t i;         /* loop index */
+static int32_t fsys_read_file_block(fsys_sb_t* sb, uint32_t inode, uint32_t block, uint32_t offset, uint8_t* buf, uint32_t length,
+                                    fsys_map_cache_t* cache) {
+    uint8_t* data;  /* decompressed block */
+    uint32_t save;  /* variable to store flags */
+
+    if (!(sb->inodes_arr[inode].flags & INODE_COMPRESSED)) {
+        return fsys_read_block(sb, fsys_bmap(sb, &sb->inodes_arr[inode], block, cache), offset, buf, length);
+    }
+
+    // the slots and the packed buffer are shared by every process
+    cli_and_save(save);
+    data = fsys_zcache_get(sb, inode, block);
+    if (data != NULL) {
+        memcpy(buf, data + offset, length);
+    }
+    restore_flags(save);
+
+    return (data != NULL) ? 0 : -1;
+}
+
+/* fsys_file_dblock - gets the data block holding the start of a file block
+ * 
+ * Inputs: sb - mounted image
+ *         inode - inode that passed validation
+ *         block - block index within the file, must be inside the file size
+ *         cache - map cache of the file descriptor, NULL for none
+ * Outputs: data block index
+ * Side Effects: may refill the cache
+ */
+static uint32_t fsys_file_dblock(fsys_sb_t* sb, uint32_t inode, uint32_t block, fsys_map_cache_t* cache) {
+    inode_t* curr_inode = &sb->inodes_arr[inode];   /* pointer to inode in disk */
+
+    if (curr_inode->flags & INODE_COMPRESSED) {
+        return curr_inode->block_idx_arr[ZINODE_DBLOCK] + curr_inode->block_idx_arr[ZINODE_OFFSETS + block] / DISK_BLOCK_SIZE;
+    }
+    return fsys_bmap(sb, curr_inode, block, cache);
+}
+
+/* fsys_readahead - starts reading file blocks that are about to be needed
+ * 
+ * Inputs: sb - mounted image
+ *         inode - inode number
+ *         first - first block index within the file
+ *         count - number of blocks
+ *         cache - map cache of the file descriptor
+ * Outputs: None
+ * Side Effects: may evict cached blocks
+ */
+static void fsys_readahead(fsys_sb_t* sb, uint32_t inode, uint32_t first, uint32_t count, fsys_map_cache_t* cache) {
+    uint32_t num_blocks;    /* blocks the file size covers */
+    uint32_t i;             /* loop index */
+
+    if (sb->dev == NULL || inode >= sb->boot_block->num_inodes || inode >= MAX_INODES || MAP_TEST(sb->inode_bad_map, inode)) {
+        return;
+    }
+
+    // blocks of a compressed file share data blocks, bcache_readahead skips cached ones
+    num_blocks = fsys_file_blocks(&sb->inodes_arr[inode]);
+    for (i = first; i < first + count && i < num_blocks; i++) {
+        bcache_readahead(sb->dev, DBLOCK_NUM(sb, fsys_file_dblock(sb, inode, i, cache)));
+    }
+}
+
+/* fsys_read_data - read_data through the map cache of a file descriptor
+ *      block indices were validated at mount, so only the inode's flag is checked here
+ * 
+ * Inputs:  sb - mounted image
+ *          uint32_t inode - inode number
+ *          uint32_t offset - offset within file
+ *          uint8* buf - output buffer
+ *          uint32_t length - number of bytes to read
+ *          cache - map cache of the file descriptor, NULL for none
+ * Outputs: int32_t, either a failed read or the number of bytes that were read
+ * Side Effects: populates buffer with contents from memory, may refill the cache
+ */
+static int32_t fsys_read_data(fsys_sb_t* sb, uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length, fsys_map_cache_t* cache) {
+    uint32_t i;                 /* loop index */
+    uint32_t bytes_to_copy;     /* number of bytes to copy */
+    inode_t* curr_inode;        /* pointer to inode in disk */
+    uint32_t startingblock_idx; /* starting data block index within inode */
+    uint32_t startingbyte_addr; /* address of starting byte within the starting data block */
+    uint32_t endingblock_idx;   /* ending data block index within inode */
+    uint32_t endingbyte_addr;   /* address of ending byte within the ending data block */
+    uint32_t bytes_read;        /* total number of bytes read so far */
+
+    // check that inode number is in range and the inode passed validation
+    if (inode >= sb->boot_block->num_inodes || inode >= MAX_INODES || CHECK_FLAG(sb->inode_bad_map[inode / 32], inode % 32)) {
+        return -1;
+    }
+
+    // set useful variables
+    curr_inode = &sb->inodes_arr[inode];
+
+    // check that beginning byte is within file size
+    if (offset >= curr_inode->file_size) {
+        return -1;
+    }
+
+    // check that ending byte is within file size
+    if (length > curr_inode->file_size - offset) {
+        return -1;
+    }
+
+    // setup bounds
+    startingblock_idx = offset / DISK_BLOCK_SIZE;           // starting block index within the inode
+    startingbyte_addr = offset % DISK_BLOCK_SIZE;           // starting byte address within starting data block
+    endingblock_idx = (offset + length) / DISK_BLOCK_SIZE;  // ending block index within the inode
+    endingbyte_addr = (offset + length) % DISK_BLOCK_SIZE;  // ending byte address within ending data block
+    
+    /* order of operations for the copy
+    *  1.Calculate the number of bytes to copy(depending on the situation)
+    *  2.Copy from the data block through the buffer cache, or out of the decompressed block.
+    *    The buffer starting address is incremented by the current bytes read
+    *  3.increment the bytes read by the bytes copied
+    */
+    bytes_read = 0;
+    if (startingblock_idx == endingblock_idx) { // data to copy is within one data block
+        bytes_to_copy = length;                 
+        if (fsys_read_file_block(sb, inode, startingblock_idx, startingbyte_addr, buf, bytes_to_copy, cache) == -1) {
+            return -1;
+        }
+        bytes_read += bytes_to_copy;
+
+    } else { // data to copy is in multiple data blocks
+
+        /* starting block */
+        bytes_to_copy = DISK_BLOCK_SIZE - startingbyte_addr; // get remaining bytes in starting data block
+        if (fsys_read_file_block(sb, inode, startingblock_idx, startingbyte_addr, buf, bytes_to_copy, cache) == -1) {
+            return -1;
+        }
+        bytes_read += bytes_to_copy;
+
+        /* blocks in between */
+        for (i = startingblock_idx + 1; i < endingblock_idx; i++) {
+            bytes_to_copy = DISK_BLOCK_SIZE; // get all bytes in data block
+            if (fsys_read_file_block(sb, inode, i, 0, buf + bytes_read, DISK_BLOCK_SIZE, cache) == -1) {
+                return -1;
+            }
+            bytes_read += DISK_BLOCK_SIZE;
+        }
+
+        /* ending block, nothing to copy when the read ends on a block boundary */
+        bytes_to_copy = endingbyte_addr; // get beginning bytes in ending block
+        if (bytes_to_copy != 0 &&
+            fsys_read_file_block(sb, inode, endingblock_idx, 0, buf + bytes_read, bytes_to_copy, cache) == -1) {
+            return -1;
+        }
+        bytes_read += bytes_to_copy;
+    }
     
-    // loop over directory entries to find file name
-    for (i = 0; i < boot_block->num_dir_entries; i++) {
-        if (strncmp(file_dir_arr[i].file_name, (char*)fname, 32) == 0) {
-            memcpy(dentry, &file_dir_arr[i], DENTRY_SIZE); // copy the whole dentry
+    // return 0 if we read up to the end of the file
+    if (offset + bytes_read == curr_inode->file_size) {
+        return 0;
+    } else { // otherwise return number of bytes read
+        return bytes_read;  
+    }
+}
+
+/* read_data - read specified number of bytes starting at offset (in bytes) within file from inode
+ *      reads from the first image
+ * 
+ * Inputs:  uint32_t inode - inode number
+ *          uint32_t offset - offset within file
+ *          uint8* buf - output buffer
+ *          uint32_t length - number of bytes to read
+ * Outputs: int32_t, either a failed read or the number of bytes that were read
+ * Side Effects: populates buffer with contents from memory
+ */
+int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length) {
+    return fsys_read_data(&fsys_sbs[0], inode, offset, buf, length, NULL);
+}
+
+/* fsys_read_inode - read_data of any image, the VFS read of an image
+ * 
+ * Inputs:  vfs - instance of the image
+ *          inode - inode number
+ *          offset - offset within file
+ *          buf - output buffer
+ *          length - number of bytes to read
+ * Outputs: int32_t, either a failed read or the number of bytes that were read
+ * Side Effects: populates buffer with contents from memory
+ */
+int32_t fsys_read_inode(vfs_sb_t* vfs, uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length) {
+    return fsys_read_data((fsys_sb_t*)vfs->fs_data, inode, offset, buf, length, NULL);
+}
+
+/* fsys_check_dir - checks that an inode is still a directory, the VFS is_dir of an image
+ * 
+ * Inputs: vfs - instance of the image
+ *         inode - inode number
+ * Outputs: 1 for the root or a directory reachable from it, 0 otherwise
+ * Side Effects: None
+ */
+uint32_t fsys_check_dir(vfs_sb_t* vfs, uint32_t inode) {
+    return fsys_is_dir((fsys_sb_t*)vfs->fs_data, inode);
+}
+
+int32_t get_file_length(char* fname) {
+    dentry_t dentry;        /* dentry to fill when we find the file */
+
+    // try to find the file
+    if (read_dentry_by_name((uint8_t*)fname, &dentry) == -1) {
+        return -1;
+    }
+
+    // check the file type is a normal file
+    if (dentry.file_type != REGULAR_FILE_TYPE) { 
+        return -1;
+    }
+
+    return get_inode_length(dentry.inode_idx);
+}
+
+/* get_inode_length - gets the length of a file of the first image by its inode
+ * 
+ * Inputs: inode - inode number of a regular file
+ * Outputs: file size in bytes, -1 for an inode out of range or a directory
+ * Side Effects: None
+ */
+int32_t get_inode_length(uint32_t inode) {
+    fsys_sb_t* sb = &fsys_sbs[0];   /* first image */
+
+    // check that inode number is in range
+    if (inode >= sb->boot_block->num_inodes || (inode < MAX_INODES && MAP_TEST(sb->dir_inode_map, inode))) {
+        return -1;
+    }
+
+    return sb->inodes_arr[inode].file_size;
+}
+
+/* fsys_stat - describes an inode
+ *      the root directory lives in the boot block and uses no data blocks
+ * 
+ * Inputs: vfs - instance of the image
+ *         file_type - type of the dentry pointing at the inode
+ *         inode - inode number
+ *         st - stat_t to fill
+ * Outputs: 0 for success, -1 for an unknown type or a bad inode
+ * Side Effects: fills st, size and block count stay 0 on failure
+ */
+int32_t fsys_stat(vfs_sb_t* vfs, uint32_t file_type, uint32_t inode, stat_t* st) {
+    fsys_sb_t* sb = (fsys_sb_t*)vfs->fs_data;   /* image of the instance */
+
+    st->file_type = file_type;
+    st->inode_idx = inode;
+    st->file_size = 0;
+    st->num_blocks = 0;
+
+    switch (file_type) {
+        case RTC_FILE_TYPE:
+            return 0;
+        case DIRECTORY_FILE_TYPE:
+            if (!fsys_is_dir(sb, inode) || (inode != FSYS_ROOT_DIR && (inode >= sb->boot_block->num_inodes || MAP_TEST(sb->inode_bad_map, inode)))) {
+                return -1;
+            }
+            st->file_size = fsys_dir_size(sb, inode) * DENTRY_SIZE;
+            st->num_blocks = (inode != FSYS_ROOT_DIR) ? fsys_inode_blocks(sb, inode) : 0;
             return 0;
+        case REGULAR_FILE_TYPE:
+            if (inode >= sb->boot_block->num_inodes || (inode < MAX_INODES && (MAP_TEST(sb->dir_inode_map, inode) || MAP_TEST(sb->inode_bad_map, inode)))) {
+                return -1;
+            }
+            st->file_size = sb->inodes_arr[inode].file_size;
+            st->num_blocks = fsys_inode_blocks(sb, inode);
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+/* fsys_block_addr - gets the address of one of a file's data blocks in the disk image
+ * 
+ * Inputs: vfs - instance of the image
+ *         inode - inode number
+ *         block - block index within the file
+ *         addr - address to fill
+ * Outputs: 0 for success, -1 for a bad or compressed inode, a block past the end of the file
+ *          or a block that could not be read
+ * Side Effects: copies the block into memory for an image on a device, file_write keeps the copy current
+ */
+int32_t fsys_block_addr(vfs_sb_t* vfs, uint32_t inode, uint32_t block, uint32_t* addr) {
+    fsys_sb_t* sb = (fsys_sb_t*)vfs->fs_data;   /* image of the instance */
+    inode_t* curr_inode;                        /* pointer to inode in disk */
+    uint32_t dblock;                            /* data block of the file block */
+
+    // check that inode number is in range and the inode passed validation
+    if (inode >= sb->boot_block->num_inodes || inode >= MAX_INODES || CHECK_FLAG(sb->inode_bad_map[inode / 32], inode % 32)) {
+        return -1;
+    }
+
+    // check that the block holds file data, a compressed block has no image address
+    curr_inode = &sb->inodes_arr[inode];
+    if ((curr_inode->flags & INODE_COMPRESSED) || block >= fsys_file_blocks(curr_inode)) {
+        return -1;
+    }
+
+    dblock = fsys_bmap(sb, curr_inode, block, NULL);
+    if (sb->dev != NULL && !MAP_TEST(sb->dblock_mem_map, dblock)) {
+        if (fsys_read_block(sb, dblock, 0, (uint8_t*)DBLOCK_ADDR(sb, dblock), DISK_BLOCK_SIZE) == -1) {
+            return -1;
         }
+        MAP_SET(sb->dblock_mem_map, dblock);
     }
 
-    // failure when fname not found
-    return -1;                                                      //if none found return 0
+    *addr = DBLOCK_ADDR(sb, dblock);
+    return 0;
 }
 
-/* read_dentry_by_index - finding the dentry by the index in the directory
- *      note that index is the index in the boot block, NOT the inode index
+/* fsys_fill_dentry - fills a dentry
  * 
- * Inputs:  uint32_t index - target index in boot block
- *          dentry_t* dentry - dentry struct to fill
- * Outputs: int32_t = 0 indicates if the read was successful else return -1
- * Side Effects: Populates the input dentry pointer with dentry items from the file read
+ * Inputs: entry - dentry to fill
+ *         name - file name, at most FILENAME_LEN characters are kept
+ *         type - file type
+ *         inode - inode number
+ * Outputs: None
+ * Side Effects: None
  */
-int32_t read_dentry_by_index(uint32_t index, dentry_t* dentry) {
-    // failure if index is boot dentry or outside the number of dentries
-    if (index == 0 || index > boot_block->num_dir_entries) {
-        return -1;                                              
+static void fsys_fill_dentry(dentry_t* entry, const char* name, uint32_t type, uint32_t inode) {
+    memset(entry, 0, DENTRY_SIZE);
+    strncpy(entry->file_name, (int8_t*)name, FILENAME_LEN);
+    entry->file_type = type;
+    entry->inode_idx = inode;
+}
+
+/* fsys_dir_busy - checks if a directory is the current directory of a process
+ * 
+ * Inputs: sb - mounted image
+ *         dir - directory inode
+ * Outputs: 1 if a running process is in dir, 0 otherwise
+ * Side Effects: None
+ */
+static uint32_t fsys_dir_busy(fsys_sb_t* sb, uint32_t dir) {
+    uint32_t pid;   /* loop index */
+    pcb_t* pcb;     /* pcb of the process */
+
+    for (pid = 0; pid < MAX_PROCESSES; pid++) {
+        pcb = (pcb_t*)(USER_MEM_BASE_ADDR - (pid + 1)*_8KB);
+        if (CHECK_FLAG(activeProcesses, pid) && pcb->cwd.sb == &sb->vfs && pcb->cwd.inode == dir) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* fsys_inode_open - checks if an open file still refers to an inode
+ *      the inode and its blocks must not be handed out again while an fd can reach them
+ * 
+ * Inputs: sb - mounted image
+ *         inode - inode of a file or directory
+ * Outputs: 1 if an open file of the image is on inode, 0 otherwise
+ * Side Effects: None
+ */
+static uint32_t fsys_inode_open(fsys_sb_t* sb, uint32_t inode) {
+    file_desc_t* file;  /* open file being checked */
+
+    for (file = open_file_table; file < open_file_table + MAX_OPEN_FILES; file++) {
+        if (file->refs != 0 && file->sb == &sb->vfs && file->inode_num == inode &&
+            (file->fops_table_ptr == &file_jmptable || file->fops_table_ptr == &directory_jmptable)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* fsys_file_mapped - checks if a running process maps a block of a file
+ *      mmap maps data blocks of the image, they must not be handed out again while mapped
+ * 
+ * Inputs: sb - mounted image
+ *         inode - inode of a regular file that passed validation
+ * Outputs: 1 if a page of a running process maps one of the file's blocks, 0 otherwise
+ * Side Effects: overwrites unlink_dblock_map
+ */
+static uint32_t fsys_file_mapped(fsys_sb_t* sb, uint32_t inode) {
+    uint32_t num_used = fsys_inode_blocks(sb, inode);   /* blocks of the file */
+    uint32_t first = DBLOCK_ADDR(sb, 0);                /* address of the first data block */
+    uint32_t pid;                                       /* loop index */
+    uint32_t i;                                         /* loop index */
+    uint32_t addr;                                      /* address a page maps */
+    pcb_t* pcb;                                         /* pcb of the process */
+
+    for (i = 0; i < MAX_DBLOCKS / 32; i++) {
+        unlink_dblock_map[i] = 0;
+    }
+    for (i = 0; i < num_used; i++) {
+        MAP_SET(unlink_dblock_map, fsys_inode_dblock(sb, inode, i));
     }
 
-    // copy the whole dentry
-    memcpy(dentry, &file_dir_arr[index-1], DENTRY_SIZE);
+    for (pid = 0; pid < MAX_PROCESSES; pid++) {
+        pcb = (pcb_t*)(USER_MEM_BASE_ADDR - (pid + 1)*_8KB);
+        if (!CHECK_FLAG(activeProcesses, pid)) {
+            continue;
+        }
+        for (i = 0; i < pcb->mmap_next && i < PAGE_TABLE_NUM; i++) {
+            addr = get_mmap_page(pid, i);
+            if (addr >= first && addr < DBLOCK_ADDR(sb, fsys_num_dblocks(sb)) &&
+                MAP_TEST(unlink_dblock_map, (addr - first) / DISK_BLOCK_SIZE)) {
+                return 1;
+            }
+        }
+    }
     return 0;
 }
 
-/* read_data - read specified number of bytes starting at offset (in bytes) within file from inode
+/* fsys_add_entry - creates an empty regular file or directory
+ *      a root dentry goes in the boot block, a subdirectory dentry goes at the end of the
+ *      directory's data, in a new block when the last one is full
+ *      blocks nothing points at yet (the new directory's block, a new block of the parent)
+ *      are written in place, the rest commits together through the journal
  * 
- * Inputs:  uint32_t inode - inode number
- *          uint32_t offset - offset within file
- *          uint8* buf - output buffer
- *          uint32_t length - number of bytes to read
- * Outputs: int32_t, either a failed read or the number of bytes that were read
- * Side Effects: populates buffer with contents from memory
+ * Inputs: sb - mounted image
+ *         start - directory a relative path begins at
+ *         path - path of the new file, its last component is 1 to 32 characters
+ *         type - REGULAR_FILE_TYPE or DIRECTORY_FILE_TYPE
+ * Outputs: 0 for success, -1 if the name is taken or invalid, or there is no room
+ * Side Effects: adds a dentry to the parent directory, allocates an inode and
+ *               the first block of a directory
  */
-int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length) {
-    uint32_t i;                 /* loop index */
-    uint32_t bytes_to_copy;     /* number of bytes to copy */
-    inode_t* curr_inode;        /* pointer to inode in disk */
-    uint32_t block_base_addr;   /* starting address of beginning of data blocks in disk */
-    uint32_t startingblock_idx; /* starting data block index within inode */
-    uint32_t startingbyte_addr; /* address of starting byte within the starting data block */
-    uint32_t endingblock_idx;   /* ending data block index within inode */
-    uint32_t endingbyte_addr;   /* address of ending byte within the ending data block */
-    uint32_t currentblock_addr; /* base address of data block for loop */
-    uint32_t bytes_read;        /* total number of bytes read so far */
+static int32_t fsys_add_entry(fsys_sb_t* sb, uint32_t start, const uint8_t* path, uint32_t type) {
+    uint32_t dir;                   /* parent directory */
+    char name[FILENAME_LEN + 1];    /* name of the new file */
+    uint32_t num_entries;           /* dentries in the parent directory */
+    uint32_t grow;                  /* the parent needs a new block (1) or not (0) */
+    uint32_t blocks[2];             /* new block of the parent, then first block of a new directory */
+    uint32_t num_blocks;            /* blocks to allocate */
+    boot_dentry_t* new_boot;        /* journal copy of the boot block */
+    inode_t* new_dir_inode;         /* journal copy of the parent inode */
+    dentry_t* new_dentry;           /* new dentry in the parent */
+    dentry_t* new_dir_block;        /* first block of a new directory */
+    inode_t* new_inode;             /* journal copy of the new inode */
+    uint32_t inode;                 /* inode to use */
+    uint32_t i;                     /* loop index */
+    uint32_t save;                  /* variable to store flags */
 
-    // check that inode number is in range
-    if (inode >= boot_block->num_inodes) {
+    if (path == NULL || path[0] == '\0') {
         return -1;
     }
 
-    // set useful variables
-    curr_inode = &inodes_arr[inode];
-    block_base_addr = (boot_block->num_inodes)*DISK_BLOCK_SIZE + inodes_arr_base_addr;
+    cli_and_save(save);
+    fsys_wait_writer(sb, save);
 
-    // check that beginning byte is within file size
-    if (offset >= curr_inode->file_size) {
+    if (!sb->writable || fsys_walk(sb, start, path, &dir, name) == -1 || name[0] == '\0' ||
+        strncmp(name, ".", FILENAME_LEN) == 0 || strncmp(name, "..", FILENAME_LEN) == 0 ||
+        fsys_dir_lookup(sb, dir, name) != -1) {
+        restore_flags(save);
         return -1;
     }
 
-    // check that ending byte is within file size
-    if (offset + length > curr_inode->file_size) {
+    num_entries = fsys_dir_size(sb, dir);
+    if (num_entries >= ((dir == FSYS_ROOT_DIR) ? MAX_DENTRIES : DIR_MAX_ENTRIES)) {
+        restore_flags(save);
         return -1;
     }
 
-    // check for bad data block indices
-    for (i = 0; i < 63; i++) {
-        if (curr_inode->block_idx_arr[i] >= boot_block->num_dblocks) {
-            return -1;
+    // find a free inode
+    for (inode = 1; inode < sb->boot_block->num_inodes && inode < MAX_INODES; inode++) {
+        if (!MAP_TEST(sb->inode_used_map, inode)) {
+            break;
         }
     }
+    if (inode >= sb->boot_block->num_inodes || inode >= MAX_INODES) {
+        restore_flags(save);
+        return -1;
+    }
 
-    // setup bounds
-    startingblock_idx = offset / DISK_BLOCK_SIZE;           // starting block index within the inode
-    startingbyte_addr = offset % DISK_BLOCK_SIZE;           // starting byte address within starting data block
-    endingblock_idx = (offset + length) / DISK_BLOCK_SIZE;  // ending block index within the inode
-    endingbyte_addr = (offset + length) % DISK_BLOCK_SIZE;  // ending byte address within ending data block
-    
-    /* order of operations for the copy
-    *  1.Calculate the number of bytes to copy(depending on the situation)
-    *  2.Calculates current block base address to copy from (current block_addr)
-    *  3.memcopy using the base address for the block and the buffer. 
-    *    The buffer starting address is incremented by the current bytes read
-    *  4.increment the bytes read by the bytes copied
-    */
-    bytes_read = 0;
-    if (startingblock_idx == endingblock_idx) { // data to copy is within one data block
-        bytes_to_copy = length;                 
-        currentblock_addr = curr_inode->block_idx_arr[startingblock_idx]*DISK_BLOCK_SIZE + block_base_addr;
-        memcpy((void*)buf, (void*)(currentblock_addr + startingbyte_addr), bytes_to_copy);
-        bytes_read += bytes_to_copy;
+    // allocate every block up front so nothing fails inside the transaction
+    grow = (dir != FSYS_ROOT_DIR && num_entries % DENTRIES_PER_BLOCK == 0);
+    num_blocks = grow + (type == DIRECTORY_FILE_TYPE);
+    if (num_blocks != 0 &&
+        fsys_alloc_blocks(sb, (grow) ? sb->inodes_arr[dir].block_idx_arr[num_entries / DENTRIES_PER_BLOCK - 1] : MAX_DBLOCKS,
+                          num_blocks, blocks) == -1) {
+        restore_flags(save);
+        return -1;
+    }
 
-    } else { // data to copy is in multiple data blocks
+    // a new directory starts with "." and ".."
+    if (type == DIRECTORY_FILE_TYPE) {
+        new_dir_block = (dentry_t*)DBLOCK_ADDR(sb, blocks[num_blocks - 1]);
+        memset(new_dir_block, 0, DISK_BLOCK_SIZE);
+        fsys_fill_dentry(&new_dir_block[0], ".", DIRECTORY_FILE_TYPE, inode);
+        fsys_fill_dentry(&new_dir_block[1], "..", DIRECTORY_FILE_TYPE, dir);
+        fsys_meta_written(sb, blocks[num_blocks - 1]);
+    }
 
-        /* starting block */
-        bytes_to_copy = DISK_BLOCK_SIZE - startingbyte_addr; // get remaining bytes in starting data block
-        currentblock_addr = curr_inode->block_idx_arr[startingblock_idx]*DISK_BLOCK_SIZE + block_base_addr;
-        memcpy((void*)buf, (void*)(currentblock_addr + startingbyte_addr), bytes_to_copy); // copy from within starting data block
-        bytes_read += bytes_to_copy;
+    journal_begin(&sb->journal);
 
-        /* blocks in between */
-        for (i = startingblock_idx + 1; i < endingblock_idx; i++) {
-            bytes_to_copy = DISK_BLOCK_SIZE; // get all bytes in data block
-            currentblock_addr = curr_inode->block_idx_arr[i]*DISK_BLOCK_SIZE + block_base_addr;
-            memcpy((void*)(buf + bytes_read), (void*)currentblock_addr, DISK_BLOCK_SIZE); // copy from start of data block
-            bytes_read += DISK_BLOCK_SIZE;
+    if (dir == FSYS_ROOT_DIR) {
+        new_boot = (boot_dentry_t*)journal_get_block(&sb->journal, BOOT_BLOCK_NUM);
+        new_dentry = (dentry_t*)((uint32_t)new_boot + DENTRY_SIZE) + new_boot->num_dir_entries;
+        new_boot->num_dir_entries++;
+    } else {
+        new_dir_inode = (inode_t*)journal_get_block(&sb->journal, INODE_BLOCK_NUM(dir));
+        if (grow) {
+            new_dir_inode->block_idx_arr[num_entries / DENTRIES_PER_BLOCK] = blocks[0];
+            new_dentry = (dentry_t*)DBLOCK_ADDR(sb, blocks[0]);
+            memset(new_dentry, 0, DISK_BLOCK_SIZE);
+            fsys_meta_written(sb, blocks[0]);
+        } else {
+            new_dentry = (dentry_t*)journal_get_block(&sb->journal, DBLOCK_NUM(sb, new_dir_inode->block_idx_arr[num_entries / DENTRIES_PER_BLOCK]));
+            new_dentry += num_entries % DENTRIES_PER_BLOCK;
         }
+        new_dir_inode->file_size = (num_entries + 1)*DENTRY_SIZE;
+    }
+    fsys_fill_dentry(new_dentry, name, type, inode);
 
-        /* ending block */
-        bytes_to_copy = endingbyte_addr; // get beginning bytes in ending block
-        currentblock_addr = curr_inode->block_idx_arr[endingblock_idx]*DISK_BLOCK_SIZE + block_base_addr;
-        memcpy((void*)(buf + bytes_read), (void*)currentblock_addr, bytes_to_copy); // copy from start of ending data block
-        bytes_read += bytes_to_copy;
+    new_inode = (inode_t*)journal_get_block(&sb->journal, INODE_BLOCK_NUM(inode));
+    new_inode->flags = 0;
+    if (type == DIRECTORY_FILE_TYPE) {
+        new_inode->file_size = 2*DENTRY_SIZE;
+        new_inode->block_idx_arr[0] = blocks[num_blocks - 1];
+    } else {
+        new_inode->file_size = 0;
     }
-    
-    // return 0 if we read up to the end of the file
-    if (offset + bytes_read == curr_inode->file_size) {
-        return 0;
-    } else { // otherwise return number of bytes read
-        return bytes_read;  
+
+    // the new blocks reach the device before the metadata that points at them
+    if (fsys_sync_meta(sb) == -1) {
+        for (i = 0; i < num_blocks; i++) {
+            fsys_free_dblock(sb, blocks[i]);
+        }
+        restore_flags(save);
+        return -1;
+    }
+
+    journal_commit(&sb->journal);
+
+    MAP_SET(sb->inode_used_map, inode);
+    MAP_CLEAR(sb->inode_bad_map, inode);
+    if (type == DIRECTORY_FILE_TYPE) {
+        MAP_SET(sb->dir_inode_map, inode);
     }
+    fsys_index_drop(sb, dir);
+    fsys_index_drop(sb, inode);
+
+    restore_flags(save);
+    return 0;
 }
 
+/* fsys_create - creates an empty regular file
+ * 
+ * Inputs: vfs - instance of the image
+ *         start - directory a relative path begins at
+ *         path - path of the file, its last component is 1 to 32 characters
+ * Outputs: 0 for success, -1 if the name is taken or invalid, or there is no room
+ * Side Effects: adds a dentry to the parent directory, allocates an inode
+ */
+int32_t fsys_create(vfs_sb_t* vfs, uint32_t start, const uint8_t* path) {
+    return fsys_add_entry((fsys_sb_t*)vfs->fs_data, start, path, REGULAR_FILE_TYPE);
+}
 
-int32_t get_file_length(char* fname) {
-    inode_t* inode_ptr;     /* pointer to inode in disk */
-    dentry_t dentry;        /* dentry to fill when we find the file */
+/* fsys_mkdir - creates an empty directory holding only "." and ".."
+ * 
+ * Inputs: vfs - instance of the image
+ *         start - directory a relative path begins at
+ *         path - path of the directory, its last component is 1 to 32 characters
+ * Outputs: 0 for success, -1 if the name is taken or invalid, or there is no room
+ * Side Effects: adds a dentry to the parent directory, allocates an inode and a block
+ */
+int32_t fsys_mkdir(vfs_sb_t* vfs, uint32_t start, const uint8_t* path) {
+    return fsys_add_entry((fsys_sb_t*)vfs->fs_data, start, path, DIRECTORY_FILE_TYPE);
+}
 
-    // try to find the file
-    if (read_dentry_by_name((uint8_t*)fname, &dentry) == -1) {
+/* fsys_unlink - removes a regular file or an empty directory
+ *      root dentries move down one slot to keep directory order, in a subdirectory
+ *      the last dentry moves into the hole so only one block changes
+ *      the dentry removal and the emptied inode commit together through the journal
+ * 
+ * Inputs: vfs - instance of the image
+ *         start - directory a relative path begins at
+ *         path - path of the file
+ * Outputs: 0 for success, -1 if the file does not exist, is the rtc, is open, is mapped by a
+ *          running process, or is a directory that is not empty or is the current directory of a process
+ * Side Effects: frees the inode and its data blocks, may free the last block of the parent
+ */
+int32_t fsys_unlink(vfs_sb_t* vfs, uint32_t start, const uint8_t* path) {
+    fsys_sb_t* sb = (fsys_sb_t*)vfs->fs_data;   /* image of the instance */
+    uint32_t dir;                   /* parent directory */
+    char name[FILENAME_LEN + 1];    /* name of the file */
+    int32_t idx;                    /* dentry index of the file */
+    uint32_t last;                  /* index of the last dentry of the parent */
+    dentry_t* entry;                /* dentry of the file */
+    boot_dentry_t* new_boot;        /* journal copy of the boot block */
+    dentry_t* new_dir;              /* directory in the journal copy */
+    inode_t* new_dir_inode;         /* journal copy of the parent inode */
+    dentry_t* new_dentry;           /* journal copy of the hole */
+    inode_t* new_inode;             /* journal copy of the inode */
+    uint32_t inode;                 /* inode of the file */
+    uint32_t num_used;              /* number of blocks the file used */
+    uint32_t free_block;            /* emptied last block of the parent, MAX_DBLOCKS for none */
+    uint32_t i;                     /* loop index */
+    uint32_t save;                  /* variable to store flags */
+
+    if (path == NULL || path[0] == '\0') {
         return -1;
     }
 
-    // check the file type is a normal file
-    if (dentry.file_type != REGULAR_FILE_TYPE) { 
+    cli_and_save(save);
+    fsys_wait_writer(sb, save);
+
+    if (!sb->writable || fsys_walk(sb, start, path, &dir, name) == -1 || name[0] == '\0' ||
+        strncmp(name, ".", FILENAME_LEN) == 0 || strncmp(name, "..", FILENAME_LEN) == 0 ||
+        (idx = fsys_dir_lookup(sb, dir, name)) == -1) {
+        restore_flags(save);
         return -1;
     }
 
-    // check that inode number is in range
-    if (dentry.inode_idx >= boot_block->num_inodes) {
+    entry = fsys_dir_entry(sb, dir, idx);
+    inode = entry->inode_idx;
+    if (inode >= sb->boot_block->num_inodes || inode >= MAX_INODES ||
+        (entry->file_type != REGULAR_FILE_TYPE && entry->file_type != DIRECTORY_FILE_TYPE) ||
+        (entry->file_type == DIRECTORY_FILE_TYPE &&
+         (inode == FSYS_ROOT_DIR || !fsys_is_dir(sb, inode) || fsys_dir_size(sb, inode) != 2 || fsys_dir_busy(sb, inode))) ||
+        (entry->file_type == REGULAR_FILE_TYPE && !MAP_TEST(sb->inode_bad_map, inode) && fsys_file_mapped(sb, inode)) ||
+        fsys_inode_open(sb, inode)) {
+        restore_flags(save);
         return -1;
     }
+    num_used = fsys_inode_blocks(sb, inode);
+    last = fsys_dir_size(sb, dir) - 1;
+    free_block = MAX_DBLOCKS;
+
+    // the block list is walked while the inode still has its size, the free map is only
+    // in memory and nothing is allocated before the commit
+    // blocks of a bad inode stay allocated, they may belong to another file
+    if (!MAP_TEST(sb->inode_bad_map, inode)) {
+        for (i = 0; i < num_used; i++) {
+            fsys_free_dblock(sb, fsys_inode_dblock(sb, inode, i));
+        }
+        fsys_map_epoch++;
+    }
+
+    journal_begin(&sb->journal);
+
+    if (dir == FSYS_ROOT_DIR) {
+        // close the hole so directory order is kept
+        new_boot = (boot_dentry_t*)journal_get_block(&sb->journal, BOOT_BLOCK_NUM);
+        new_dir = (dentry_t*)((uint32_t)new_boot + DENTRY_SIZE);
+        for (i = idx; i + 1 < new_boot->num_dir_entries; i++) {
+            memcpy(&new_dir[i], &new_dir[i + 1], DENTRY_SIZE);
+        }
+        new_boot->num_dir_entries--;
+        memset(&new_dir[new_boot->num_dir_entries], 0, DENTRY_SIZE);
+    } else {
+        // the last dentry is read from its home block, which only changes at the commit
+        new_dir_inode = (inode_t*)journal_get_block(&sb->journal, INODE_BLOCK_NUM(dir));
+        if (idx != last) {
+            new_dentry = (dentry_t*)journal_get_block(&sb->journal, DBLOCK_NUM(sb, new_dir_inode->block_idx_arr[idx / DENTRIES_PER_BLOCK]));
+            memcpy(new_dentry + idx % DENTRIES_PER_BLOCK, fsys_dir_entry(sb, dir, last), DENTRY_SIZE);
+        }
+        if (last % DENTRIES_PER_BLOCK == 0) {
+            free_block = new_dir_inode->block_idx_arr[last / DENTRIES_PER_BLOCK];
+        }
+        new_dir_inode->file_size = last*DENTRY_SIZE;
+    }
+
+    new_inode = (inode_t*)journal_get_block(&sb->journal, INODE_BLOCK_NUM(inode));
+    new_inode->file_size = 0;
+
+    journal_commit(&sb->journal);
+
+    if (free_block != MAX_DBLOCKS) {
+        MAP_CLEAR(sb->dblock_used_map, free_block);
+    }
+    MAP_CLEAR(sb->inode_used_map, inode);
+    MAP_CLEAR(sb->dir_inode_map, inode);
+    fsys_index_drop(sb, dir);
+    fsys_index_drop(sb, inode);
+    fsys_zcache_drop(sb, inode);
+
+    restore_flags(save);
+    return 0;
+}
+
+/* fsys_update_readahead - adapts the read-ahead window of a file after a read
+ *      a read starting where the last one ended doubles the window each time it enters
+ *      a new block, up to FSYS_RA_MAX_BLOCKS; any other read closes the window
+ * 
+ * Inputs: file_desc_ptr - file descriptor before its position moves
+ *         new_pos - file position after the read
+ * Outputs: None
+ * Side Effects: starts reading the blocks in the window
+ */
+static void fsys_update_readahead(file_desc_t* file_desc_ptr, uint32_t new_pos) {
+    fsys_sb_t* sb = (fsys_sb_t*)file_desc_ptr->sb->fs_data;    /* image the fd was opened on */
+    uint32_t pos = file_desc_ptr->file_pos;                     /* file position before the read */
+
+    if (pos != file_desc_ptr->ra_next) {
+        file_desc_ptr->ra_blocks = 0;
+    } else if (pos == 0 || pos / DISK_BLOCK_SIZE != new_pos / DISK_BLOCK_SIZE) {
+        if (file_desc_ptr->ra_blocks == 0) {
+            file_desc_ptr->ra_blocks = FSYS_RA_MIN_BLOCKS;
+        } else {
+            file_desc_ptr->ra_blocks = (file_desc_ptr->ra_blocks >= FSYS_RA_MAX_BLOCKS / 2) ? FSYS_RA_MAX_BLOCKS : file_desc_ptr->ra_blocks * 2;
+        }
+
+        // the block holding new_pos is already cached unless new_pos starts it
+        fsys_readahead(sb, file_desc_ptr->inode_num, (new_pos + DISK_BLOCK_SIZE - 1) / DISK_BLOCK_SIZE, file_desc_ptr->ra_blocks,
+                       &file_desc_ptr->map_cache);
+    }
 
-    // get pointer to inode
-    inode_ptr = &inodes_arr[dentry.inode_idx];
-    return inode_ptr->file_size;
+    file_desc_ptr->ra_next = new_pos;
 }
 
 /* file_read - file read syscall
@@ -215,12 +2057,18 @@ int32_t get_file_length(char* fname) {
  * Inputs: fd - index of file descriptor
  *         buf - buffer to fill
  *         nbytes - number of bytes to read
- * Outputs: number of bytes read
+ * Outputs: number of bytes read, -1 if the file is no longer in use or the read failed
  * Side Effects: fills buf, increments file position in file
  */
 int32_t file_read(int32_t fd, void* buf, int32_t nbytes) {
-    file_desc_t* file_desc_ptr = &(current_PCB->file_desc_arr[fd]); /* current file desciptor */
-    inode_t* inode_ptr = &inodes_arr[file_desc_ptr->inode_num];  /* current inode */
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* current file desciptor */
+    fsys_sb_t* sb = (fsys_sb_t*)file_desc_ptr->sb->fs_data;         /* image the fd was opened on */
+    inode_t* inode_ptr = &sb->inodes_arr[file_desc_ptr->inode_num]; /* current inode */
+
+    // the file was unlinked under the fd
+    if (!MAP_TEST(sb->inode_used_map, file_desc_ptr->inode_num)) {
+        return -1;
+    }
 
     // return 0 when file position in file is already past file size
     if (file_desc_ptr->file_pos >= inode_ptr->file_size) {
@@ -233,24 +2081,359 @@ int32_t file_read(int32_t fd, void* buf, int32_t nbytes) {
     }
 
     // read data and increment file position in file descriptor
-    read_data(file_desc_ptr->inode_num, file_desc_ptr->file_pos, buf, nbytes);
+    if (fsys_read_data(sb, file_desc_ptr->inode_num, file_desc_ptr->file_pos, buf, nbytes, &file_desc_ptr->map_cache) == -1) {
+        return -1;
+    }
+    fsys_update_readahead(file_desc_ptr, file_desc_ptr->file_pos + nbytes);
     file_desc_ptr->file_pos += nbytes;
 
     // return number of bytes read
     return nbytes;
 }
 
+/* file_pread - reads from a file at a given offset
+ *      fd is already verified to be an open regular file by the pread syscall
+ * 
+ * Inputs: fd - index of file descriptor
+ *         buf - buffer to fill
+ *         nbytes - number of bytes to read
+ *         offset - byte of the file to start at
+ * Outputs: number of bytes read, 0 past the end of the file, -1 on failure
+ * Side Effects: fills buf, the file position and read-ahead window are left alone
+ */
+int32_t file_pread(int32_t fd, void* buf, int32_t nbytes, uint32_t offset) {
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* current file desciptor */
+    fsys_sb_t* sb = (fsys_sb_t*)file_desc_ptr->sb->fs_data;         /* image the fd was opened on */
+    inode_t* inode_ptr = &sb->inodes_arr[file_desc_ptr->inode_num]; /* current inode */
+
+    if (buf == NULL || nbytes < 0 || !MAP_TEST(sb->inode_used_map, file_desc_ptr->inode_num)) {
+        return -1;
+    }
+    if (offset >= inode_ptr->file_size) {
+        return 0;
+    }
+
+    // copy up till the end of the file
+    if (nbytes > inode_ptr->file_size - offset) {
+        nbytes = inode_ptr->file_size - offset;
+    }
+
+    // the block map cache only remembers a block, any offset may use it
+    if (fsys_read_data(sb, file_desc_ptr->inode_num, offset, buf, nbytes, &file_desc_ptr->map_cache) == -1) {
+        return -1;
+    }
+    return nbytes;
+}
+
+/* file_lseek - moves the file position
+ *      fd is already verified to be an open regular file by the lseek syscall
+ * 
+ * Inputs: fd - index of file descriptor
+ *         offset - bytes to move by
+ *         whence - SEEK_SET, SEEK_CUR or SEEK_END
+ * Outputs: new file position, -1 for a bad whence or a position outside [0, FSYS_MAX_POS]
+ * Side Effects: sets the file position; a later write past the end fills the gap with 0s
+ */
+int32_t file_lseek(int32_t fd, int32_t offset, int32_t whence) {
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* current file desciptor */
+    fsys_sb_t* sb = (fsys_sb_t*)file_desc_ptr->sb->fs_data;         /* image the fd was opened on */
+    uint32_t pos;                                                   /* new file position */
+
+    switch (whence) {
+        case SEEK_SET:
+            pos = 0;
+            break;
+        case SEEK_CUR:
+            pos = file_desc_ptr->file_pos;
+            break;
+        case SEEK_END:
+            pos = sb->inodes_arr[file_desc_ptr->inode_num].file_size;
+            break;
+        default:
+            return -1;
+    }
+
+    // stay within [0, FSYS_MAX_POS], 0 - offset is the distance back even for the most negative offset
+    if (offset < 0) {
+        if (pos < (uint32_t)0 - (uint32_t)offset || FSYS_MAX_POS < pos - ((uint32_t)0 - (uint32_t)offset)) {
+            return -1;
+        }
+        pos -= (uint32_t)0 - (uint32_t)offset;
+    } else {
+        if (pos > FSYS_MAX_POS - (uint32_t)offset) {
+            return -1;
+        }
+        pos += offset;
+    }
+
+    // file_read closes the read-ahead window when the next read does not start at ra_next
+    file_desc_ptr->file_pos = pos;
+    return (int32_t)pos;
+}
+
+/* fsys_alloc_indirect - allocates empty indirect blocks
+ *      they are written in place, nothing points at them until the inode commits
+ * 
+ * Inputs: sb - mounted image
+ *         count - number of blocks
+ *         blocks - array to fill with the data block indices
+ * Outputs: 0 for success, -1 if there are not enough free blocks
+ * Side Effects: marks the blocks used and fills them with 0s
+ */
+static int32_t fsys_alloc_indirect(fsys_sb_t* sb, uint32_t count, uint32_t* blocks) {
+    uint32_t i; /* loop index */
+
+    // any free run will do, the hint is kept for the file data
+    if (fsys_alloc_blocks(sb, MAX_DBLOCKS, count, blocks) == -1) {
+        return -1;
+    }
+    for (i = 0; i < count; i++) {
+        if (sb->dev != NULL) {
+            bcache_forget(sb->dev, DBLOCK_NUM(sb, blocks[i]));
+        }
+        memset((void*)DBLOCK_ADDR(sb, blocks[i]), 0, DISK_BLOCK_SIZE);
+        fsys_meta_written(sb, blocks[i]);
+    }
+    return 0;
+}
+
+/* fsys_map_slots - finds where the indices of new blocks of a growing file go
+ *      an indirect block is allocated when the first block it maps is reached; its
+ *      entries are written in place since nothing reads them past the old file size
+ * 
+ * Inputs: sb - mounted image
+ *         new_inode - journal copy of the inode
+ *         block - first file block to map, every block before it is mapped
+ *         num_slots - filled with the number of indices from block to the end of the same array
+ * Outputs: pointer to the index of block, NULL if an indirect block could not be allocated
+ * Side Effects: may allocate indirect blocks and point the journal copy at them
+ */
+static uint32_t* fsys_map_slots(fsys_sb_t* sb, inode_t* new_inode, uint32_t block, uint32_t* num_slots) {
+    uint32_t rel;       /* block index past the blocks the indirect block maps */
+    uint32_t* leaves;   /* indirect blocks the double-indirect block lists */
+    uint32_t meta[2];   /* new indirect block, then a new double-indirect block */
+
+    if (block < INODE_DIRECT_BLOCKS) {
+        *num_slots = INODE_DIRECT_BLOCKS - block;
+        return &new_inode->block_idx_arr[block];
+    }
+
+    if (block < INODE_DIRECT_BLOCKS + INDIRECT_ENTRIES) {
+        if (block == INODE_DIRECT_BLOCKS) {
+            if (fsys_alloc_indirect(sb, 1, meta) == -1) {
+                return NULL;
+            }
+            new_inode->indirect = meta[0];
+        }
+        *num_slots = INODE_DIRECT_BLOCKS + INDIRECT_ENTRIES - block;
+        fsys_meta_written(sb, new_inode->indirect);
+        return (uint32_t*)DBLOCK_ADDR(sb, new_inode->indirect) + block - INODE_DIRECT_BLOCKS;
+    }
+
+    rel = block - INODE_DIRECT_BLOCKS - INDIRECT_ENTRIES;
+    if (rel % INDIRECT_ENTRIES == 0) {
+        if (fsys_alloc_indirect(sb, 1 + (rel == 0), meta) == -1) {
+            return NULL;
+        }
+        if (rel == 0) {
+            new_inode->double_indirect = meta[1];
+        }
+        ((uint32_t*)DBLOCK_ADDR(sb, new_inode->double_indirect))[rel / INDIRECT_ENTRIES] = meta[0];
+        fsys_meta_written(sb, new_inode->double_indirect);
+    }
+    leaves = (uint32_t*)DBLOCK_ADDR(sb, new_inode->double_indirect);
+    *num_slots = INDIRECT_ENTRIES - rel % INDIRECT_ENTRIES;
+    fsys_meta_written(sb, leaves[rel / INDIRECT_ENTRIES]);
+    return (uint32_t*)DBLOCK_ADDR(sb, leaves[rel / INDIRECT_ENTRIES]) + rel % INDIRECT_ENTRIES;
+}
+
+/* fsys_write_abort - gives up a file write before its commit
+ *      the journal copy of the inode is never committed, so only the blocks allocated for the
+ *      write have to be freed; data already written to blocks the file keeps is not undone
+ * 
+ * Inputs: sb - mounted image
+ *         new_inode - journal copy of the inode
+ *         old_blocks - blocks the file used before the write
+ *         data_end - file blocks mapped up to
+ *         meta_end - file blocks whose indirect blocks were allocated up to
+ *         save - flags saved by file_write
+ * Outputs: None
+ * Side Effects: frees the new blocks, lets other updates of the image start, restores the flags
+ */
+static void fsys_write_abort(fsys_sb_t* sb, inode_t* new_inode, uint32_t old_blocks, uint32_t data_end, uint32_t meta_end, uint32_t save) {
+    uint32_t rel;   /* block index past the blocks the indirect block maps */
+    uint32_t i;     /* loop index */
+
+    for (i = old_blocks; i < data_end; i++) {
+        fsys_free_dblock(sb, fsys_bmap(sb, new_inode, i, NULL));
+    }
+
+    // indirect blocks were allocated where the first block they map is
+    for (i = old_blocks; i < meta_end; i++) {
+        if (i == INODE_DIRECT_BLOCKS) {
+            fsys_free_dblock(sb, new_inode->indirect);
+        } else if (i >= INODE_DIRECT_BLOCKS + INDIRECT_ENTRIES) {
+            rel = i - INODE_DIRECT_BLOCKS - INDIRECT_ENTRIES;
+            if (rel % INDIRECT_ENTRIES == 0) {
+                fsys_free_dblock(sb, fsys_indirect_entry(sb, new_inode->double_indirect, rel / INDIRECT_ENTRIES));
+            }
+            if (rel == 0) {
+                fsys_free_dblock(sb, new_inode->double_indirect);
+            }
+        }
+    }
+
+    sb->writing = 0;
+    restore_flags(save);
+}
+
 /* file_write - file write syscall
- *      attempt to write onto file, always fails for read-only filesystem
+ *      fd is already verified to be in use by write syscall
+ *      writes at the file position, overwriting the bytes already there and appending
+ *      past the end of the file; a gap between the end of the file and the position reads as 0s
+ *      file data is written first, then the new size and block list commit through the journal
+ *      compressed files are read-only
  * 
- * Inputs: fd - unused
- *         buf - unused
- *         nbytes - unused
- * Outputs: -1 for failure
- * Side Effects: None
+ * Inputs: fd - index of file descriptor
+ *         buf - buffer to write from
+ *         nbytes - number of bytes to write
+ * Outputs: number of bytes written, -1 for failure
+ * Side Effects: may allocate data blocks, increments file position in file, may switch to another
+ *               process while the blocks of an image on a device are written
  */
 int32_t file_write(int32_t fd, const void* buf, int32_t nbytes) {
-    return -1; // read-only file system
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* current file desciptor */
+    fsys_sb_t* sb = (fsys_sb_t*)file_desc_ptr->sb->fs_data;         /* image the fd was opened on */
+    uint32_t inode = file_desc_ptr->inode_num;  /* inode of the file */
+    uint32_t pos = file_desc_ptr->file_pos;     /* first byte to write */
+    uint32_t end;                               /* byte after the last byte to write */
+    uint32_t old_size;                          /* file size before the write */
+    uint32_t old_blocks;                        /* blocks the file used before the write */
+    uint32_t new_blocks;                        /* blocks the file uses after the write */
+    inode_t* new_inode;                         /* journal copy of the inode */
+    uint32_t* slots;                            /* indices of the blocks being allocated */
+    uint32_t num_slots;                         /* indices left in the same array */
+    uint32_t hint;                              /* data block the new blocks should follow */
+    uint32_t bytes_to_copy;                     /* number of bytes to copy into the current block */
+    uint32_t bytes_written;                     /* total number of bytes written so far */
+    uint32_t dblock;                            /* data block being written */
+    int32_t ret;                                /* result of writing the blocks to the device */
+    uint32_t i;                                 /* loop index */
+    uint32_t save;                              /* variable to store flags */
+
+    if (buf == NULL || nbytes < 0) {
+        return -1;
+    }
+    if (nbytes == 0) {
+        return 0;
+    }
+
+    // the block map covers any 32-bit size
+    end = pos + nbytes;
+    if (end < pos) {
+        return -1;
+    }
+
+    cli_and_save(save);
+    fsys_wait_writer(sb, save);
+
+    if (!sb->writable || inode >= sb->boot_block->num_inodes || inode >= MAX_INODES || MAP_TEST(sb->inode_bad_map, inode) ||
+        !MAP_TEST(sb->inode_used_map, inode) || (sb->inodes_arr[inode].flags & INODE_COMPRESSED)) {
+        restore_flags(save);
+        return -1;
+    }
+
+    old_size = sb->inodes_arr[inode].file_size;
+    old_blocks = old_size / DISK_BLOCK_SIZE + (old_size % DISK_BLOCK_SIZE != 0);
+    new_blocks = (end > old_size) ? end / DISK_BLOCK_SIZE + (end % DISK_BLOCK_SIZE != 0) : old_blocks;
+
+    // other updates of the image wait until the commit, the lock is dropped while syncing
+    sb->writing = 1;
+    for (i = 0; i < MAX_DBLOCKS / 32; i++) {
+        sb->dblock_write_map[i] = 0;
+    }
+
+    journal_begin(&sb->journal);
+    new_inode = (inode_t*)journal_get_block(&sb->journal, INODE_BLOCK_NUM(inode));
+
+    // grow the file right after its last block when possible, one index array at a time
+    hint = (old_blocks != 0) ? fsys_bmap(sb, new_inode, old_blocks - 1, NULL) : MAX_DBLOCKS;
+    for (i = old_blocks; i < new_blocks; i += num_slots) {
+        slots = fsys_map_slots(sb, new_inode, i, &num_slots);
+        if (slots == NULL) {
+            fsys_write_abort(sb, new_inode, old_blocks, i, i, save);
+            return -1;
+        }
+        if (num_slots > new_blocks - i) {
+            num_slots = new_blocks - i;
+        }
+        if (fsys_alloc_blocks(sb, hint, num_slots, slots) == -1) {
+            fsys_write_abort(sb, new_inode, old_blocks, i, i + 1, save);
+            return -1;
+        }
+        hint = slots[num_slots - 1];
+    }
+
+    // new blocks and the unused tail of the old last block read as 0s
+    for (i = old_blocks; i < new_blocks; i++) {
+        dblock = fsys_bmap(sb, new_inode, i, NULL);
+        if (fsys_write_block(sb, dblock, 0, NULL, DISK_BLOCK_SIZE) == -1) {
+            fsys_write_abort(sb, new_inode, old_blocks, new_blocks, new_blocks, save);
+            return -1;
+        }
+        MAP_SET(sb->dblock_write_map, dblock);
+    }
+    if (end > old_size && old_size % DISK_BLOCK_SIZE != 0) {
+        dblock = fsys_bmap(sb, new_inode, old_blocks - 1, NULL);
+        if (fsys_write_block(sb, dblock, old_size % DISK_BLOCK_SIZE, NULL, DISK_BLOCK_SIZE - old_size % DISK_BLOCK_SIZE) == -1) {
+            fsys_write_abort(sb, new_inode, old_blocks, new_blocks, new_blocks, save);
+            return -1;
+        }
+        MAP_SET(sb->dblock_write_map, dblock);
+    }
+
+    // write the data before the metadata that points at it
+    bytes_written = 0;
+    while (bytes_written < (uint32_t)nbytes) {
+        bytes_to_copy = DISK_BLOCK_SIZE - (pos + bytes_written) % DISK_BLOCK_SIZE;
+        if (bytes_to_copy > nbytes - bytes_written) {
+            bytes_to_copy = nbytes - bytes_written;
+        }
+        dblock = fsys_bmap(sb, new_inode, (pos + bytes_written) / DISK_BLOCK_SIZE, NULL);
+        if (fsys_write_block(sb, dblock, (pos + bytes_written) % DISK_BLOCK_SIZE, (uint8_t*)buf + bytes_written, bytes_to_copy) == -1) {
+            fsys_write_abort(sb, new_inode, old_blocks, new_blocks, new_blocks, save);
+            return -1;
+        }
+        MAP_SET(sb->dblock_write_map, dblock);
+        bytes_written += bytes_to_copy;
+    }
+
+    // the data and the indirect blocks have to reach the device before the commit; only the
+    // blocks of this write are synced, with interrupts back on so other processes keep running
+    if (sb->dev != NULL) {
+        restore_flags(save);
+        ret = bcache_sync_blocks(sb->dev, sb->dblock_write_map, DBLOCK_NUM(sb, 0), fsys_num_dblocks(sb));
+        if (ret == 0) {
+            ret = fsys_sync_meta(sb);
+        }
+        cli();
+        if (ret == -1) {
+            fsys_write_abort(sb, new_inode, old_blocks, new_blocks, new_blocks, save);
+            return -1;
+        }
+    }
+
+    // commit the new size and block list
+    if (end > old_size) {
+        new_inode->file_size = end;
+    }
+    journal_commit(&sb->journal);
+    sb->writing = 0;
+
+    restore_flags(save);
+
+    file_desc_ptr->file_pos = end;
+    return nbytes;
 }
 
 /* file_open - file open syscall
@@ -279,7 +2462,7 @@ int32_t file_close(int32_t fd) {
 /* directory_read - directory read syscall
  *      fd is already verified to be in use by read syscall
  *      attempt to read the next file name in directory, copies file name to given buffer
- *      fails if no directory is open
+ *      the directory is the one the fd was opened on, the root or a subdirectory
  * 
  * Inputs: fd - index of file descriptor
  *         buf - buffer to fill
@@ -288,26 +2471,81 @@ int32_t file_close(int32_t fd) {
  * Side Effects: fills buf, increments offset in file
  */
 int32_t directory_read(int32_t fd, void* buf, int32_t nbytes) {
-    file_desc_t* file_desc_ptr = &(current_PCB->file_desc_arr[fd]); /* pointer to current file desciptor */
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* pointer to current file desciptor */
+    fsys_sb_t* sb = (fsys_sb_t*)file_desc_ptr->sb->fs_data;         /* image the fd was opened on */
+    uint32_t dir = file_desc_ptr->inode_num;                        /* directory the fd was opened on */
+    uint32_t save;                                                  /* variable to store flags */
 
     // only copy up to 32 bytes of the file name
     if (nbytes > 32) {
         nbytes = 32;
     }
 
-    // return 0 when idx in directory is already past file size
-    if (file_desc_ptr->file_pos >= boot_block->num_dir_entries) {
+    cli_and_save(save);
+
+    // return 0 when idx in directory is already past file size, or the directory was removed
+    if (!fsys_is_dir(sb, dir) || file_desc_ptr->file_pos >= fsys_dir_size(sb, dir)) {
+        restore_flags(save);
         return 0;
     }
     
     // copy file name and increment file (directory) position
-    strncpy(buf, file_dir_arr[file_desc_ptr->file_pos].file_name, nbytes);
+    strncpy(buf, fsys_dir_entry(sb, dir, file_desc_ptr->file_pos)->file_name, nbytes);
     file_desc_ptr->file_pos++;
 
+    restore_flags(save);
+
     // return number of bytes read
     return nbytes;
 }
 
+/* directory_getdents - fills a buffer with the next dentries of a directory
+ *      fd is already verified to be an open directory by the getdents syscall
+ * 
+ * Inputs: fd - index of file descriptor
+ *         buf - buffer to fill with dirent_t records
+ *         nbytes - size of buf
+ * Outputs: bytes filled, 0 at the end of the directory, -1 if buf cannot hold one record
+ * Side Effects: fills buf, moves the directory position past the returned dentries
+ */
+int32_t directory_getdents(int32_t fd, void* buf, int32_t nbytes) {
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* pointer to current file desciptor */
+    fsys_sb_t* sb = (fsys_sb_t*)file_desc_ptr->sb->fs_data;         /* image the fd was opened on */
+    uint32_t dir = file_desc_ptr->inode_num;                        /* directory the fd was opened on */
+    dirent_t* dirent = (dirent_t*)buf;                              /* next record to fill */
+    dentry_t* dentry;                                               /* dentry being copied */
+    stat_t st;                                                      /* size of the dentry's file */
+    uint32_t num_entries;                                           /* dentries in the directory */
+    uint32_t save;                                                  /* variable to store flags */
+
+    if (buf == NULL || nbytes < (int32_t)sizeof(dirent_t)) {
+        return -1;
+    }
+
+    cli_and_save(save);
+
+    // the directory was removed, nothing left to read
+    num_entries = fsys_is_dir(sb, dir) ? fsys_dir_size(sb, dir) : 0;
+
+    while (file_desc_ptr->file_pos < num_entries && (uint8_t*)(dirent + 1) <= (uint8_t*)buf + nbytes) {
+        dentry = fsys_dir_entry(sb, dir, file_desc_ptr->file_pos);
+        memcpy(dirent->file_name, dentry->file_name, FILENAME_LEN);
+        dirent->file_type = dentry->file_type;
+        dirent->inode_idx = dentry->inode_idx;
+
+        // a bad inode reads as empty
+        fsys_stat(&sb->vfs, dentry->file_type, dentry->inode_idx, &st);
+        dirent->file_size = st.file_size;
+
+        file_desc_ptr->file_pos++;
+        dirent++;
+    }
+
+    restore_flags(save);
+
+    return (uint8_t*)dirent - (uint8_t*)buf;
+}
+
 /* directory_write - directory write syscall
  *      attempt to write onto directory, always fails for read-only file system
  * 
@@ -6,9 +6,62 @@
 #define _FSYS_H
 
 #include "../lib.h"
+#include "blkdev.h"
 
 #define DENTRY_SIZE             64
 #define DISK_BLOCK_SIZE         4096
+#define MAX_DENTRIES            63
+#define FILENAME_LEN            32
+
+/* inode and data block limits */
+#define MAX_INODES              1024    /* inodes tracked by the mount-time validation */
+#define INODE_DIRECT_BLOCKS     1020    /* data block indices in an inode */
+#define INDIRECT_ENTRIES        (DISK_BLOCK_SIZE / 4)   /* data block indices in an indirect block */
+#define FSYS_NO_BLOCK           0xFFFFFFFF  /* block map result for a bad indirect block */
+#define MAX_DBLOCKS             4096    /* data blocks tracked by the free-block bitmap */
+
+/* images mounted at once */
+#define FSYS_MAX_IMAGES         3
+
+/* directories */
+#define FSYS_ROOT_DIR           0       /* the root directory is the boot block, its "." dentry uses inode 0 */
+#define DENTRIES_PER_BLOCK      (DISK_BLOCK_SIZE / DENTRY_SIZE)
+#define DIR_MAX_ENTRIES         512     /* dentries in a subdirectory, "." and ".." included */
+#define MAX_PATH_LEN            128     /* longest path an executable can be given by */
+
+/* per-directory name hash index, power of 2 so the hash can be masked */
+#define DIR_HASH_SIZE           128
+#define DIR_HASH_END            0xFFFF  /* end of a hash chain */
+#define DIR_INDEX_SLOTS         5       /* the root index plus the most recently used subdirectories */
+
+/* inode flags */
+#define INODE_COMPRESSED        0x1     /* file blocks are LZ4 compressed, the inode is read-only */
+
+/*
+ * A compressed file keeps one LZ4 block per 4 KB file block, packed back to back
+ * in a contiguous run of data blocks. Its block_idx_arr holds the run and the
+ * offset table instead of block indices: entry ZINODE_OFFSETS + i is where file
+ * block i starts in the packed stream, the entry after the last file block is the
+ * end of the stream. A file block whose packed length is its full length is
+ * stored uncompressed.
+ */
+#define ZINODE_DBLOCK           0       /* first data block of the run */
+#define ZINODE_NUM_DBLOCKS      1       /* data blocks in the run */
+#define ZINODE_OFFSETS          2       /* first entry of the offset table */
+#define ZINODE_MAX_BLOCKS       (INODE_DIRECT_BLOCKS - ZINODE_OFFSETS - 1)
+
+/* decompressed blocks kept around for reads that do not start at a block */
+#define FSYS_ZCACHE_SLOTS       8
+
+/* read-ahead window of sequential file reads, in blocks, powers of 2 */
+#define FSYS_RA_MIN_BLOCKS      2
+#define FSYS_RA_MAX_BLOCKS      16
+
+/* lseek whence */
+#define SEEK_SET                0       /* from the start of the file */
+#define SEEK_CUR                1       /* from the file position */
+#define SEEK_END                2       /* from the end of the file */
+#define FSYS_MAX_POS            0x7FFFFFFF  /* farthest lseek can move, so the result stays positive */
 
 #define RTC_FILE_TYPE           0
 #define DIRECTORY_FILE_TYPE     1
@@ -19,7 +72,9 @@ typedef struct boot_dentry_t {
     uint32_t num_dir_entries;
     uint32_t num_inodes;
     uint32_t num_dblocks;
-    uint8_t reserved_52[52];
+    uint32_t journal_magic;     /* JOURNAL_MAGIC once a journal was formatted, the image is writable */
+    uint32_t journal_dblock;    /* data block index of the journal header */
+    uint8_t reserved_44[44];
 } boot_dentry_t;
 
 /* single dentry struct */
@@ -30,41 +85,122 @@ typedef struct dentry_t {
     uint8_t reserved_24[24];
 } dentry_t;
 
-/* inode struct containing file size and block idxs */
+/* stat/fstat result */
+typedef struct stat_t {
+    uint32_t file_type;
+    uint32_t inode_idx;
+    uint32_t file_size;         /* bytes of a regular file or directory, 0 for the RTC */
+    uint32_t num_blocks;        /* data blocks used, indirect blocks included, 0 for the root and the RTC */
+} stat_t;
+
+/* getdents record, a dentry with the size of its file */
+typedef struct dirent_t {
+    char file_name[32];         /* not NUL terminated when the name is 32 characters */
+    uint32_t file_type;
+    uint32_t inode_idx;
+    uint32_t file_size;         /* bytes of a regular file or directory, 0 for the RTC */
+} dirent_t;
+
+/*
+ * File block i is in data block block_idx_arr[i] for the first INODE_DIRECT_BLOCKS
+ * blocks, then in entry i - INODE_DIRECT_BLOCKS of the indirect block. The
+ * double-indirect block lists indirect blocks for every block after that, which
+ * covers any 32-bit file size. Only the fields the file size needs are used.
+ */
 typedef struct inode_t {
     uint32_t file_size;
-    uint32_t block_idx_arr[1023];
+    uint32_t block_idx_arr[INODE_DIRECT_BLOCKS];
+    uint32_t indirect;          /* data block of indices for the blocks after the direct ones */
+    uint32_t double_indirect;   /* data block of indirect block indices for the rest */
+    uint32_t flags;             /* INODE_* flags, 0 in images that predate them */
 } inode_t;
 
-/*initializes file system with memory address to disk*/
-void init_fsys(uint32_t starting_addr);
+struct vfs_sb_t;
+
+/*initializes file system with memory address to disk, returns the instance to mount*/
+struct vfs_sb_t* init_fsys(uint32_t starting_addr);
 
-/*reads file dentry by user readable name*/
+/* loads an image from a block device into memory, returns the instance to mount */
+struct vfs_sb_t* fsys_load_disk(blk_device_t* dev, uint32_t addr, uint32_t max_size);
+
+/*reads file dentry by user readable name, from the root of the first image*/
 int32_t read_dentry_by_name(uint8_t* fname, dentry_t* dentry);
 
-/*reads file dentry by index number*/
+/*reads file dentry by index number, from the root of the first image*/
 int32_t read_dentry_by_index(uint32_t index, dentry_t* dentry);
 
-/*reads data segment indicated by offset and lengthinto parameterized buffer from a specified inode*/
+/*reads data segment indicated by offset and lengthinto parameterized buffer from a specified inode of the first image*/
 int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length);
 
 /* get file length */
 int32_t get_file_length(char* fname);
 
-/* file operations jumptable struct */
+/* gets the length of a regular file of the first image by its inode */
+int32_t get_inode_length(uint32_t inode);
+
+/* VFS operations of an image, see vfs_ops_t */
+
+/* reads file dentry by a '/' separated path, relative to start unless it starts with '/' */
+int32_t fsys_lookup(struct vfs_sb_t* vfs, uint32_t start, const uint8_t* path, dentry_t* dentry);
+
+/* checks that an inode is still a directory */
+uint32_t fsys_check_dir(struct vfs_sb_t* vfs, uint32_t inode);
+
+/* fills a stat_t for an inode of the given file type */
+int32_t fsys_stat(struct vfs_sb_t* vfs, uint32_t file_type, uint32_t inode, stat_t* st);
+
+/* reads data of a specified inode */
+int32_t fsys_read_inode(struct vfs_sb_t* vfs, uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length);
+
+/* gets the address of one of a file's data blocks */
+int32_t fsys_block_addr(struct vfs_sb_t* vfs, uint32_t inode, uint32_t block, uint32_t* addr);
+
+/* creates an empty regular file */
+int32_t fsys_create(struct vfs_sb_t* vfs, uint32_t start, const uint8_t* path);
+
+/* creates an empty directory */
+int32_t fsys_mkdir(struct vfs_sb_t* vfs, uint32_t start, const uint8_t* path);
+
+/* removes a regular file or an empty directory */
+int32_t fsys_unlink(struct vfs_sb_t* vfs, uint32_t start, const uint8_t* path);
+
+#define MAX_IOVCNT 16       /* most segments a single readv/writev takes */
+
+/* one segment of a readv/writev */
+typedef struct iovec_t {
+    void* base;             /* user buffer of the segment */
+    int32_t len;            /* bytes in the segment */
+} iovec_t;
+
+/* file operations jumptable struct, readv/writev are optional and
+   fall back to one read/write per segment when NULL */
 typedef struct fops_jumptable_t {
     int32_t (*read)(int32_t fd, void* buf, int32_t nbytes);
     int32_t (*write)(int32_t fd, const void* buf, int32_t nbytes);
     int32_t (*open)(const uint8_t* filename);
     int32_t (*close)(int32_t fd);
+    int32_t (*readv)(int32_t fd, const iovec_t* iov, int32_t iovcnt);
+    int32_t (*writev)(int32_t fd, const iovec_t* iov, int32_t iovcnt);
 } fops_jumptable_t;
 
-/* file descriptor struct */
+/* last indirect block the reads of a file descriptor went through */
+typedef struct fsys_map_cache_t {
+    uint32_t epoch;         /* block map epoch it was filled in, 0 when empty */
+    uint32_t first;         /* first file block the indirect block maps */
+    uint32_t dblock;        /* data block of the indirect block */
+} fsys_map_cache_t;
+
+/* open file struct, shared by the fds dup makes */
 typedef struct file_desc_t {
     fops_jumptable_t* fops_table_ptr;
     uint32_t inode_num;
     uint32_t file_pos;
     uint32_t flags;
+    uint32_t ra_next;       /* file position a sequential read would start at */
+    uint32_t ra_blocks;     /* read-ahead window in blocks, 0 when reads are not sequential */
+    fsys_map_cache_t map_cache; /* saves the block map walk of sequential reads past the direct blocks */
+    struct vfs_sb_t* sb;    /* instance the fd was opened on, NULL for stdin and stdout */
+    uint32_t refs;          /* fds pointing at the open file, 0 when the entry is free */
 } file_desc_t;
 
 /* file read syscall */
@@ -73,6 +209,12 @@ int32_t file_read(int32_t fd, void* buf, int32_t nbytes);
 /* file write syscall */
 int32_t file_write(int32_t fd, const void* buf, int32_t nbytes);
 
+/* file positional read */
+int32_t file_pread(int32_t fd, void* buf, int32_t nbytes, uint32_t offset);
+
+/* file position move */
+int32_t file_lseek(int32_t fd, int32_t offset, int32_t whence);
+
 /* file open syscall */
 int32_t file_open(const uint8_t* filename);
 
@@ -82,6 +224,9 @@ int32_t file_close(int32_t fd);
 /* directory read syscall */
 int32_t directory_read(int32_t fd, void* buf, int32_t nbytes);
 
+/* directory batched read */
+int32_t directory_getdents(int32_t fd, void* buf, int32_t nbytes);
+
 /* directory write syscall */
 int32_t directory_write(int32_t fd, const void* buf, int32_t nbytes);
 
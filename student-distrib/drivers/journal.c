@@ -0,0 +1,165 @@
+#include "journal.h"
+#include "fsys.h"
+
+/* journal_block_addr - gets the address of an image block
+ * 
+ * Inputs: journal - journal of the image
+ *         block - block number from the start of the image
+ * Outputs: address of the block
+ * Side Effects: None
+ */
+static uint32_t journal_block_addr(journal_t* journal, uint32_t block) {
+    return journal->disk_base + block*DISK_BLOCK_SIZE;
+}
+
+/* journal_write_through - writes an image block from memory to the device of the image
+ *      the memory copy stays ahead of the device if the write fails, the next
+ *      transaction writes its blocks again
+ * 
+ * Inputs: journal - journal of the image
+ *         block - block number from the start of the image
+ * Outputs: None
+ * Side Effects: writes the device, if the image has one
+ */
+static void journal_write_through(journal_t* journal, uint32_t block) {
+    if (journal->dev != NULL) {
+        blk_rw(journal->dev, block*(DISK_BLOCK_SIZE / BLK_SECTOR_SIZE), DISK_BLOCK_SIZE / BLK_SECTOR_SIZE,
+               (uint8_t*)journal_block_addr(journal, block), 1);
+    }
+}
+
+/* journal_checkpoint - copies committed records to their home blocks
+ * 
+ * Inputs: journal - journal to checkpoint
+ * Outputs: None
+ * Side Effects: writes the home blocks, cleans the journal
+ */
+static void journal_checkpoint(journal_t* journal) {
+    uint32_t i; /* loop index */
+
+    for (i = 0; i < journal->header->num_records; i++) {
+        memcpy((void*)journal_block_addr(journal, journal->header->home_blocks[i]), (void*)(journal->records + i*DISK_BLOCK_SIZE), DISK_BLOCK_SIZE);
+        journal_write_through(journal, journal->header->home_blocks[i]);
+    }
+
+    // the home blocks are complete, nothing is left to replay
+    journal->header->state = JOURNAL_CLEAN;
+    journal->header->num_records = 0;
+    journal_write_through(journal, journal->header_block);
+}
+
+/* journal_format - writes an empty journal
+ * 
+ * Inputs: journal - journal of the image to fill in
+ *         disk_base_addr - base address of the disk image
+ *         journal_block - image block number of the journal header
+ *         dev - device holding the image, NULL for an image only in memory
+ * Outputs: None
+ * Side Effects: overwrites the journal header
+ */
+void journal_format(journal_t* journal, uint32_t disk_base_addr, uint32_t journal_block, blk_device_t* dev) {
+    journal->disk_base = disk_base_addr;
+    journal->header = (journal_header_t*)journal_block_addr(journal, journal_block);
+    journal->records = journal_block_addr(journal, journal_block + 1);
+    journal->header_block = journal_block;
+    journal->dev = dev;
+
+    memset(journal->header, 0, DISK_BLOCK_SIZE);
+    journal->header->state = JOURNAL_CLEAN;
+    journal->header->magic = JOURNAL_MAGIC;
+    journal_write_through(journal, journal_block);
+}
+
+/* journal_mount - attaches an existing journal
+ *      a transaction that committed before a crash is written home here
+ * 
+ * Inputs: journal - journal of the image to fill in
+ *         disk_base_addr - base address of the disk image
+ *         journal_block - image block number of the journal header
+ *         dev - device holding the image, NULL for an image only in memory
+ * Outputs: 0 for success, -1 if the block is not a journal header
+ * Side Effects: may write metadata blocks
+ */
+int32_t journal_mount(journal_t* journal, uint32_t disk_base_addr, uint32_t journal_block, blk_device_t* dev) {
+    journal->disk_base = disk_base_addr;
+    journal->header = (journal_header_t*)journal_block_addr(journal, journal_block);
+    journal->records = journal_block_addr(journal, journal_block + 1);
+    journal->header_block = journal_block;
+    journal->dev = dev;
+
+    if (journal->header->magic != JOURNAL_MAGIC || journal->header->num_records > JOURNAL_MAX_RECORDS) {
+        return -1;
+    }
+
+    // finish the interrupted transaction, copying the records again is harmless
+    if (journal->header->state == JOURNAL_COMMITTED) {
+        journal_checkpoint(journal);
+    }
+    journal->header->state = JOURNAL_CLEAN;
+    journal->header->num_records = 0;
+
+    return 0;
+}
+
+/* journal_begin - starts a transaction
+ *      must be called with interrupts disabled, until journal_commit
+ * 
+ * Inputs: journal - journal of the image to change
+ * Outputs: None
+ * Side Effects: None
+ */
+void journal_begin(journal_t* journal) {
+    journal->header->num_records = 0;
+}
+
+/* journal_get_block - gets the journal copy of a metadata block
+ *      the first call for a block copies its current contents into a record
+ * 
+ * Inputs: journal - journal of the current transaction
+ *         block - image block number of the metadata block
+ * Outputs: address of the copy to modify, NULL if the transaction is full
+ * Side Effects: may use a journal record
+ */
+void* journal_get_block(journal_t* journal, uint32_t block) {
+    uint32_t i;         /* loop index */
+    uint32_t record;    /* address of the record */
+
+    // the block is already part of this transaction
+    for (i = 0; i < journal->header->num_records; i++) {
+        if (journal->header->home_blocks[i] == block) {
+            return (void*)(journal->records + i*DISK_BLOCK_SIZE);
+        }
+    }
+
+    if (journal->header->num_records == JOURNAL_MAX_RECORDS) {
+        return NULL;
+    }
+
+    record = journal->records + journal->header->num_records*DISK_BLOCK_SIZE;
+    memcpy((void*)record, (void*)journal_block_addr(journal, block), DISK_BLOCK_SIZE);
+    journal->header->home_blocks[journal->header->num_records++] = block;
+
+    return (void*)record;
+}
+
+/* journal_commit - commits the current transaction
+ *      file data must already be written, only metadata goes through the journal
+ * 
+ * Inputs: journal - journal of the current transaction
+ * Outputs: None
+ * Side Effects: writes every record home
+ */
+void journal_commit(journal_t* journal) {
+    uint32_t i; /* loop index */
+
+    // the records reach the device before the header that makes them count
+    for (i = 0; i < journal->header->num_records; i++) {
+        journal_write_through(journal, journal->header_block + 1 + i);
+    }
+
+    // commit point, from here on a crash replays the transaction
+    journal->header->state = JOURNAL_COMMITTED;
+    journal_write_through(journal, journal->header_block);
+
+    journal_checkpoint(journal);
+}
@@ -0,0 +1,63 @@
+/* journal.h - write-ahead metadata journal for the file system
+ * vim:ts=4 noexpandtab
+ */
+#ifndef _JOURNAL_H
+#define _JOURNAL_H
+
+#include "../lib.h"
+#include "blkdev.h"
+
+#define JOURNAL_MAGIC           0x4A524E4C  /* "JRNL" */
+#define JOURNAL_MAX_RECORDS     3           /* metadata blocks one transaction can change */
+#define JOURNAL_BLOCKS          (1 + JOURNAL_MAX_RECORDS)
+
+/* journal states */
+#define JOURNAL_CLEAN           0           /* nothing to replay */
+#define JOURNAL_COMMITTED       1           /* records are complete and must reach their home blocks */
+
+/*
+ * On-disk layout, JOURNAL_BLOCKS contiguous blocks of the image:
+ *      header block - journal_header_t
+ *      record i     - new contents of home_blocks[i]
+ * A transaction copies every metadata block it changes into a record and
+ * edits the copy. Setting the header to JOURNAL_COMMITTED is the commit
+ * point; the records are then copied home and the header is cleaned. A
+ * crash before the commit point leaves the old metadata, a crash after it
+ * is finished by journal_mount replaying the records.
+ *
+ * For an image mounted from a block device, the memory copy is written
+ * through in the same order: records, then the committed header, then the
+ * home blocks, then the clean header.
+ */
+typedef struct journal_header_t {
+    uint32_t magic;                                 /* JOURNAL_MAGIC */
+    uint32_t state;                                 /* JOURNAL_CLEAN or JOURNAL_COMMITTED */
+    uint32_t num_records;                           /* records in the committed transaction */
+    uint32_t home_blocks[JOURNAL_MAX_RECORDS];      /* image block each record belongs to */
+} journal_header_t;
+
+/* journal of one mounted image */
+typedef struct journal_t {
+    uint32_t disk_base;                             /* base address of the disk image */
+    journal_header_t* header;                       /* header block of the journal */
+    uint32_t records;                               /* address of the first record block */
+    uint32_t header_block;                          /* image block number of the header */
+    blk_device_t* dev;                              /* device the image is written through to, NULL for none */
+} journal_t;
+
+/* writes an empty journal into its blocks */
+void journal_format(journal_t* journal, uint32_t disk_base_addr, uint32_t journal_block, blk_device_t* dev);
+
+/* attaches the journal and replays a committed transaction, returns -1 if it is not a journal */
+int32_t journal_mount(journal_t* journal, uint32_t disk_base_addr, uint32_t journal_block, blk_device_t* dev);
+
+/* starts a transaction */
+void journal_begin(journal_t* journal);
+
+/* gets the journal copy of a metadata block to modify in the current transaction */
+void* journal_get_block(journal_t* journal, uint32_t block);
+
+/* commits the current transaction and writes it home */
+void journal_commit(journal_t* journal);
+
+#endif /* _JOURNAL_H */
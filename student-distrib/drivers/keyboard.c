@@ -2,6 +2,7 @@
 #include "keyboard.h"
 #include "terminal.h"
 #include "../page.h"
+#include "../signal.h"
 
 /* important ASCII references */
 static uint8_t codeASCIINS[62] = {
@@ -49,7 +50,7 @@ void Keyboard_Handler(void) {
     terminal_active->cursor_x = getX();
     terminal_active->cursor_y = getY();
     // set vidmem pointer to shown terminal
-    setVidPointer((char*)VMEM_BASE_ADDR);
+    setVidPointer(getScreenPointer());
     // change screen coords to shown terminal
     editScreenCoords(terminal_shown->cursor_x, terminal_shown->cursor_y);
 
@@ -100,7 +101,16 @@ void Keyboard_Handler(void) {
                     terminal_shown->keyboard_buffer[i] = 0x00;
                 }
                 terminal_shown->keyboard_idx = 0;
-            } 
+            }
+            else if ((shiftcaps & 0x04) > 0 && scancode == 0x2E) {//CTRL + C
+                // interrupt the program running on the shown terminal
+                if (TA_idx == TS_idx) {
+                    send_signal(&current_PCB->signals, SIG_INTERRUPT);
+                } else {
+                    send_signal(&terminal_shown->currentPCB->signals, SIG_INTERRUPT);
+                }
+                keycode = 0x00;
+            }
             else if ((shiftcaps & 0x02)>>1 != (shiftcaps & 0x01)) {//shift + character
                 keycode = codeASCIIYS[scancode];
             } else {                                                //std character
@@ -143,7 +153,7 @@ void Keyboard_Handler(void) {
     terminal_shown->cursor_y = getY();
     // set vidmem pointer to active terminal if not shown
     if (TA_idx != TS_idx) {
-        setVidPointer((char*)(VMEM_BASE_ADDR + (TA_idx+1)*_4KB));
+        setVidPointer((char*)VMEM_SAVED_ADDR(TA_idx));
     }
     
     // change screen coords
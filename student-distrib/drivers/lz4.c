@@ -0,0 +1,94 @@
+#include "lz4.h"
+
+/* lz4_read_length - reads the bytes extending a 4-bit length
+ *
+ * Inputs: ip - position in the block, moved past the length bytes
+ *         end - end of the block
+ *         length - 4-bit length, LZ4_RUN_MASK when bytes follow, updated
+ * Outputs: 0 for success, -1 if the block ends inside the length
+ * Side Effects: None
+ */
+static int32_t lz4_read_length(const uint8_t** ip, const uint8_t* end, uint32_t* length) {
+    uint8_t byte;   /* current length byte */
+
+    if (*length != LZ4_RUN_MASK) {
+        return 0;
+    }
+
+    do {
+        if (*ip >= end) {
+            return -1;
+        }
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+
+    return 0;
+}
+
+/* lz4_decompress - decompresses an LZ4 block
+ *      every length and offset is checked, a corrupt block never reads or writes
+ *      outside the two buffers
+ *
+ * Inputs: src - compressed block
+ *         src_len - bytes in the compressed block
+ *         dst - buffer to fill
+ *         dst_len - size of dst
+ * Outputs: bytes written to dst, -1 for a corrupt block or one that does not fit in dst
+ * Side Effects: None
+ */
+int32_t lz4_decompress(const uint8_t* src, uint32_t src_len, uint8_t* dst, uint32_t dst_len) {
+    const uint8_t* ip = src;                /* next compressed byte */
+    const uint8_t* src_end = src + src_len; /* end of the compressed block */
+    uint8_t* op = dst;                      /* next output byte */
+    uint8_t* dst_end = dst + dst_len;       /* end of the output buffer */
+    const uint8_t* match;                   /* first byte of a match */
+    uint32_t token;                         /* token of the current sequence */
+    uint32_t length;                        /* literal or match length */
+    uint32_t offset;                        /* distance back to the match */
+
+    while (ip < src_end) {
+        token = *ip++;
+
+        // literals
+        length = token >> 4;
+        if (lz4_read_length(&ip, src_end, &length) == -1 ||
+            length > (uint32_t)(src_end - ip) || length > (uint32_t)(dst_end - op)) {
+            return -1;
+        }
+        memcpy(op, ip, length);
+        ip += length;
+        op += length;
+
+        // the last sequence has no match
+        if (ip == src_end) {
+            break;
+        }
+
+        if (src_end - ip < 2) {
+            return -1;
+        }
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (uint32_t)(op - dst)) {
+            return -1;
+        }
+
+        length = token & LZ4_RUN_MASK;
+        if (lz4_read_length(&ip, src_end, &length) == -1) {
+            return -1;
+        }
+        length += LZ4_MIN_MATCH;
+        if (length > (uint32_t)(dst_end - op)) {
+            return -1;
+        }
+
+        // byte by byte, a match may overlap the bytes it produces
+        match = op - offset;
+        while (length-- > 0) {
+            *op++ = *match++;
+        }
+    }
+
+    return op - dst;
+}
@@ -0,0 +1,25 @@
+/* lz4.h - LZ4 block decompression
+ * vim:ts=4 noexpandtab
+ */
+#ifndef _LZ4_H
+#define _LZ4_H
+
+#include "../lib.h"
+
+#define LZ4_MIN_MATCH           4       /* a match length of 0 in a token means 4 bytes */
+#define LZ4_RUN_MASK            15      /* a 4-bit length of 15 continues in the next bytes */
+
+/*
+ * A block is a list of sequences, each one:
+ *      token          - high 4 bits literal length, low 4 bits match length - LZ4_MIN_MATCH
+ *      length bytes   - added to a 4-bit length of 15 until a byte below 255
+ *      literals       - copied as they are
+ *      offset         - 2 bytes little endian, distance back to the match in the output
+ *      length bytes   - the rest of the match length, as for the literals
+ * The last sequence of a block stops after its literals.
+ */
+
+/* decompresses an LZ4 block, returns the bytes produced or -1 for a corrupt block */
+int32_t lz4_decompress(const uint8_t* src, uint32_t src_len, uint8_t* dst, uint32_t dst_len);
+
+#endif /* _LZ4_H */
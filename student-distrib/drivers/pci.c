@@ -0,0 +1,85 @@
+#include "pci.h"
+
+/* pci_config_address - builds the CONFIG_ADDRESS value of a register
+ *
+ * Inputs: addr - function to access
+ *         offset - register offset, the low 2 bits are ignored
+ * Outputs: value for the address port
+ * Side Effects: None
+ */
+static uint32_t pci_config_address(pci_addr_t* addr, uint32_t offset) {
+    return 0x80000000 | (addr->bus << 16) | (addr->device << 11) | (addr->function << 8) | (offset & 0xFC);
+}
+
+/* pci_config_read - reads a configuration space dword
+ *
+ * Inputs: addr - function to read from
+ *         offset - register offset
+ * Outputs: register value, all 1s if the function does not exist
+ * Side Effects: None
+ */
+uint32_t pci_config_read(pci_addr_t* addr, uint32_t offset) {
+    uint32_t value; /* register value */
+    uint32_t save;  /* variable to store flags */
+
+    // the address and data ports are one transaction, keep them together
+    cli_and_save(save);
+    outl(pci_config_address(addr, offset), PCI_CONFIG_ADDR);
+    value = inl(PCI_CONFIG_DATA);
+    restore_flags(save);
+
+    return value;
+}
+
+/* pci_config_write - writes a configuration space dword
+ *
+ * Inputs: addr - function to write to
+ *         offset - register offset
+ *         value - value to write
+ * Outputs: None
+ * Side Effects: changes the function's configuration
+ */
+void pci_config_write(pci_addr_t* addr, uint32_t offset, uint32_t value) {
+    uint32_t save;  /* variable to store flags */
+
+    cli_and_save(save);
+    outl(pci_config_address(addr, offset), PCI_CONFIG_ADDR);
+    outl(value, PCI_CONFIG_DATA);
+    restore_flags(save);
+}
+
+/* pci_find_class - scans the buses for a function of some class
+ *
+ * Inputs: class_code - base class to look for
+ *         subclass - subclass to look for
+ *         addr - filled with the location of the first match
+ * Outputs: 0 for success, -1 if there is no such function
+ * Side Effects: None
+ */
+int32_t pci_find_class(uint32_t class_code, uint32_t subclass, pci_addr_t* addr) {
+    uint32_t class_reg;     /* class register of the function */
+    uint32_t num_functions; /* functions to check on the current device */
+
+    for (addr->bus = 0; addr->bus < PCI_MAX_BUS; addr->bus++) {
+        for (addr->device = 0; addr->device < PCI_MAX_DEVICE; addr->device++) {
+            addr->function = 0;
+            if ((pci_config_read(addr, PCI_VENDOR_ID) & 0xFFFF) == PCI_NO_VENDOR) {
+                continue;
+            }
+
+            // only multi-function devices decode functions 1 to 7
+            num_functions = ((pci_config_read(addr, PCI_HEADER_TYPE) >> 16) & PCI_MULTIFUNCTION) ? PCI_MAX_FUNCTION : 1;
+            for (addr->function = 0; addr->function < num_functions; addr->function++) {
+                if ((pci_config_read(addr, PCI_VENDOR_ID) & 0xFFFF) == PCI_NO_VENDOR) {
+                    continue;
+                }
+                class_reg = pci_config_read(addr, PCI_CLASS);
+                if ((class_reg >> 24) == class_code && ((class_reg >> 16) & 0xFF) == subclass) {
+                    return 0;
+                }
+            }
+        }
+    }
+
+    return -1;
+}
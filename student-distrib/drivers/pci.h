@@ -0,0 +1,46 @@
+/* pci.h - PCI configuration space access through the type 1 mechanism
+ * vim:ts=4 noexpandtab
+ */
+#ifndef _PCI_H
+#define _PCI_H
+
+#include "../lib.h"
+
+#define PCI_CONFIG_ADDR     0xCF8
+#define PCI_CONFIG_DATA     0xCFC
+
+#define PCI_MAX_BUS         256
+#define PCI_MAX_DEVICE      32
+#define PCI_MAX_FUNCTION    8
+
+/* configuration space registers, offsets of aligned dwords */
+#define PCI_VENDOR_ID       0x00    /* device ID in the high word */
+#define PCI_COMMAND         0x04    /* status in the high word */
+#define PCI_CLASS           0x08    /* class, subclass, prog IF, revision from high to low byte */
+#define PCI_HEADER_TYPE     0x0C    /* header type in bits [23:16] */
+#define PCI_BAR0            0x10    /* BARs 0 to 5 follow every 4 bytes */
+
+#define PCI_COMMAND_IO      0x0001  /* respond to I/O space accesses */
+#define PCI_COMMAND_MASTER  0x0004  /* allow the device to master the bus (DMA) */
+#define PCI_BAR_IO_MASK     0xFFFFFFFC
+
+#define PCI_NO_VENDOR       0xFFFF  /* vendor ID read from an empty slot */
+#define PCI_MULTIFUNCTION   0x80    /* header type bit set for multi-function devices */
+
+/* location of a function on the bus */
+typedef struct pci_addr_t {
+    uint32_t bus;
+    uint32_t device;
+    uint32_t function;
+} pci_addr_t;
+
+/* reads a dword of a function's configuration space */
+uint32_t pci_config_read(pci_addr_t* addr, uint32_t offset);
+
+/* writes a dword of a function's configuration space */
+void pci_config_write(pci_addr_t* addr, uint32_t offset, uint32_t value);
+
+/* finds the first function with a class and subclass */
+int32_t pci_find_class(uint32_t class_code, uint32_t subclass, pci_addr_t* addr);
+
+#endif /* _PCI_H */
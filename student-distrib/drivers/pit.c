@@ -3,31 +3,119 @@
 #include "../page.h"
 #include "../syscall.h"
 #include "terminal.h"
+#include "../timer.h"
 
 /* counter to check number of PIT interrupts, used to execute MAX_TERMINALS number of base shells */
 static uint32_t pit_counter;
 
+static uint32_t pit_time_us;        /* microseconds since init_PIT */
+static uint32_t pit_residue;        /* PIT counts not yet turned into microseconds, scaled by 10000 */
+static uint16_t pit_last_count;     /* counter value at the last pit_sync */
+static uint32_t pit_deadline;       /* time the programmed one-shot fires at */
+static uint32_t pit_slice_start;    /* time the running terminal got the processor */
+
+/* pit_sync() - brings pit_time_us up to date with the hardware counter
+ *      the counter counts down from the programmed value and keeps going past 0,
+ *      so the counts elapsed are the difference to the last value read
+ *      must be called with interrupts disabled
+ * 
+ * Inputs: NONE
+ * Outputs: current time in microseconds
+ * Side Effects: advances pit_time_us
+ */
+static uint32_t pit_sync() {
+    uint16_t count;     /* current counter value */
+    uint32_t elapsed;   /* microseconds to add */
+
+    // latch channel 0 and read it back low byte first
+    outb(PIT_CMD_LATCH, PIT_PORT+3);
+    count = inb(PIT_PORT);
+    count |= inb(PIT_PORT) << 8;
+
+    // 1193182 counts per second is 11932 counts per 10000 us
+    pit_residue += ((uint16_t)(pit_last_count - count)) * 10000;
+    pit_last_count = count;
+    elapsed = pit_residue / PIT_COUNTS_PER_10MS;
+    pit_residue -= elapsed * PIT_COUNTS_PER_10MS;
+    pit_time_us += elapsed;
+
+    return pit_time_us;
+}
+
+/* pit_program() - arms the one-shot for a deadline
+ *      must be called with interrupts disabled, right after pit_sync
+ * 
+ * Inputs: deadline - time in microseconds the next interrupt should fire at
+ * Outputs: NONE
+ * Side Effects: reprograms channel 0, the deadline is clamped to what one count can hold
+ */
+static void pit_program(uint32_t deadline) {
+    uint32_t delay = deadline - pit_time_us; /* microseconds until the interrupt */
+
+    if (TIME_BEFORE(deadline, pit_time_us) || delay < PIT_MIN_DELAY) {
+        delay = PIT_MIN_DELAY;
+    } else if (delay > PIT_MAX_DELAY) {
+        delay = PIT_MAX_DELAY;
+    }
+
+    pit_deadline = pit_time_us + delay;
+    pit_last_count = delay * PIT_COUNTS_PER_MS / 1000;
+
+    outb(PIT_CMD_ONESHOT, PIT_PORT+3);          /* channel 0, low then high byte, mode 0 */
+    outb(pit_last_count & 0xFF, PIT_PORT);      /* Set low byte of count */
+    outb(pit_last_count >> 8, PIT_PORT);        /* Set high byte of count, starts counting */
+}
+
 /* PIT_init() - PIT device initialization
  * 
  * Inputs: NONE
  * Outputs: NONE
- * Side Effects: initializes the PIT to fire interrupts at 100Hz
+ * Side Effects: sets the PIT up as a one-shot timer, the first interrupt fires one quantum after unmasking
  */
 void init_PIT() {
-    /* initting at 100 hz */
     cli();
 
-    uint16_t rate_const = 1193180 / 100;    /* Calculate our divisor */
-    outb(0x36, PIT_PORT+3);                 /* Set our command byte 0x36 */
-    outb(rate_const & 0xFF, PIT_PORT);      /* Set low byte of divisor */
-    outb(rate_const >> 8, PIT_PORT);        /* Set high byte of divisor */
-
     pit_counter = 0;
+    pit_time_us = 0;
+    pit_residue = 0;
+    pit_slice_start = 0;
+    pit_program(PIT_QUANTUM);
 
-    enable_irq(PIT_IRQ); // an interrupt will fire immediately after unmasking interrupts
+    enable_irq(PIT_IRQ);
     sti();
 }
 
+/* pit_time() - reads the current time
+ * 
+ * Inputs: NONE
+ * Outputs: microseconds since init_PIT, wraps around after about 71 minutes
+ * Side Effects: NONE
+ */
+uint32_t pit_time() {
+    uint32_t now;   /* current time */
+    uint32_t save;  /* variable to store flags */
+
+    cli_and_save(save);
+    now = pit_sync();
+    restore_flags(save);
+
+    return now;
+}
+
+/* pit_set_next_event() - makes sure the PIT fires no later than a deadline
+ *      must be called with interrupts disabled
+ * 
+ * Inputs: deadline - time in microseconds of a new timer
+ * Outputs: NONE
+ * Side Effects: reprograms the one-shot if the deadline is earlier than the programmed one
+ */
+void pit_set_next_event(uint32_t deadline) {
+    if (TIME_BEFORE(deadline, pit_deadline)) {
+        pit_sync();
+        pit_program(deadline);
+    }
+}
+
 /* active terminal from terminal.c */
 extern uint32_t TA_idx;
 extern terminal_t* terminal_active;
@@ -36,19 +124,39 @@ extern terminal_t* terminal_active;
  * 
  * Inputs: NONE
  * Outputs: NONE
- * Side Effects: On the first 3 PIT interrupts from init, it executes 3 base shells. Every PIT interrupt changes the actively executing terminal
- * in a round robin fashion and changes the user video page. 
+ * Side Effects: Expires due kernel timers and arms the one-shot for the next deadline. On the first 3 quanta from init,
+ * it executes 3 base shells. Every time a quantum ends it changes the actively executing terminal in a round robin fashion
+ * and changes the user video page. 
  */
 void PIT_Handler() {
+    uint32_t now;           /* current time */
+    uint32_t slice_end;     /* time the running terminal's quantum ends */
+    uint32_t slice_over;    /* the quantum ended (1) or the interrupt was for a timer (0) */
+
     // acknowledge the interrupt to allow further PIT interrupts
     send_eoi(PIT_IRQ);
-    
-    // save current terminal's PIT_Handler EBP, needed to exit out of later during swtch_ctx
-    register uint32_t saved_ebp asm("ebp");
-    terminal_active->saved_ebp = saved_ebp;
+
+    // expire sleeping processes, alarms and other kernel timers
+    now = pit_sync();
+    timer_run(now);
+
+    // fire again at the end of the quantum or at the next timer, whichever comes first
+    slice_over = !TIME_BEFORE(now, pit_slice_start + PIT_QUANTUM) || pit_counter < MAX_TERMINALS;
+    slice_end = slice_over ? now + PIT_QUANTUM : pit_slice_start + PIT_QUANTUM;
+    pit_program(timer_next_expiry(now, slice_end));
+
+    if (!slice_over) {
+        return;
+    }
 
     // execute first 3 base shells
-    if (pit_counter < 3) {
+    if (pit_counter < MAX_TERMINALS) {
+        pit_slice_start = now;
+
+        // save current terminal's PIT_Handler EBP, needed to exit out of later during swtch_ctx
+        register uint32_t saved_ebp asm("ebp");
+        terminal_active->saved_ebp = saved_ebp;
+
         // set active terminal
         set_active_terminal(pit_counter);
         // increment pit counter
@@ -58,6 +166,27 @@ void PIT_Handler() {
         execute((uint8_t*)"shell");
     }
 
+    // round robin scheduling
+    schedule();
+}
+
+/* schedule() - switch to the next terminal's process
+ *      must be called with interrupts disabled
+ *      returns when the scheduler switches back to this terminal
+ * 
+ * Inputs: NONE
+ * Outputs: NONE
+ * Side Effects: saves this terminal's schedule EBP, changes the active terminal in a round robin fashion,
+ * changes the user video page and context switches to the next terminal's kernel stack
+ */
+void schedule() {
+    // save current terminal's schedule EBP, swtch_ctx will leave/ret out of schedule when we come back
+    register uint32_t saved_ebp asm("ebp");
+    terminal_active->saved_ebp = saved_ebp;
+
+    // the next terminal gets a whole quantum
+    pit_slice_start = pit_time_us;
+
     // round robin scheduling
     set_active_terminal((TA_idx + 1) % MAX_TERMINALS);
 
@@ -67,6 +196,25 @@ void PIT_Handler() {
     // context switch to other kernel stack
     swtch_ctx(terminal_active->saved_ebp);
 
-    // we should never enter here, swtch_ctx should exit PIT_Handler for us
+    // we should never enter here, swtch_ctx should exit schedule for us
     printf("get out");
 }
+
+/* schedule_yield() - give up the rest of the current time slice
+ *      used by syscalls that block, so waiting does not burn the terminal's slice
+ *      does nothing until all base shells are running
+ * 
+ * Inputs: NONE
+ * Outputs: NONE
+ * Side Effects: switches to the next terminal's process, returns with interrupts enabled
+ */
+void schedule_yield() {
+    // other terminals have no saved context to switch into yet
+    if (pit_counter < MAX_TERMINALS) {
+        return;
+    }
+
+    cli();
+    schedule();
+    sti();
+}
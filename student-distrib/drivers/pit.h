@@ -7,14 +7,35 @@
 #define PIT_IRQ     0
 #define PIT_PORT    0x40
 
+#define PIT_CMD_LATCH           0x00    /* latch channel 0 so it can be read */
+#define PIT_CMD_ONESHOT         0x30    /* channel 0, low then high byte, mode 0 (interrupt on terminal count) */
+#define PIT_COUNTS_PER_MS       1193    /* 1193182 Hz input clock */
+#define PIT_COUNTS_PER_10MS     11932
+
+#define PIT_QUANTUM             10000   /* microseconds a terminal runs before the next one is scheduled */
+#define PIT_MIN_DELAY           50      /* shortest one-shot in microseconds, keeps the PIT from flooding the CPU */
+#define PIT_MAX_DELAY           54000   /* longest one-shot in microseconds that fits in a 16 bit count */
+
 /* asm function for context switching in the scheduler */
 extern void swtch_ctx(uint32_t);
 
 /* PIT initialization */
 void init_PIT(void);
 
-/* PIT interrupt handler, performs round robin scheduling */
+/* PIT interrupt handler, runs kernel timers and performs round robin scheduling */
 void PIT_Handler(void);
 
+/* reads the current time in microseconds */
+uint32_t pit_time(void);
+
+/* makes sure the PIT fires no later than a deadline, interrupts must be disabled */
+void pit_set_next_event(uint32_t deadline);
+
+/* switches to the next terminal's process, interrupts must be disabled */
+void schedule(void);
+
+/* gives up the rest of the time slice while blocked in a syscall */
+void schedule_yield(void);
+
 
 #endif /* _PIT_H */
@@ -0,0 +1,76 @@
+#include "ramdisk.h"
+
+static ramdisk_t ramdisks[RAMDISK_MAX_DEVICES]; /* RAM disks */
+static uint32_t ramdisk_count;                  /* RAM disks created */
+
+/* ramdisk_start - block layer hook that starts a request
+ *      the copy is done when the block layer polls, so queued bios can still merge
+ *      into later requests the way they would on a real disk
+ *
+ * Inputs: dev - block device of a RAM disk
+ *         req - its active request
+ * Outputs: 0
+ * Side Effects: None
+ */
+static int32_t ramdisk_start(blk_device_t* dev, blk_request_t* req) {
+    return 0;
+}
+
+/* ramdisk_poll - block layer hook that carries out the active request
+ *
+ * Inputs: dev - block device of a RAM disk
+ * Outputs: None
+ * Side Effects: copies between the memory and the bios, finishes the request
+ */
+static void ramdisk_poll(blk_device_t* dev) {
+    ramdisk_t* disk = (ramdisk_t*)dev->driver_data; /* RAM disk of the device */
+    blk_bio_t* bio;                                 /* current bio */
+    uint8_t* mem;                                   /* memory of the bio's first sector */
+
+    if (dev->active == NULL) {
+        return;
+    }
+
+    for (bio = dev->active->bios; bio != NULL; bio = bio->next) {
+        mem = disk->base + bio->sector * BLK_SECTOR_SIZE;
+        if (bio->write) {
+            memcpy(mem, bio->buf, bio->num_sectors * BLK_SECTOR_SIZE);
+        } else {
+            memcpy(bio->buf, mem, bio->num_sectors * BLK_SECTOR_SIZE);
+        }
+    }
+
+    blk_complete(dev, 0);
+}
+
+/* ramdisk_create - registers kernel memory as a block device
+ *
+ * Inputs: addr - first byte of the memory
+ *         size - bytes of memory, only whole sectors are used
+ * Outputs: the block device, NULL if there is no room for another device
+ * Side Effects: registers a block device named "ramN"
+ */
+blk_device_t* ramdisk_create(uint32_t addr, uint32_t size) {
+    ramdisk_t* disk;    /* new RAM disk */
+
+    if (ramdisk_count == RAMDISK_MAX_DEVICES || size < BLK_SECTOR_SIZE) {
+        return NULL;
+    }
+    disk = &ramdisks[ramdisk_count];
+
+    memset(disk, 0, sizeof(ramdisk_t));
+    strcpy(disk->blk.name, "ram0");
+    disk->blk.name[3] += ramdisk_count;
+    disk->blk.num_sectors = size / BLK_SECTOR_SIZE;
+    disk->blk.start = ramdisk_start;
+    disk->blk.poll = ramdisk_poll;
+    disk->blk.driver_data = disk;
+    disk->base = (uint8_t*)addr;
+
+    if (blk_register(&disk->blk) == -1) {
+        return NULL;
+    }
+
+    ramdisk_count++;
+    return &disk->blk;
+}
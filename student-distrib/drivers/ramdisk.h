@@ -0,0 +1,21 @@
+/* ramdisk.h - block devices backed by kernel memory
+ * vim:ts=4 noexpandtab
+ */
+#ifndef _RAMDISK_H
+#define _RAMDISK_H
+
+#include "../lib.h"
+#include "blkdev.h"
+
+#define RAMDISK_MAX_DEVICES     3       /* RAM disks for measuring the block layer and cache without a disk */
+
+/* one RAM disk, the memory is the device */
+typedef struct ramdisk_t {
+    blk_device_t blk;       /* block device of the RAM disk */
+    uint8_t* base;          /* first byte of the memory */
+} ramdisk_t;
+
+/* registers kernel memory as a block device, returns the device or NULL */
+blk_device_t* ramdisk_create(uint32_t addr, uint32_t size);
+
+#endif /* _RAMDISK_H */
@@ -2,13 +2,18 @@
 #include "rtc.h"
 #include "fsys.h"
 #include "terminal.h"
+#include "pit.h"
+#include "../process.h"
+#include "../page.h"
 
 /* file operations jumptable for rtc */
 fops_jumptable_t rtc_jmptable = {
     rtc_read,
     rtc_write,
     rtc_open,
-    rtc_close
+    rtc_close,
+    NULL,
+    NULL
 };
 
 /*
@@ -19,6 +24,19 @@ fops_jumptable_t rtc_jmptable = {
  *    - reading or writing from port 0x71 will reset the selected register, meaning we must reselect the register by writing to port 0x70
  */
 
+/* virtual RTC state of every open file, fds sharing an open file share its virtual RTC */
+static rtc_vdev_t rtc_vdevs[MAX_OPEN_FILES];
+
+/* min-heap of active virtual RTCs keyed by their next deadline */
+static rtc_vdev_t* rtc_heap[MAX_OPEN_FILES];
+static uint32_t rtc_heap_size;
+
+/* number of virtual RTCs running at each rate, indexed by log2 of the frequency */
+static uint32_t rtc_rate_users[RTC_MAX_LOG_FREQ + 1];
+
+static uint32_t rtc_hw_log_freq;    /* log2 of the frequency the chip is programmed to */
+static uint32_t rtc_time;           /* time in 1/1024 s units, advanced by every interrupt */
+
 /* NMI_enable - enable NMIs
  * 
  * Inputs: None
@@ -41,20 +59,198 @@ static void NMI_disable() {
     inb(0x71);                          // CMOS RTC expects a read from port 0x71 or else it may go into undefined state
 }
 
+/* rtc_set_hw_rate - programs the periodic interrupt rate of the chip
+ *      must be called with interrupts disabled
+ * 
+ * Inputs: log_freq - log2 of the frequency in Hz, between 1 and RTC_MAX_LOG_FREQ
+ * Outputs: None
+ * Side Effects: writes the RS bits of RTC register A
+ */
+static void rtc_set_hw_rate(uint32_t log_freq) {
+    uint8_t prev_regA;  /* variable to store previous value of RTC register A */
+
+    NMI_disable();
+
+    // RS bits [3:0] of register A: rate n gives 32768 >> (n - 1) Hz, so 2^k Hz is rate 16 - k
+    outb(0x8A, RTC_PORT);		                            // select register A, keep NMI disabled
+    prev_regA = (uint8_t) inb(RTC_PORT + 1);	            // read and save the current value of register A
+    outb(0x8A, RTC_PORT);		                            // reselect register A, keep NMI disabled
+    outb((prev_regA & 0xF0) | (16 - log_freq), RTC_PORT + 1);	// set LSB 4 of register A
+
+    NMI_enable();
+
+    rtc_hw_log_freq = log_freq;
+}
+
+/* rtc_update_hw_rate - runs the chip at the highest rate any virtual RTC needs
+ *      must be called with interrupts disabled
+ * 
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: may reprogram the chip, drops to 2 Hz when no virtual RTC is open
+ */
+static void rtc_update_hw_rate(void) {
+    uint32_t log_freq; /* log2 of the frequency to run at */
+
+    for (log_freq = RTC_MAX_LOG_FREQ; log_freq > RTC_MIN_LOG_FREQ; log_freq--) {
+        if (rtc_rate_users[log_freq] != 0) {
+            break;
+        }
+    }
+
+    if (log_freq != rtc_hw_log_freq) {
+        rtc_set_hw_rate(log_freq);
+    }
+}
+
+/* rtc_heap_swap - swaps two heap entries
+ * 
+ * Inputs: i, j - heap positions to swap
+ * Outputs: None
+ * Side Effects: updates the heap positions stored in the entries
+ */
+static void rtc_heap_swap(uint32_t i, uint32_t j) {
+    rtc_vdev_t* tmp = rtc_heap[i]; /* entry being swapped */
+
+    rtc_heap[i] = rtc_heap[j];
+    rtc_heap[j] = tmp;
+    rtc_heap[i]->heap_idx = i;
+    rtc_heap[j]->heap_idx = j;
+}
+
+/* rtc_heap_up - moves an entry up until its parent is not later
+ * 
+ * Inputs: i - heap position of the entry
+ * Outputs: None
+ * Side Effects: None
+ */
+static void rtc_heap_up(uint32_t i) {
+    while (i > 0 && RTC_BEFORE(rtc_heap[i]->deadline, rtc_heap[(i - 1) / 2]->deadline)) {
+        rtc_heap_swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+/* rtc_heap_down - moves an entry down until no child is earlier
+ * 
+ * Inputs: i - heap position of the entry
+ * Outputs: None
+ * Side Effects: None
+ */
+static void rtc_heap_down(uint32_t i) {
+    uint32_t child; /* earliest child of i */
+
+    while ((child = 2*i + 1) < rtc_heap_size) {
+        if (child + 1 < rtc_heap_size && RTC_BEFORE(rtc_heap[child + 1]->deadline, rtc_heap[child]->deadline)) {
+            child++;
+        }
+        if (!RTC_BEFORE(rtc_heap[child]->deadline, rtc_heap[i]->deadline)) {
+            break;
+        }
+        rtc_heap_swap(i, child);
+        i = child;
+    }
+}
+
+/* rtc_vdev_start - queues a virtual RTC at a rate
+ *      must be called with interrupts disabled
+ * 
+ * Inputs: vdev - virtual RTC that is not queued
+ *         log_freq - log2 of the virtual frequency in Hz
+ * Outputs: None
+ * Side Effects: may raise the hardware rate
+ */
+static void rtc_vdev_start(rtc_vdev_t* vdev, uint32_t log_freq) {
+    vdev->log_freq = log_freq;
+    vdev->period = RTC_BASE_FREQ >> log_freq;
+    vdev->deadline = rtc_time + vdev->period;
+    vdev->ticks = 0;
+
+    vdev->heap_idx = rtc_heap_size++;
+    rtc_heap[vdev->heap_idx] = vdev;
+    rtc_heap_up(vdev->heap_idx);
+
+    rtc_rate_users[log_freq]++;
+    rtc_update_hw_rate();
+}
+
+/* rtc_vdev_stop - removes a virtual RTC from the heap
+ *      must be called with interrupts disabled
+ * 
+ * Inputs: vdev - virtual RTC, may or may not be queued
+ * Outputs: None
+ * Side Effects: may lower the hardware rate
+ */
+static void rtc_vdev_stop(rtc_vdev_t* vdev) {
+    uint32_t i = vdev->heap_idx; /* heap position of vdev */
+
+    if (i == RTC_NOT_QUEUED) {
+        return;
+    }
+
+    // move the last entry into the hole and restore the heap order around it
+    rtc_heap_size--;
+    if (i != rtc_heap_size) {
+        rtc_heap[i] = rtc_heap[rtc_heap_size];
+        rtc_heap[i]->heap_idx = i;
+        rtc_heap_up(i);
+        rtc_heap_down(rtc_heap[i]->heap_idx);
+    }
+    vdev->heap_idx = RTC_NOT_QUEUED;
+
+    rtc_rate_users[vdev->log_freq]--;
+    rtc_update_hw_rate();
+}
+
+/* rtc_get_vdev - finds the virtual RTC of a file descriptor of the current process
+ *      the state is set up at 2 Hz the first time an fd is used after open
+ *      must be called with interrupts disabled
+ * 
+ * Inputs: fd - file descriptor the RTC was opened on
+ * Outputs: virtual RTC of the fd, NULL if fd is not open
+ * Side Effects: may queue the virtual RTC
+ */
+static rtc_vdev_t* rtc_get_vdev(int32_t fd) {
+    file_desc_t* file_desc_ptr;     /* file descriptor of the RTC */
+    rtc_vdev_t* vdev;               /* virtual RTC of the fd */
+
+    file_desc_ptr = get_file_desc(fd);
+    if (file_desc_ptr == NULL) {
+        return NULL;
+    }
+    vdev = &rtc_vdevs[file_desc_ptr - open_file_table];
+
+    // open() cleared the flags, a base shell restarted by halt may still have the old state queued
+    if (!(file_desc_ptr->flags & RTC_FLAG_ACTIVE)) {
+        rtc_vdev_stop(vdev);
+        rtc_vdev_start(vdev, RTC_MIN_LOG_FREQ);
+        file_desc_ptr->flags |= RTC_FLAG_ACTIVE;
+    }
+
+    return vdev;
+}
+
 /* init_RTC - RTC initialization
  * 
  * Inputs: None
  * Outputs: None
  * Side Effects: alters the rtc chip by writing and initalizing values to it
- *               starts the rtc frequency at 512 Hz for rtc_counter
+ *               starts the rtc frequency at 2 Hz until a virtual RTC needs more
  */
 void init_RTC(void) { //call this only on initialization during the non CLI
-    uint8_t prev_regA;  /* variable to store previous value of RTC register A */
     uint8_t prev_regB;  /* variable to store previous value of RTC register B */
     uint32_t save;      /* variable to store flags */
+    uint32_t i;         /* loop index */
 
-    // an interrupt has not occurred yet!
-    rtc_counter = 0;
+    // no virtual RTC is running and an interrupt has not occurred yet!
+    for (i = 0; i < MAX_OPEN_FILES; i++) {
+        rtc_vdevs[i].heap_idx = RTC_NOT_QUEUED;
+    }
+    for (i = 0; i <= RTC_MAX_LOG_FREQ; i++) {
+        rtc_rate_users[i] = 0;
+    }
+    rtc_heap_size = 0;
+    rtc_time = 0;
 
     // save flags and disable interrupts and NMIs for RTC programming
     cli_and_save(save);
@@ -66,14 +262,12 @@ void init_RTC(void) { //call this only on initialization during the non CLI
     outb(0x8B, RTC_PORT);		                // reselect register B, keep NMI disabled
     outb(prev_regB | 0x40, RTC_PORT + 1);	    // write the previous register B value ORed with 0x40. This turns on bit [6] of register B
 
-    // set RTC interrupt rate to 1024 Hz; write 0x6=0b0110 RS bits [3:0] of RTC register A, which corresponds to 1024 Hz
-    outb(0x8A, RTC_PORT);		                    // select register A, keep NMI disabled
-    prev_regA = (uint8_t) inb(RTC_PORT + 1);	    // read and save the current value of register A
-    outb(0x8A, RTC_PORT);		                    // reselect register A, keep NMI disabled
-    outb((prev_regA & 0xF0) | 0x07, RTC_PORT + 1);	// set LSB 4 of register A
-
-    // restore flags and reenable interrupts and NMIs
     NMI_enable();
+
+    // set RTC interrupt rate to 2 Hz, the slowest rate a virtual RTC can ask for
+    rtc_set_hw_rate(RTC_MIN_LOG_FREQ);
+
+    // restore flags and reenable interrupts
     restore_flags(save);
     sti();
 
@@ -81,19 +275,15 @@ void init_RTC(void) { //call this only on initialization during the non CLI
     enable_irq(RTC_IRQ);
 }
 
-/* active terminal from terminal.c */
-extern terminal_t* terminal_active;
-extern terminal_t terminal_arr[MAX_TERMINALS];
-
 
 /* RTC_Handler - RTC interrupt handler handles different aspects related to timing with the RTC chip
  * 
  * Inputs: None
  * Outputs: None
- * Side Effects: fires periodically at 512 hz according to the rtc handler
+ * Side Effects: fires periodically at the hardware rate, counts a tick on every virtual RTC whose deadline passed
  */
 void RTC_Handler(void) {
-    uint32_t i;     /* loop index */
+    rtc_vdev_t* vdev;   /* earliest virtual RTC */
 
     // disable interrupts
     cli();
@@ -101,17 +291,17 @@ void RTC_Handler(void) {
     outb(0x0C, RTC_PORT);   // required to allow another rtc interrupt to fire
     inb(RTC_PORT + 1);      // expected read from port 0x71
 
-    // update RTC interrupt flag for all terminals at once
-    for (i = 0; i < MAX_TERMINALS; i++) {
-        // set the RTC interrupt flag when specified bit on rtc_counter changes
-        if (CHECK_FLAG(rtc_counter, terminal_arr[i].rtc_freq_bit) != CHECK_FLAG(rtc_counter + 1, terminal_arr[i].rtc_freq_bit)) {
-            terminal_arr[i].rtc_interrupt_occurred = 1;
-        }
+    // advance time by one hardware period
+    rtc_time += RTC_BASE_FREQ >> rtc_hw_log_freq;
+
+    // only the earliest deadlines are looked at, each expired one is pushed back by its period
+    while (rtc_heap_size != 0 && !RTC_BEFORE(rtc_time, rtc_heap[0]->deadline)) {
+        vdev = rtc_heap[0];
+        vdev->ticks++;
+        vdev->deadline += vdev->period;
+        rtc_heap_down(0);
     }
     
-    // increment rtc_counter
-    rtc_counter++;
-    
     // end interrupt
     send_eoi(RTC_IRQ);
 
@@ -120,52 +310,114 @@ void RTC_Handler(void) {
 }
 
 /* rtc_read - RTC read syscall
+ *      like /dev/rtc, reports how many virtual ticks elapsed since the last read so
+ *      a program that fell behind can catch up instead of drifting
  * 
- * Inputs: fd - unused
- *         buf - unused
- *         nbytes - unused
- * Outputs: 0 (see discussion slides)
- * Side Effects: returns only when the next interrupt fires
+ * Inputs: fd - file descriptor the RTC was opened on
+ *         buf - 32-bit integer to fill with the number of ticks since the last read, may be NULL
+ *         nbytes - size of buf, the count is only written when it is at least 4
+ * Outputs: 4 if the count was written, 0 if it was not, -1 for an invalid fd, a buf
+ *          outside of the user page, or a signal that arrived while waiting
+ * Side Effects: blocks until at least one tick elapsed, unless the fd is in non-blocking mode,
+ *               giving the slice to other terminals while waiting
  */
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes) {
-    // unset interrupt occurred flag
-    terminal_active->rtc_interrupt_occurred = 0;
+    volatile rtc_vdev_t* vdev;  /* virtual RTC of the fd */
+    uint32_t ticks;             /* ticks since the last read */
 
-    // wait for interrupt to fire and set interrupt occurred flag before continuing
-    while (!terminal_active->rtc_interrupt_occurred) {
+    // the count must land entirely inside the user page
+    if (buf != NULL && nbytes >= 4 &&
+        ((uint32_t)buf < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB - 4 < (uint32_t)buf)) {
+        return -1;
     }
 
-    return 0;
+    cli();
+    vdev = rtc_get_vdev(fd);
+    if (vdev == NULL) {
+        sti();
+        return -1;
+    }
+    sti();
+
+    // give the slice to other terminals until a virtual tick is pending
+    if (!(get_file_desc(fd)->flags & RTC_FLAG_NONBLOCK)) {
+        while (vdev->ticks == 0) {
+            // let a pending signal run its handler or default action, the ticks keep counting
+            if (current_PCB->signals.pending != 0 && !current_PCB->signals.masked) {
+                return -1;
+            }
+            schedule_yield();
+        }
+    }
+
+    // take the count and start counting again
+    cli();
+    ticks = vdev->ticks;
+    vdev->ticks = 0;
+    sti();
+
+    if (buf == NULL || nbytes < 4) {
+        return 0;
+    }
+    *((uint32_t*) buf) = ticks;
+    return 4;
 }
 
 /* rtc_write - RTC write syscall
- *      sets the RTC frequency to the given 32-bit integer in Hz
+ *      sets the fd's virtual RTC frequency to the given 32-bit integer in Hz
  *      only RTC frequencies that are powers of 2 between 2 and 1024 inclusive are allowed
+ *      a second 32-bit integer, if given, sets the read mode (RTC_NONBLOCK or 0)
  * 
- * Inputs: fd - unused
- *         buf - pointer to stores 32-bit integer corresponding to frequency to set to
- *         nbytes - unused
- * Outputs: 0 for success, -1 if given invalid frequency
- * Side Effects: 
+ * Inputs: fd - file descriptor the RTC was opened on
+ *         buf - pointer to the 32-bit frequency, optionally followed by the 32-bit mode
+ *         nbytes - 4 to set the frequency only, 8 to also set the mode
+ * Outputs: 0 for success, -1 if given invalid frequency, fd, or a buf outside of the user page
+ * Side Effects: restarts the fd's virtual RTC, may change the hardware rate
  */
 int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes) {
-    uint32_t freq = *((uint32_t*) buf); /* get desired frequency in Hz from given buffer */
-    uint32_t freq_bit;                  /* bit of counter to check */
+    uint32_t freq;              /* desired frequency in Hz */
+    uint32_t log_freq;          /* log2 of the frequency */
+    rtc_vdev_t* vdev;           /* virtual RTC of the fd */
+    uint32_t size;              /* bytes read from buf */
+
+    // every word read must lie inside the user page
+    size = (nbytes >= 8) ? 8 : 4;
+    if ((uint32_t)buf < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB - size < (uint32_t)buf) {
+        return -1;
+    }
+    freq = *((uint32_t*) buf); /* get desired frequency in Hz from given buffer */
 
-    // check if rate is power of 2, between 2 and 512 inclusive
-    if ( !( (freq & (freq - 1)) == 0 && 2 <= freq && freq <= 512) ) {
+    // check if rate is power of 2, between 2 and 1024 inclusive
+    if ( !( (freq & (freq - 1)) == 0 && 2 <= freq && freq <= RTC_BASE_FREQ) ) {
         return -1; // failure
     }
 
-    // calculate freq_bit: freq_bit=0 <-> freq=512, freq_bit=8 <-> freq=2
-    freq_bit = 8;
-    while (freq != 0x02) {
+    // calculate log_freq: log_freq=1 <-> freq=2, log_freq=10 <-> freq=1024
+    log_freq = 0;
+    while (freq != 0x01) {
         freq = freq >> 1;
-        freq_bit--;
+        log_freq++;
+    }
+
+    // restart the fd's virtual RTC at the new rate
+    cli();
+    vdev = rtc_get_vdev(fd);
+    if (vdev == NULL) {
+        sti();
+        return -1;
     }
+    rtc_vdev_stop(vdev);
+    rtc_vdev_start(vdev, log_freq);
 
-    // set the frequency bit of active terminal
-    terminal_active->rtc_freq_bit = freq_bit;
+    // optional read mode
+    if (nbytes >= 8) {
+        if (((uint32_t*) buf)[1] & RTC_NONBLOCK) {
+            get_file_desc(fd)->flags |= RTC_FLAG_NONBLOCK;
+        } else {
+            get_file_desc(fd)->flags &= ~RTC_FLAG_NONBLOCK;
+        }
+    }
+    sti();
 
     return 0;
 }
@@ -174,21 +426,29 @@ int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes) {
  * 
  * Inputs: filename - unused
  * Outputs: 0 (see discussion slides)
- * Side Effects: resets the RTC frequency to 2 Hz
+ * Side Effects: None, the fd's virtual RTC starts at 2 Hz on its first read or write
  */
 int32_t rtc_open(const uint8_t* filename) {
-    // sets active terminals frequency bit for 2 Hz
-    terminal_active->rtc_freq_bit = 8;
-
     return 0;
 }
 
 /* rtc_close - RTC close syscall
  * 
- * Inputs: fd - unused
+ * Inputs: fd - file descriptor the RTC was opened on
  * Outputs: 0
- * Side Effects: does nothing
+ * Side Effects: stops the fd's virtual RTC, may lower the hardware rate
  */
 int32_t rtc_close(int32_t fd) {
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* file descriptor of the RTC */
+    uint32_t save;                                  /* variable to store flags */
+
+    if (file_desc_ptr == NULL) {
+        return 0;
+    }
+
+    cli_and_save(save);
+    rtc_vdev_stop(&rtc_vdevs[file_desc_ptr - open_file_table]);
+    restore_flags(save);
+
     return 0;
 }
@@ -9,8 +9,32 @@
 #define RTC_IRQ     8
 #define RTC_PORT    0x70
 
-/* global rtc counter */
-uint32_t rtc_counter;
+/* virtual RTC rates, frequencies are powers of 2 from 2 Hz to 1024 Hz */
+#define RTC_BASE_FREQ       1024
+#define RTC_MIN_LOG_FREQ    1
+#define RTC_MAX_LOG_FREQ    10
+
+/* heap position of a virtual RTC that is not running */
+#define RTC_NOT_QUEUED      0xFFFFFFFF
+
+/* file descriptor flags */
+#define RTC_FLAG_ACTIVE     0x1     /* the fd's virtual RTC is running */
+#define RTC_FLAG_NONBLOCK   0x2     /* reads return right away instead of waiting for a tick */
+
+/* rtc_write mode word, passed after the frequency when nbytes >= 8 */
+#define RTC_NONBLOCK        0x1
+
+/* check if RTC time a is before time b, safe across the 32-bit wrap */
+#define RTC_BEFORE(a, b)    ((int32_t)((a) - (b)) < 0)
+
+/* virtual RTC of one open file descriptor */
+typedef struct rtc_vdev_t {
+    uint32_t log_freq;      /* log2 of the virtual frequency in Hz */
+    uint32_t period;        /* virtual period in 1/1024 s units */
+    uint32_t deadline;      /* RTC time of the next virtual tick */
+    uint32_t ticks;         /* virtual ticks since the last read */
+    uint32_t heap_idx;      /* position in the deadline heap, RTC_NOT_QUEUED when stopped */
+} rtc_vdev_t;
 
 /* initializes RTC */
 void init_RTC(void);
@@ -12,7 +12,9 @@ fops_jumptable_t stdin_jmptable = {
     terminal_read,
     NULL, // cannot write to stdin
     terminal_open,
-    NULL  // cannot close stdin
+    NULL, // cannot close stdin
+    NULL,
+    NULL  // cannot write to stdin
 };
 
 /* file operations jumptable for stdout */
@@ -20,7 +22,9 @@ fops_jumptable_t stdout_jmptable = {
     NULL, // cannot read from stdout
     terminal_write,
     terminal_open,
-    NULL  // cannot close stdout
+    NULL, // cannot close stdout
+    NULL, // cannot read from stdout
+    terminal_writev
 };
 
 uint32_t TA_idx;                        /* current active terminal */
@@ -50,9 +54,6 @@ void init_terminals() {
         memset(&terminal_arr[i].keyboard_buffer, 0x00, 128); // zero keyboard buffer
         terminal_arr[i].keyboard_idx = 0;
         terminal_arr[i].terminal_newline = 0;
-    
-        terminal_arr[i].rtc_interrupt_occurred = 0;
-        terminal_arr[i].rtc_freq_bit = 8; // terminals start with 2 Hz RTC
     }
 
     /* start at PID0 */
@@ -72,10 +73,13 @@ void set_shown_terminal(uint32_t next_TS_idx) {
     terminal_shown->cursor_x = getX();
     terminal_shown->cursor_y = getY();
 
+    // the shown screen may have scrolled down text memory, bring it back to the top first
+    resetScreenOrigin();
+
     // save video memory
-    memcpy((void*)(VMEM_BASE_ADDR + (TS_idx+1)*_4KB), (void*)VMEM_BASE_ADDR, _4KB);
+    memcpy((void*)VMEM_SAVED_ADDR(TS_idx), (void*)VMEM_BASE_ADDR, _4KB);
     // set video memory to the saved video memory
-    memcpy((void*)VMEM_BASE_ADDR, (void*)(VMEM_BASE_ADDR + (next_TS_idx+1)*_4KB), _4KB);
+    memcpy((void*)VMEM_BASE_ADDR, (void*)VMEM_SAVED_ADDR(next_TS_idx), _4KB);
 
     // update terminal shown
     TS_idx = next_TS_idx;
@@ -84,6 +88,34 @@ void set_shown_terminal(uint32_t next_TS_idx) {
     // update cursor and screen coords
     update_cursor(terminal_shown->cursor_x, terminal_shown->cursor_y);
     editScreenCoords(terminal_shown->cursor_x, terminal_shown->cursor_y);
+
+    // the new shown program may be using vidmap
+    update_screen_scroll();
+}
+
+/* update_screen_scroll - picks how the shown screen scrolls
+ *      a program using vidmap writes the page at VMEM_BASE_ADDR, so while the shown
+ *      terminal runs one the screen stays there and scrolls by copying; otherwise it
+ *      scrolls by moving the VGA start address
+ * Inputs: none
+ * Outputs: none
+ * Side Effects: may move the shown screen back to VMEM_BASE_ADDR and update the cursor
+ */
+void update_screen_scroll(void) {
+    pcb_t* shown_pcb; /* pcb of the program running on the shown terminal */
+
+    shown_pcb = (TA_idx == TS_idx) ? current_PCB : terminal_shown->currentPCB;
+    if (shown_pcb == NULL) {
+        return;
+    }
+    setScreenScroll(!shown_pcb->vidmap_inuse);
+
+    // the cursor is kept relative to the start of the screen
+    if (TA_idx == TS_idx) {
+        update_cursor(getX(), getY());
+    } else {
+        update_cursor(terminal_shown->cursor_x, terminal_shown->cursor_y);
+    }
 }
 
 /* TSS struct */
@@ -110,9 +142,9 @@ void set_active_terminal(uint32_t next_TA_idx) {
 
     // set vidmem pointer for printfs
     if (next_TA_idx != TS_idx) {
-        setVidPointer((char*)(VMEM_BASE_ADDR + (next_TA_idx+1)*_4KB));
+        setVidPointer((char*)VMEM_SAVED_ADDR(next_TA_idx));
     } else {
-        setVidPointer((char*)VMEM_BASE_ADDR);
+        setVidPointer(getScreenPointer());
     }
     
     // update terminal active
@@ -223,20 +255,46 @@ int32_t terminal_read(int32_t fd, void* buf, int32_t nbytes){
 /* terminal_write - writes an input buffer to the terminal given a length n
  * 
  * Inputs: uint8_t* fd - file descriptor array for process, uint8_t* buf - input buffer, uint32_t n - number of chars to write
- * Outputs: None
- * Side Effects: places characters onto the terminal and scrolls potentially
+ * Outputs: 0, -1 for a negative length
+ * Side Effects: places characters onto the terminal and scrolls potentially, moves the cursor once at the end
  */
 int32_t terminal_write(int32_t fd, const void* buf, int32_t nbytes){
-    uint32_t i;
-    
-    for(i = 0; i<nbytes; i++){
-        if (((char*)buf)[i] != '\0') {
-            putc(((uint8_t*)buf)[i]);
-        }
+    if (nbytes < 0) {
+        return -1;
+    }
+
+    putbuf_nocursor((const uint8_t*)buf, nbytes);
+
+    /* update cursor only if active is shown */
+    if (TA_idx == TS_idx) {
+        update_cursor(getX(), getY());
     }
     return 0;
 }
 
+/* terminal_writev - writes every segment of an iovec array to the terminal
+ * 
+ * Inputs: int32_t fd - file descriptor, const iovec_t* iov - segments to write, int32_t iovcnt - number of segments
+ * Outputs: number of bytes written
+ * Side Effects: places characters onto the terminal and scrolls potentially, moves the cursor once at the end
+ */
+int32_t terminal_writev(int32_t fd, const iovec_t* iov, int32_t iovcnt){
+    int32_t i;          /* segment idx */
+    int32_t written;    /* bytes written over all segments */
+
+    written = 0;
+    for (i = 0; i < iovcnt; i++) {
+        putbuf_nocursor((const uint8_t*)iov[i].base, iov[i].len);
+        written += iov[i].len;
+    }
+
+    /* update cursor only if active is shown */
+    if (TA_idx == TS_idx) {
+        update_cursor(getX(), getY());
+    }
+    return written;
+}
+
 /* terminal_open - doesnt do much
  * 
  * Inputs: None
@@ -20,9 +20,6 @@ typedef struct terminal_t {
     char keyboard_buffer[128];          /* keyboard buffer */
     uint32_t keyboard_idx;              /* idx of keyboard buffer */
     uint32_t terminal_newline;          /* new line flag for terminal */
-    
-    uint32_t rtc_interrupt_occurred;    /* flag to detect for if rtc interrupt occurred (1) or not (0) */
-    uint32_t rtc_freq_bit;              /* bit of the rtc counter to check for rtc frequency */
 } terminal_t;
 
 /* terminal initialization function */
@@ -34,6 +31,9 @@ void set_shown_terminal(uint32_t next_TS_idx);
 /* sets active terminal */
 void set_active_terminal(uint32_t next_TA_idx);
 
+/* hardware scrolls the shown screen unless its program uses vidmap */
+void update_screen_scroll(void);
+
 
 /* backspace handler for both visual terminal and buffer*/
 void backspace(uint8_t* buf, uint32_t* bufIdx);
@@ -44,6 +44,9 @@ int32_t terminal_read(int32_t fd, void* buf, int32_t nbytes);
 /* Writes from buffer to terminal */
 int32_t terminal_write(int32_t fd, const void* buf, int32_t nbytes);
 
+/* Writes all segments of an iovec array to terminal */
+int32_t terminal_writev(int32_t fd, const iovec_t* iov, int32_t iovcnt);
+
 /* Terminal open (unused) */
 int32_t terminal_open(const uint8_t* filename);
 
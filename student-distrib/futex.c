@@ -0,0 +1,143 @@
+#include "lib.h"
+#include "futex.h"
+#include "process.h"
+
+#include "./drivers/pit.h"
+
+/* hashed wait table, each bucket is a singly linked list of waiters */
+static futex_waiter_t* futex_table[FUTEX_HASH_SIZE];
+
+/* futex_hash - hashes a futex key into a wait table bucket
+ *
+ * Inputs: key - physical address of the futex word
+ * Outputs: bucket index in [0, FUTEX_HASH_SIZE)
+ * Side Effects: None
+ */
+static uint32_t futex_hash(uint32_t key) {
+    key >>= 2;                  // futex words are 4 byte aligned, low bits are always 0
+    key ^= key >> 7;            // fold higher bits in so words in different pages spread out
+    key ^= key >> 13;
+    return key & (FUTEX_HASH_SIZE - 1);
+}
+
+/* init_futex - futex wait table initialization
+ *
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: empties every bucket of the wait table
+ */
+void init_futex(void) {
+    uint32_t i; /* loop index */
+
+    for (i = 0; i < FUTEX_HASH_SIZE; i++) {
+        futex_table[i] = NULL;
+    }
+}
+
+/* futex_wait - blocks the current process while the futex word holds val
+ *      the compare and the enqueue happen with interrupts masked, so a wake
+ *      issued after the user saw the lock contended can never be lost
+ *
+ * Inputs: key - physical address of the futex word
+ *         uaddr - virtual address of the futex word in the current process
+ *         val - value the caller expects the futex word to hold
+ *         waiter - the current process' waiter entry
+ * Outputs: 0 when woken up, -1 if the futex word no longer holds val or a signal is pending
+ * Side Effects: yields the processor until a futex_wake on key dequeues waiter
+ */
+int32_t futex_wait(uint32_t key, volatile uint32_t* uaddr, uint32_t val, futex_waiter_t* waiter) {
+    futex_waiter_t** link;  /* link to append the waiter at */
+    uint32_t save;          /* variable to store flags */
+
+    cli_and_save(save);
+
+    // the lock was released before we got here, let the user retry
+    if (*uaddr != val) {
+        restore_flags(save);
+        return -1;
+    }
+
+    // append to the bucket so waiters are woken up in FIFO order
+    waiter->key = key;
+    waiter->queued = 1;
+    waiter->next = NULL;
+    link = &futex_table[futex_hash(key)];
+    while (*link != NULL) {
+        link = &(*link)->next;
+    }
+    *link = waiter;
+
+    restore_flags(save);
+
+    // give the slice to other terminals until someone wakes us up
+    while (waiter->queued) {
+        // let a pending signal run its handler or default action
+        if (current_PCB->signals.pending != 0 && !current_PCB->signals.masked) {
+            futex_cancel(waiter);
+            return -1;
+        }
+        schedule_yield();
+    }
+
+    return 0;
+}
+
+/* futex_cancel - takes a waiter out of the wait table without waking it up
+ *
+ * Inputs: waiter - waiter entry to remove, may or may not be queued
+ * Outputs: None
+ * Side Effects: unlinks waiter from its bucket
+ */
+void futex_cancel(futex_waiter_t* waiter) {
+    futex_waiter_t** link;  /* link pointing to the current waiter */
+    uint32_t save;          /* variable to store flags */
+
+    cli_and_save(save);
+
+    if (waiter->queued) {
+        link = &futex_table[futex_hash(waiter->key)];
+        while (*link != NULL && *link != waiter) {
+            link = &(*link)->next;
+        }
+        if (*link != NULL) {
+            *link = waiter->next;
+        }
+        waiter->next = NULL;
+        waiter->queued = 0;
+    }
+
+    restore_flags(save);
+}
+
+/* futex_wake - wakes up processes waiting on a futex
+ *
+ * Inputs: key - physical address of the futex word
+ *         count - maximum number of waiters to wake up
+ * Outputs: number of waiters woken up
+ * Side Effects: dequeues woken waiters from the wait table
+ */
+int32_t futex_wake(uint32_t key, uint32_t count) {
+    futex_waiter_t** link;  /* link pointing to the current waiter */
+    futex_waiter_t* waiter; /* current waiter */
+    int32_t woken = 0;      /* number of waiters woken up */
+    uint32_t save;          /* variable to store flags */
+
+    cli_and_save(save);
+
+    link = &futex_table[futex_hash(key)];
+    while (*link != NULL && (uint32_t)woken < count) {
+        waiter = *link;
+        if (waiter->key == key) {
+            // unlink and release the waiter
+            *link = waiter->next;
+            waiter->next = NULL;
+            waiter->queued = 0;
+            woken++;
+        } else {
+            link = &waiter->next;
+        }
+    }
+
+    restore_flags(save);
+    return woken;
+}
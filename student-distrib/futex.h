@@ -0,0 +1,35 @@
+/* futex.h - fast user-space locking wait table
+ * vim:ts=4 noexpandtab
+ */
+#ifndef _FUTEX_H
+#define _FUTEX_H
+
+#include "types.h"
+
+/* futex operations */
+#define FUTEX_WAIT          0
+#define FUTEX_WAKE          1
+
+/* number of buckets in the hashed wait table (power of 2) */
+#define FUTEX_HASH_SIZE     16
+
+/* a process waiting on a futex, one per PCB since a process waits on at most one futex */
+typedef struct futex_waiter_t {
+    uint32_t key;                       /* physical address of the futex word */
+    uint32_t queued;                    /* still waiting (1) or woken up (0) */
+    struct futex_waiter_t* next;        /* next waiter in the same hash bucket */
+} futex_waiter_t;
+
+/* initializes the futex wait table */
+void init_futex(void);
+
+/* blocks the current process while the futex word at key still holds val */
+int32_t futex_wait(uint32_t key, volatile uint32_t* uaddr, uint32_t val, futex_waiter_t* waiter);
+
+/* takes a waiter out of the wait table without waking it up */
+void futex_cancel(futex_waiter_t* waiter);
+
+/* wakes up to count processes waiting on key */
+int32_t futex_wake(uint32_t key, uint32_t count);
+
+#endif /* _FUTEX_H */
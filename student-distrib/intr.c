@@ -3,6 +3,9 @@
 #include "intr.h"
 #include "asm_wrapper.h"
 #include "syscall.h"
+#include "signal.h"
+#include "process.h"
+#include "page.h"
 
 /* flag to determine if exception was raised during program execution */
 uint8_t exception_flag;
@@ -47,6 +50,7 @@ void populate_IDT(void) {
     SET_IDT_ENTRY_INT_GATE (idt[0x20],                           &PIT_Wrap, KERNEL_CS,   DPL_PRIVILEGED, 0x1);
     SET_IDT_ENTRY_INT_GATE (idt[0x21],                      &Keyboard_Wrap, KERNEL_CS,   DPL_PRIVILEGED, 0x1);
     SET_IDT_ENTRY_INT_GATE (idt[0x28],                           &RTC_Wrap, KERNEL_CS,   DPL_PRIVILEGED, 0x1);
+    SET_IDT_ENTRY_INT_GATE (idt[0x2E],                           &ATA_Wrap, KERNEL_CS,   DPL_PRIVILEGED, 0x1);
 
     // setup syscall IDT entry
     SET_IDT_ENTRY_TRAP_GATE(idt[0x80],                   &System_Call_Wrap, KERNEL_CS, DPL_UNPRIVILEGED, 0x1);
@@ -59,10 +63,16 @@ void populate_IDT(void) {
  * 
  * Inputs: None
  * Outputs: None
- * Side Effects: halts running program
+ * Side Effects: raises DIV_ZERO for user programs with a handler, otherwise halts running program
  */
 void Divide_Error_Handler(void) {
     cli();
+    // let the user program's DIV_ZERO handler deal with its own faults
+    if (oldeip >= VIRTUAL_USER_BASE_ADDR && signal_catchable(SIG_DIV_ZERO)) {
+        send_signal(&current_PCB->signals, SIG_DIV_ZERO);
+        sti();
+        return;
+    }
     printf("Divide Error\n");
     exception_flag = 1;
     sti();
@@ -258,10 +268,16 @@ void General_Protection_Handler(void) {
 /* Page_Fault_Handler - interrupt handler for page fault
  * Inputs: None
  * Outputs: None
- * Side Effects: 
+ * Side Effects: raises SEGFAULT for user programs with a handler, otherwise halts running program
  */
 void Page_Fault_Handler(void) {
     cli();
+    // let the user program's SEGFAULT handler deal with its own faults
+    if (oldeip >= VIRTUAL_USER_BASE_ADDR && signal_catchable(SIG_SEGFAULT)) {
+        send_signal(&current_PCB->signals, SIG_SEGFAULT);
+        sti();
+        return;
+    }
     //clear();
     printf("Page Fault\n\tECODE: %x\n\tOLD EIP: %x\n\tSOURCE ADDR: %x\n", ecode, oldeip, source);
     exception_flag = 1;
@@ -30,6 +30,7 @@ extern void SIMD_Floating_Point_Exception_Wrap(void);
 extern void PIT_Wrap(void);
 extern void Keyboard_Wrap(void);
 extern void RTC_Wrap(void);
+extern void ATA_Wrap(void);
 extern void System_Call_Wrap(void);
 
 /* shared global variables for debugging */
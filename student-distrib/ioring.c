@@ -0,0 +1,103 @@
+#include "lib.h"
+#include "ioring.h"
+#include "page.h"
+#include "syscall.h"
+
+/* ioring_user_range - checks that a buffer lies within the user page
+ *
+ * Inputs: addr - user virtual address
+ *         len - bytes from addr
+ * Outputs: 1 if the buffer is in user memory, 0 otherwise
+ * Side Effects: None
+ */
+static uint32_t ioring_user_range(uint32_t addr, int32_t len) {
+    return len >= 0 && VIRTUAL_USER_BASE_ADDR <= addr && (uint32_t)len <= _4MB &&
+           addr <= VIRTUAL_USER_BASE_ADDR + _4MB - len;
+}
+
+/* ioring_user_path - checks that a path lies within the user page
+ *
+ * Inputs: addr - user virtual address of the path
+ * Outputs: 1 if every byte up to the terminator is in user memory and the path is at most
+ *          MAX_PATH_LEN bytes long, 0 otherwise
+ * Side Effects: None
+ */
+static uint32_t ioring_user_path(uint32_t addr) {
+    uint32_t i; /* loop index */
+
+    for (i = 0; i <= MAX_PATH_LEN; i++) {
+        if (!ioring_user_range(addr + i, 1)) {
+            return 0;
+        }
+        if (((const uint8_t*)addr)[i] == '\0') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* ioring_run - runs one submission through the matching syscall
+ *
+ * Inputs: sqe - kernel copy of the submission
+ * Outputs: what the syscall returned, -1 for a bad opcode or buffer
+ * Side Effects: those of the syscall, a read may block
+ */
+static int32_t ioring_run(ioring_sqe_t* sqe) {
+    switch (sqe->opcode) {
+        case IORING_OP_READ:
+            if (!ioring_user_range(sqe->addr, sqe->len)) {
+                return -1;
+            }
+            return read(sqe->fd, (void*)sqe->addr, sqe->len);
+        case IORING_OP_WRITE:
+            if (!ioring_user_range(sqe->addr, sqe->len)) {
+                return -1;
+            }
+            return write(sqe->fd, (const void*)sqe->addr, sqe->len);
+        case IORING_OP_OPEN:
+            if (!ioring_user_path(sqe->addr)) {
+                return -1;
+            }
+            return open((const uint8_t*)sqe->addr);
+        case IORING_OP_CLOSE:
+            return close(sqe->fd);
+        default:
+            return -1;
+    }
+}
+
+/* ioring_submit - runs queued submissions of a ring in order
+ *      each submission is copied out before it runs, so the process cannot change it
+ *      half way; the heads and tails are written back after every entry, so a read
+ *      that blocks leaves a ring the process can make sense of
+ *
+ * Inputs: ring - registered ring, in the user page of the current process
+ *         to_submit - most submissions to run
+ * Outputs: number of submissions run, stops early when the submission ring runs empty
+ *          or the completion ring fills up; -1 for inconsistent heads and tails
+ * Side Effects: advances sq_head and cq_tail, fills completions
+ */
+int32_t ioring_submit(ioring_t* ring, uint32_t to_submit) {
+    uint32_t sq_head = ring->sq_head;   /* next submission to run */
+    uint32_t sq_tail = ring->sq_tail;   /* end of the queued submissions */
+    uint32_t cq_head = ring->cq_head;   /* oldest completion the process has not read */
+    uint32_t cq_tail = ring->cq_tail;   /* next completion slot */
+    ioring_sqe_t sqe;                   /* copy of the current submission */
+    int32_t res;                        /* result of the current submission */
+    uint32_t done;                      /* submissions run so far */
+
+    if (sq_tail - sq_head > IORING_ENTRIES || cq_tail - cq_head > IORING_ENTRIES) {
+        return -1;
+    }
+
+    for (done = 0; done < to_submit && sq_head != sq_tail && cq_tail - cq_head < IORING_ENTRIES; done++) {
+        sqe = ring->sqes[sq_head & IORING_MASK];
+        res = ioring_run(&sqe);
+
+        ring->cqes[cq_tail & IORING_MASK].user_data = sqe.user_data;
+        ring->cqes[cq_tail & IORING_MASK].res = res;
+        ring->sq_head = ++sq_head;
+        ring->cq_tail = ++cq_tail;
+    }
+    return done;
+}
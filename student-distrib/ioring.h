@@ -0,0 +1,56 @@
+/* ioring.h - submission/completion rings for batched file I/O
+ * vim:ts=4 noexpandtab
+ */
+#ifndef _IORING_H
+#define _IORING_H
+
+#include "types.h"
+
+/*
+ * A process registers one page of its own memory holding both rings. It
+ * queues entries at sq_tail and advances it, then one ring_enter runs them
+ * in order through the read/write/open/close syscalls and posts a completion
+ * for each at cq_tail. The process consumes completions by advancing cq_head.
+ * Heads and tails run freely and index the rings modulo IORING_ENTRIES.
+ */
+#define IORING_ENTRIES      64      /* entries in each ring, power of 2 */
+#define IORING_MASK         (IORING_ENTRIES - 1)
+#define IORING_SIZE         4096    /* the rings share one page */
+
+/* submission opcodes */
+#define IORING_OP_READ      0       /* read(fd, addr, len) */
+#define IORING_OP_WRITE     1       /* write(fd, addr, len) */
+#define IORING_OP_OPEN      2       /* open(addr), fd and len unused */
+#define IORING_OP_CLOSE     3       /* close(fd), addr and len unused */
+
+/* submission queue entry */
+typedef struct ioring_sqe_t {
+    uint32_t opcode;                /* IORING_OP_* */
+    int32_t fd;                     /* file descriptor the operation uses */
+    uint32_t addr;                  /* user buffer or path */
+    int32_t len;                    /* bytes to read or write */
+    uint32_t user_data;             /* copied into the completion untouched */
+    uint32_t reserved[3];
+} ioring_sqe_t;
+
+/* completion queue entry */
+typedef struct ioring_cqe_t {
+    uint32_t user_data;             /* user_data of the submission */
+    int32_t res;                    /* what the syscall returned */
+} ioring_cqe_t;
+
+/* layout of the registered page */
+typedef struct ioring_t {
+    uint32_t sq_head;               /* next submission the kernel runs, written by the kernel */
+    uint32_t sq_tail;               /* next free submission slot, written by the process */
+    uint32_t cq_head;               /* next completion the process reads, written by the process */
+    uint32_t cq_tail;               /* next free completion slot, written by the kernel */
+    uint32_t reserved[4];
+    ioring_sqe_t sqes[IORING_ENTRIES];
+    ioring_cqe_t cqes[IORING_ENTRIES];
+} ioring_t;
+
+/* runs up to to_submit queued submissions of a registered ring */
+int32_t ioring_submit(ioring_t* ring, uint32_t to_submit);
+
+#endif /* _IORING_H */
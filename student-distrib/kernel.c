@@ -11,6 +11,9 @@
 #include "intr.h"
 #include "page.h"
 #include "syscall.h"
+#include "futex.h"
+#include "timer.h"
+#include "vfs.h"
 
 #include "./drivers/i8259.h"
 #include "./drivers/rtc.h"
@@ -18,6 +21,9 @@
 #include "./drivers/terminal.h"
 #include "./drivers/fsys.h"
 #include "./drivers/pit.h"
+#include "./drivers/blkdev.h"
+#include "./drivers/bcache.h"
+#include "./drivers/ata.h"
 
 #define RUN_TESTS
 
@@ -26,6 +32,8 @@
 void entry(unsigned long magic, unsigned long addr) {
 
     multiboot_info_t *mbi;
+    uint32_t fsys_loaded = 0;   /* a file system image was mounted */
+    uint32_t i;                 /* loop index */
 
     /* Clear the screen. */
     clear();
@@ -54,15 +62,26 @@ void entry(unsigned long magic, unsigned long addr) {
     if (CHECK_FLAG(mbi->flags, 2))
         printf("cmdline = %s\n", (char *)mbi->cmdline);
 
+    /* The file system reads its image through the block layer and the buffer cache */
+    printf("Initializing Block Devices\n");
+    init_blkdev();
+    init_bcache();
+
     if (CHECK_FLAG(mbi->flags, 3)) {
         int mod_count = 0;
         int i;
         module_t* mod = (module_t*)mbi->mods_addr;
-        printf("Initializing File System\n");
-        init_fsys((uint32_t) ((module_t*) mbi->mods_addr)->mod_start);
+        int8_t mount_path[] = "/mod0";  /* mount point of a module after the first */
+        if (mbi->mods_count > 0) {
+            printf("Initializing File System\n");
+        }
         while (mod_count < mbi->mods_count) {
             printf("Module %d loaded at address: 0x%#x\n", mod_count, (unsigned int)mod->mod_start);
-            // init_fsys((uint32_t)mod->mod_start);
+            // the first module is "/", the others are mounted as /mod1, /mod2, ...
+            mount_path[4] = '0' + mod_count;
+            if (vfs_mount((mod_count == 0) ? "/" : mount_path, init_fsys((uint32_t)mod->mod_start)) == 0 && mod_count == 0) {
+                fsys_loaded = 1;
+            }
             printf("Module %d ends at address: 0x%#x\n", mod_count, (unsigned int)mod->mod_end);
             printf("First few bytes of module:\n");
             for (i = 0; i < 16; i++) {
@@ -161,12 +180,36 @@ void entry(unsigned long magic, unsigned long addr) {
     printf("Initializing Terminals\n");
     init_terminals();
 
+    printf("Initializing Futexes\n");
+    init_futex();
+
     printf("Initializing RTC\n");
     init_RTC();
 
     printf("Initializing Keyboard\n");
     init_Keyboard();
 
+    printf("Initializing Timers\n");
+    init_timers();
+
+    printf("Initializing ATA\n");
+    printf("ATA drives found: %d\n", init_ATA());
+
+    // without a GRUB module the file system is mounted from disk
+    for (i = 0; !fsys_loaded && blk_get(i) != NULL; i++) {
+        printf("Loading File System from %s\n", blk_get(i)->name);
+        fsys_loaded = (vfs_mount("/", fsys_load_disk(blk_get(i), DISK_MEM_BASE_ADDR, DISK_MEM_SIZE)) == 0);
+    }
+
+#ifdef RUN_TESTS
+    /* Run tests, before the PIT starts the shells so they own the current process;
+     * the RTC tests need interrupts */
+    // sti();
+    // launch_tests();
+    // cli();
+#endif
+
+    // the PIT starts the base shells, the file system has to be mounted first
     printf("Initializing PIT\n");
     init_PIT();
 
@@ -178,10 +221,6 @@ void entry(unsigned long magic, unsigned long addr) {
     printf("Enabling Interrupts\n");
     sti();
 
-#ifdef RUN_TESTS
-    /* Run tests */
-    // launch_tests();
-#endif
     /* Execute the first program ("shell") ... */
 
     /* should not enter here if PIT interrupts before this */
@@ -2,15 +2,21 @@
  * vim:ts=4 noexpandtab */
 
 #include "lib.h"
+#include "page.h"
 
 #define VIDEO       0xB8000
 #define NUM_COLS    80
 #define NUM_ROWS    25
 #define ATTRIB      0x7
+#define PUTBUF_CHUNK    (NUM_ROWS * NUM_COLS)   /* most bytes putbuf renders with interrupts off */
+#define TAB_WIDTH       4                       /* spaces a tab prints */
+#define SCROLL_ROWS     ((VMEM_SCROLL_PAGES * _4KB) / (NUM_COLS << 1))  /* rows of text memory the shown screen moves through */
 
 static int screen_x;
 static int screen_y;
 static char* video_mem = (char *)VIDEO;
+static uint32_t screen_origin;          /* row of text memory the shown screen starts at */
+static uint32_t screen_hw_scroll = 1;   /* the shown screen scrolls by moving the CRTC start address (1) or by copying (0) */
 
 /* void clear(void);
  * Inputs: void
@@ -55,6 +61,64 @@ void setVidPointer(char* ptr) {
     video_mem = ptr;
 }
 
+/* getScreenPointer - gets the start of the shown screen
+ *      the shown screen moves down text memory as it scrolls, video_mem has to be set
+ *      to this rather than VIDEO to print to it
+ * Inputs: none
+ * Outputs: first cell of the shown screen
+ * Side Effects: none
+ */
+char* getScreenPointer(void) {
+    return (char*)VIDEO + ((NUM_COLS * screen_origin) << 1);
+}
+
+/* set_screen_start - points the CRTC start address at a row of text memory
+ * Inputs: row - row the display starts at
+ * Outputs: none
+ * Side Effects: the VGA shows the NUM_ROWS rows from row on
+ */
+static void set_screen_start(uint32_t row) {
+    uint16_t pos = row * NUM_COLS;
+    outb(0x0C, 0x3D4);
+    outb((uint8_t) ((pos >> 8) & 0xFF), 0x3D5);
+    outb(0x0D, 0x3D4);
+    outb((uint8_t) (pos & 0xFF), 0x3D5);
+}
+
+/* resetScreenOrigin - moves the shown screen back to the top of text memory
+ * Inputs: none
+ * Outputs: none
+ * Side Effects: copies the screen to VIDEO, moves video_mem with it if it pointed at the
+ *               shown screen; the hardware cursor has to be updated after
+ */
+void resetScreenOrigin(void) {
+    char* screen = getScreenPointer();  /* shown screen before the move */
+    uint32_t save;                      /* variable to store flags */
+
+    cli_and_save(save);
+    if (screen_origin != 0) {
+        memmove((char*)VIDEO, screen, (NUM_COLS * NUM_ROWS) << 1);
+        if (video_mem == screen) {
+            video_mem = (char*)VIDEO;
+        }
+        screen_origin = 0;
+        set_screen_start(0);
+    }
+    restore_flags(save);
+}
+
+/* setScreenScroll - picks how the shown screen scrolls
+ * Inputs: hw - move the CRTC start address (1), or copy the screen up and stay at VIDEO (0)
+ * Outputs: none
+ * Side Effects: turning hardware scrolling off moves the screen back to VIDEO
+ */
+void setScreenScroll(uint32_t hw) {
+    if (!hw) {
+        resetScreenOrigin();
+    }
+    screen_hw_scroll = hw;
+}
+
 /* Standard printf().
  * Only supports the following format strings:
  * %%  - print a literal '%' character
@@ -204,6 +268,20 @@ extern uint32_t TS_idx;
  * Return Value: void
  *  Function: Output a character to the console */
 void putc(uint8_t c) {
+    putc_nocursor(c);
+
+    /* update cursor only if active is shown */
+    if (TA_idx == TS_idx) {
+        update_cursor(screen_x, screen_y);
+    }
+}
+
+/* void putc_nocursor(uint8_t c);
+ * Inputs: uint_8* c = character to print
+ * Return Value: void
+ *  Function: Output a character to the console without moving the hardware
+ *            cursor, for callers printing a run of characters */
+void putc_nocursor(uint8_t c) {
     uint16_t i;
     if(c == '\n' || c == '\r') {
         
@@ -232,12 +310,130 @@ void putc(uint8_t c) {
         // screen_x %= NUM_COLS;
         // screen_y = (screen_y + (screen_x / NUM_COLS)) % NUM_ROWS;
     }
+}
+/* static void putbuf_step(int32_t* y, uint32_t* scrolls);
+ * Inputs: int32_t* y = row of the cursor, uint32_t* scrolls = lines scrolled so far
+ * Return Value: void
+ *  Function: Moves the cursor row down a line the way putc would, counting a
+ *            scroll instead of doing it when the cursor is on the last row */
+static void putbuf_step(int32_t* y, uint32_t* scrolls) {
+    if (*y == NUM_ROWS - 1) {
+        (*scrolls)++;
+    } else {
+        (*y)++;
+    }
+}
 
-    /* update cursor only if active is shown */
-    if (TA_idx == TS_idx) {
-        update_cursor(screen_x, screen_y);
+/* static void putbuf_chunk(const uint8_t* buf, uint32_t n);
+ * Inputs: const uint8_t* buf = characters to print, uint32_t n = number of characters
+ * Return Value: void
+ *  Function: Output a buffer the way putc_nocursor would one character at a time.
+ *            The first pass counts the lines the buffer scrolls off, the screen is
+ *            scrolled by that much once, then the second pass writes the characters
+ *            into their final rows; characters on rows that scrolled off are skipped.
+ *            Must be called with interrupts disabled */
+static void putbuf_chunk(const uint8_t* buf, uint32_t n) {
+    uint16_t* cells = (uint16_t*)video_mem;    /* character and attribute of each cell */
+    uint32_t scrolls = 0;                       /* lines the buffer scrolls off */
+    int32_t x = screen_x;                       /* column of the cursor */
+    int32_t y = screen_y;                       /* row of the cursor */
+    uint32_t i;                                 /* buffer idx */
+    uint32_t j;                                 /* loop idx */
+    uint8_t c;                                  /* current character */
+
+    // count the scrolls without touching video memory
+    for (i = 0; i < n; i++) {
+        c = buf[i];
+        if (c == '\0') {
+            continue;
+        }
+        if (c == '\n' || c == '\r') {
+            putbuf_step(&y, &scrolls);
+            x = 0;
+            continue;
+        }
+        for (j = (c == '\t') ? TAB_WIDTH : 1; j > 0; j--) {
+            if (++x == NUM_COLS) {
+                putbuf_step(&y, &scrolls);
+                x = 0;
+            }
+        }
     }
+
+    // scroll once, rows start out above the screen by the lines that scroll off
+    scrollLines((scrolls < NUM_ROWS) ? scrolls : NUM_ROWS);
+    cells = (uint16_t*)video_mem;               // scrolling may have moved the shown screen
+    x = screen_x;
+    y = screen_y - (int32_t)scrolls;
+
+    for (i = 0; i < n; i++) {
+        c = buf[i];
+        if (c == '\0') {
+            continue;
+        }
+        if (c == '\n' || c == '\r') {
+            y++;
+            x = 0;
+            continue;
+        }
+        if (c == '\t') {
+            for (j = 0; j < TAB_WIDTH; j++) {
+                if (y >= 0) {
+                    cells[NUM_COLS * y + x] = ' ' | (ATTRIB << 8);
+                }
+                if (++x == NUM_COLS) {
+                    y++;
+                    x = 0;
+                }
+            }
+            continue;
+        }
+
+        // run of printable characters to the end of the row
+        for (; i < n && x < NUM_COLS; i++) {
+            c = buf[i];
+            if (c == '\0' || c == '\n' || c == '\r' || c == '\t') {
+                break;
+            }
+            if (y >= 0) {
+                cells[NUM_COLS * y + x] = c | (ATTRIB << 8);
+            }
+            x++;
+        }
+        if (x == NUM_COLS) {
+            y++;
+            x = 0;
+        }
+        i--; // the loop moves past the last character of the run
+    }
+
+    screen_x = x;
+    screen_y = y;
 }
+
+/* void putbuf_nocursor(const uint8_t* buf, uint32_t n);
+ * Inputs: const uint8_t* buf = characters to print, uint32_t n = number of characters
+ * Return Value: void
+ *  Function: Output a buffer to the console without moving the hardware cursor,
+ *            same output as putc_nocursor on each character but scrolls at most
+ *            once per PUTBUF_CHUNK bytes */
+void putbuf_nocursor(const uint8_t* buf, uint32_t n) {
+    uint32_t len;   /* bytes of the current chunk */
+    uint32_t save;  /* variable to store flags */
+
+    while (n > 0) {
+        len = (n < PUTBUF_CHUNK) ? n : PUTBUF_CHUNK;
+
+        // the keyboard handler and terminal switches move screen_x, screen_y and video_mem
+        cli_and_save(save);
+        putbuf_chunk(buf, len);
+        restore_flags(save);
+
+        buf += len;
+        n -= len;
+    }
+}
+
 /* void putc(uint8_t c);
  * Inputs: uint_8* c = character to print
  * Return Value: void
@@ -265,7 +461,7 @@ void putc_simple(uint8_t c){
 }
 
 void update_cursor(uint32_t x, uint32_t y){
-	uint16_t pos = y * NUM_COLS + x;
+	uint16_t pos = (screen_origin + y) * NUM_COLS + x;
 	outb(0x0F, 0x3D4);
 	outb((uint8_t) (pos & 0xFF), 0x3D5);
 	outb(0x0E, 0x3D4);
@@ -273,15 +469,41 @@ void update_cursor(uint32_t x, uint32_t y){
 }
 
 void scrollLine(void){
-    uint16_t i = 0;
-    for (i = 0; i < (NUM_ROWS-1) * (NUM_COLS); i++) {
-        *(uint8_t *)(video_mem + (i << 1)) = *(uint8_t *)(video_mem + ((i+NUM_COLS) << 1));
-        *(uint8_t *)(video_mem + (i << 1) + 1) = ATTRIB;
+    scrollLines(1);
+}
+
+/* void scrollLines(uint32_t n);
+ * Inputs: uint32_t n = lines to scroll, at most NUM_ROWS
+ * Return Value: void
+ *  Function: Moves the screen up n lines and blanks the n rows at the bottom.
+ *            The shown screen moves n rows down text memory instead and the CRTC
+ *            start address follows it, so only the new rows are written; once it
+ *            reaches the end of the SCROLL_ROWS window the rows that stay are copied
+ *            back to the top. A saved screen is moved up with one copy */
+void scrollLines(uint32_t n) {
+    uint32_t save;  /* variable to store flags */
+
+    if (n == 0) {
+        return;
     }
-    for (i = (NUM_ROWS-1) * (NUM_COLS); i < NUM_ROWS * (NUM_COLS); i++) {
-        *(uint8_t *)(video_mem + (i << 1)) = ' ';
-        *(uint8_t *)(video_mem + (i << 1) + 1) = ATTRIB;
+
+    cli_and_save(save);
+    if (screen_hw_scroll && video_mem == getScreenPointer()) {
+        if (screen_origin + n + NUM_ROWS <= SCROLL_ROWS) {
+            screen_origin += n;
+        } else {
+            if (n < NUM_ROWS) {
+                memmove((char*)VIDEO, video_mem + ((NUM_COLS * n) << 1), (NUM_COLS * (NUM_ROWS - n)) << 1);
+            }
+            screen_origin = 0;
+        }
+        video_mem = getScreenPointer();
+        set_screen_start(screen_origin);
+    } else if (n < NUM_ROWS) {
+        memmove(video_mem, video_mem + ((NUM_COLS * n) << 1), (NUM_COLS * (NUM_ROWS - n)) << 1);
     }
+    memset_word(video_mem + ((NUM_COLS * (NUM_ROWS - n)) << 1), ' ' | (ATTRIB << 8), NUM_COLS * n);
+    restore_flags(save);
 }
 
 /* int8_t* itoa(uint32_t value, int8_t* buf, int32_t radix);
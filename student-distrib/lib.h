@@ -15,6 +15,8 @@ void test_interrupts(void);
 
 int32_t printf(int8_t *format, ...);
 void putc(uint8_t c);
+void putc_nocursor(uint8_t c);
+void putbuf_nocursor(const uint8_t* buf, uint32_t n);
 int32_t puts(int8_t *s);
 int8_t *itoa(uint32_t value, int8_t* buf, int32_t radix);
 int8_t *strrev(int8_t* s);
@@ -33,8 +35,13 @@ uint16_t getY(void);
 char* getVidPointer(void);
 /* setter for video_mem */
 void setVidPointer(char* ptr);
+/* start of the shown screen, which moves as it scrolls */
+char* getScreenPointer(void);
+void resetScreenOrigin(void);
+void setScreenScroll(uint32_t hw);
 void update_cursor(uint32_t x, uint32_t y);
 void scrollLine(void);
+void scrollLines(uint32_t n);
 
 void* memset(void* s, int32_t c, uint32_t n);
 void* memset_word(void* s, int32_t c, uint32_t n);
@@ -116,7 +123,7 @@ do {                                    \
 /* Writes four bytes to four consecutive ports */
 #define outl(data, port)                \
 do {                                    \
-    asm volatile ("outl %l1, (%w0)"     \
+    asm volatile ("outl %k1, (%w0)"     \
             :                           \
             : "d"(port), "a"(data)      \
             : "memory", "cc"            \
@@ -6,6 +6,7 @@
 /* page tables, 4KB aligned */
 pte_desc_t page_table[PAGE_TABLE_NUM] __attribute__ ((aligned (4096)));
 pte_desc_t user_page_table[PAGE_TABLE_NUM] __attribute__ ((aligned (4096)));
+pte_desc_t mmap_page_tables[MAX_PROCESSES][PAGE_TABLE_NUM] __attribute__ ((aligned (4096)));
 
 /* init_Paging - paging initialization
  * 
@@ -24,24 +25,31 @@ void init_Paging(void) {
         SET_PT_ENTRY(page_table[i], _4KB*i, 0x0, PAGE_UNPRIVILEGED, 0x1, 0x0); // each page is 4KB
     }
     
-    // initialize the video memory page
-    SET_PT_ENTRY(page_table[VMEM_BASE_ADDR >> 12], VMEM_BASE_ADDR, 0x0, PAGE_PRIVILEGED, 0x1, 0x1);
+    // initialize the video memory pages the shown screen scrolls through
+    for (i = 0; i < VMEM_SCROLL_PAGES; i++) {
+        SET_PT_ENTRY(page_table[(VMEM_BASE_ADDR >> 12) + i], VMEM_BASE_ADDR + i*_4KB, 0x0, PAGE_PRIVILEGED, 0x1, 0x1);
+    }
     
     // initialize the saved video memory pages
     for (i = 0; i < MAX_TERMINALS; i++) {
-        SET_PT_ENTRY(page_table[(VMEM_BASE_ADDR >> 12) + i + 1], VMEM_BASE_ADDR + (i+1)*_4KB, 0x0, PAGE_PRIVILEGED, 0x1, 0x1);
+        SET_PT_ENTRY(page_table[VMEM_SAVED_ADDR(i) >> 12], VMEM_SAVED_ADDR(i), 0x0, PAGE_PRIVILEGED, 0x1, 0x1);
     }
 
     // initialize the page directory
     SET_4KB_PD_ENTRY(page_dir[0], page_table, 0x0, PAGE_PRIVILEGED, 0x1, 0x1);
     // initialize the kernel page (which is stored directly in page directory)
     SET_4MB_PD_ENTRY(page_dir[1], KERNEL_MEM_BASE_ADDR, 0x0, PAGE_PRIVILEGED, 0x1, 0x1);
+    // initialize the disk memory pages, virtual and physical addresses match so the disk can DMA into them
+    for (i = 0; i < DISK_MEM_SIZE / _4MB; i++) {
+        SET_4MB_PD_ENTRY(page_dir[DISK_MEM_PD_ENTRY + i], DISK_MEM_BASE_ADDR + i*_4MB, 0x0, PAGE_PRIVILEGED, 0x1, 0x1);
+    }
 
     // enable paging
     enable_paging();
 }
 
 /* set_user_page - sets a 4MB page at virtual address [128MB, 132MB)
+ *      along with the process' mmap page table at [136MB, 140MB)
  * 
  * Inputs: pid - pid of user process
  * Outputs: None
@@ -50,6 +58,9 @@ void init_Paging(void) {
 void set_user_page(uint32_t pid) { 
     // places PID page
     SET_4MB_PD_ENTRY(page_dir[USER_MEM_PD_ENTRY], USER_MEM_BASE_ADDR + pid * _4MB, 0x0, PAGE_UNPRIVILEGED, 0x1, 0x1);
+
+    // places PID mmap pages, each page table entry decides if its page is present
+    SET_4KB_PD_ENTRY(page_dir[MMAP_PD_ENTRY], mmap_page_tables[pid], 0x0, PAGE_UNPRIVILEGED, 0x1, 0x1);
     
     // flush TLB everytime we change the page directory
     flush_tlb();
@@ -71,7 +82,7 @@ void set_video_mem_page(uint32_t present) {
 
     // set the video memory page according to shown and active terminals
     if (TA_idx != TS_idx) {
-        SET_PT_ENTRY(user_page_table[(VIRTUAL_VMEM_BASE_ADDR >> 12) & 0x3FF], VMEM_BASE_ADDR + (TA_idx+1)*_4KB, 0x0, PAGE_UNPRIVILEGED, 0x1, present & 1);
+        SET_PT_ENTRY(user_page_table[(VIRTUAL_VMEM_BASE_ADDR >> 12) & 0x3FF], VMEM_SAVED_ADDR(TA_idx), 0x0, PAGE_UNPRIVILEGED, 0x1, present & 1);
     } else {
         SET_PT_ENTRY(user_page_table[(VIRTUAL_VMEM_BASE_ADDR >> 12) & 0x3FF], VMEM_BASE_ADDR, 0x0, PAGE_UNPRIVILEGED, 0x1, present & 1);
     }
@@ -79,3 +90,47 @@ void set_video_mem_page(uint32_t present) {
     // flush TLB everytime we change the page table
     flush_tlb();
 }
+
+/* clear_mmap_pages - unmaps every page of a process' mmap region
+ * 
+ * Inputs: pid - pid of the process
+ * Outputs: None
+ * Side Effects: flushes the TLB
+ */
+void clear_mmap_pages(uint32_t pid) {
+    uint32_t i; /* loop index */
+
+    for (i = 0; i < PAGE_TABLE_NUM; i++) {
+        SET_PT_ENTRY(mmap_page_tables[pid][i], 0x0, 0x0, PAGE_UNPRIVILEGED, 0x0, 0x0);
+    }
+
+    // flush TLB everytime we change the page table
+    flush_tlb();
+}
+
+/* set_mmap_page - maps a read-only 4KB page in a process' mmap region
+ *      the TLB is not flushed, the page was not present before
+ * 
+ * Inputs: pid - pid of the process
+ *         page_idx - page index within the mmap region
+ *         phys_addr - 4KB aligned physical address to map
+ * Outputs: None
+ * Side Effects: None
+ */
+void set_mmap_page(uint32_t pid, uint32_t page_idx, uint32_t phys_addr) {
+    SET_PT_ENTRY(mmap_page_tables[pid][page_idx], phys_addr, 0x0, PAGE_UNPRIVILEGED, 0x0, 0x1);
+}
+
+/* get_mmap_page - gets the physical address a page of a process' mmap region maps
+ * 
+ * Inputs: pid - pid of the process
+ *         page_idx - page index within the mmap region
+ * Outputs: 4KB aligned physical address, 0 if the page is not present
+ * Side Effects: None
+ */
+uint32_t get_mmap_page(uint32_t pid, uint32_t page_idx) {
+    if (!mmap_page_tables[pid][page_idx].present) {
+        return 0;
+    }
+    return mmap_page_tables[pid][page_idx].page_base_addr << 12;
+}
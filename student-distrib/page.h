@@ -12,17 +12,32 @@
 
 /* beginning address of video memory page */
 #define VMEM_BASE_ADDR          0x000B8000
+/* pages of text memory the shown screen moves through when it scrolls, see scrollLines */
+#define VMEM_SCROLL_PAGES       5
+/* saved screen of a terminal, the pages after the scroll window up to the end of the 32KB text memory */
+#define VMEM_SAVED_ADDR(idx)    (VMEM_BASE_ADDR + (VMEM_SCROLL_PAGES + (idx)) * _4KB)
 /* beginning address of kernel 4MB page */
 #define KERNEL_MEM_BASE_ADDR    0x00400000
 /* User programs start a 8mb physical memory */
 #define USER_MEM_BASE_ADDR      0x00800000
+/* disk images are loaded at 40MB, past the last user page, and identity mapped for DMA */
+#define DISK_MEM_BASE_ADDR      0x02800000
+#define DISK_MEM_SIZE           0x00800000
 /* User programs start a 128MB virtual memory */
 #define VIRTUAL_USER_BASE_ADDR  0x08000000
+/* executables are loaded here, the rest of the user page up to 132MB holds the image and the user stack */
+#define PROGRAM_IMAGE_ADDR      0x08048000
 /* User programs can use this fixed virtual address to access video memory (arbitrary) */
 #define VIRTUAL_VMEM_BASE_ADDR  0x08401000
+/* mmap'd file pages of a process live in [136MB, 140MB) virtual memory */
+#define VIRTUAL_MMAP_BASE_ADDR  0x08800000
 
+/* 40MB virtual address, first of the two page directory entries of the disk memory */
+#define DISK_MEM_PD_ENTRY       10
 /* 128MB virtual address, page directory is divided up into 4mb slices 128mb/4mb = 32 */
 #define USER_MEM_PD_ENTRY       32
+/* 136MB virtual address, page directory entry for the mmap page tables */
+#define MMAP_PD_ENTRY           34
 
 /* number of page directory entries */
 #define PAGE_DIR_NUM       1024 // number of page directory entries in page directory
@@ -46,4 +61,13 @@ void set_user_page(uint32_t);
 /* sets a user page for video memory access */
 void set_video_mem_page(uint32_t present);
 
+/* unmaps every mmap page of a process */
+void clear_mmap_pages(uint32_t pid);
+
+/* maps a read-only 4KB page in a process' mmap region */
+void set_mmap_page(uint32_t pid, uint32_t page_idx, uint32_t phys_addr);
+
+/* gets the physical address a page of a process' mmap region maps */
+uint32_t get_mmap_page(uint32_t pid, uint32_t page_idx);
+
 #endif /* _PAGE_H */
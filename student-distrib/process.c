@@ -3,6 +3,19 @@
 #include "page.h"
 #include "syscall.h"
 
+/* jumptables of the terminal */
+extern fops_jumptable_t stdin_jmptable;
+extern fops_jumptable_t stdout_jmptable;
+
+/* the terminal entries are shared by every process and never freed */
+file_desc_t open_file_table[MAX_OPEN_FILES] = {
+    { &stdin_jmptable, 0, 0, 0 },   // STDIN_FILE, no inode or file position
+    { &stdout_jmptable, 0, 0, 0 }   // STDOUT_FILE, no inode or file position
+};
+
+/* fd tables of processes that opened more than FD_INLINE files, one per pid so growing never runs out */
+static file_desc_t* fd_table_pool[MAX_PROCESSES][MAX_FDS];
+
 /* restore_parent - helper function that restores parent context
  * 
  * Inputs: None
@@ -10,14 +23,8 @@
  * Side Effects: Reverts the esp to parent context, changes the user program page to point to the parent process, chagnes currentPCB and PID to parent
  */
 int32_t restore_parent() {
-    uint32_t i; /* loop index */
-
-    // close all open files except stdin (fd=0), stdout (fd=1)
-    for (i = 2; i < MAX_FDS; i++) {
-        if (current_PCB->open_files & (1 << i)) {
-            (current_PCB->file_desc_arr[i]).fops_table_ptr->close(i); // no error checking because close always returns 0
-        }
-    }
+    // close all open files, stdin and stdout included
+    release_fds();
 
     // restore ESP0 to the ESP0 of the parent process
     tss.esp0 = current_PCB->parent_esp0;
@@ -37,3 +44,229 @@ int32_t restore_parent() {
 
     return 0;
 }
+
+/* init_fds - sets up the fd table of a new process
+ *
+ * Inputs: pcb - pcb of the process
+ * Outputs: None
+ * Side Effects: fd 0 is stdin and fd 1 is stdout, the table holds FD_INLINE fds
+ */
+void init_fds(pcb_t* pcb) {
+    uint32_t i; /* loop index */
+
+    for (i = 0; i < MAX_FDS / 32; i++) {
+        pcb->fd_map[i] = 0;
+    }
+    pcb->fd_limit = FD_INLINE;
+    pcb->fd_table = pcb->fd_inline;
+
+    pcb->fd_table[0] = &open_file_table[STDIN_FILE];
+    pcb->fd_table[1] = &open_file_table[STDOUT_FILE];
+    pcb->fd_map[0] = 0x03;                  // set bits 1 and 0 for stdio
+    get_open_file(&open_file_table[STDIN_FILE]);
+    get_open_file(&open_file_table[STDOUT_FILE]);
+}
+
+/* inherit_fds - sets up the fd table of a child as a copy of the current process' table
+ *      each inherited fd shares its open file and position with the parent's fd, so
+ *      redirection done with dup2 before execute reaches the child
+ *
+ * Inputs: pcb - pcb of the child, its id must already be set
+ * Outputs: None
+ * Side Effects: takes a reference on every open file of the current process
+ */
+void inherit_fds(pcb_t* pcb) {
+    int32_t fd; /* loop index */
+
+    for (fd = 0; fd < MAX_FDS / 32; fd++) {
+        pcb->fd_map[fd] = current_PCB->fd_map[fd];
+    }
+    pcb->fd_limit = current_PCB->fd_limit;
+    pcb->fd_table = (pcb->fd_limit == FD_INLINE) ? pcb->fd_inline : fd_table_pool[pcb->id];
+
+    for (fd = 0; fd < (int32_t)pcb->fd_limit; fd++) {
+        pcb->fd_table[fd] = current_PCB->fd_table[fd];
+        if (CHECK_FLAG(pcb->fd_map[fd / 32], fd % 32)) {
+            get_open_file(pcb->fd_table[fd]);
+        }
+    }
+}
+
+/* get_file_desc - gets the open file of an fd of the current process
+ *
+ * Inputs: fd - file descriptor
+ * Outputs: open file of the fd, NULL if fd is out of range or not open
+ * Side Effects: None
+ */
+file_desc_t* get_file_desc(int32_t fd) {
+    if (fd < 0 || (int32_t)current_PCB->fd_limit <= fd || !CHECK_FLAG(current_PCB->fd_map[fd / 32], fd % 32)) {
+        return NULL;
+    }
+    return current_PCB->fd_table[fd];
+}
+
+/* grow_fds - makes the fd table of the current process hold an fd
+ *      the first FD_INLINE fds live in the pcb, past them the table moves to the
+ *      grown table of the pid, which holds every fd up to MAX_FDS
+ *
+ * Inputs: fd - file descriptor the table must hold
+ * Outputs: 0 for success, -1 if fd is out of range
+ * Side Effects: may move the fd table to the grown table until the process halts
+ */
+int32_t grow_fds(int32_t fd) {
+    file_desc_t** table = fd_table_pool[current_PCB->id]; /* grown table */
+
+    if (fd < 0 || MAX_FDS <= fd) {
+        return -1;
+    }
+    if (fd < (int32_t)current_PCB->fd_limit) {
+        return 0;
+    }
+
+    memcpy(table, current_PCB->fd_inline, sizeof(current_PCB->fd_inline));
+    current_PCB->fd_table = table;
+    current_PCB->fd_limit = MAX_FDS;
+    return 0;
+}
+
+/* get_free_fd - finds the lowest unused fd of the current process
+ *
+ * Inputs: None
+ * Outputs: the fd, -1 if all MAX_FDS are in use
+ * Side Effects: may grow the fd table
+ */
+int32_t get_free_fd(void) {
+    uint32_t free_map;  /* unused fds of the current word */
+    int32_t fd;         /* lowest unused fd */
+    uint32_t i;         /* loop index */
+
+    for (i = 0; i < MAX_FDS / 32; i++) {
+        free_map = ~current_PCB->fd_map[i];
+        if (free_map != 0) {
+            // lowest set bit of the unused map
+            for (fd = 0; !CHECK_FLAG(free_map, fd); fd++);
+            fd += i * 32;
+            return (grow_fds(fd) == 0) ? fd : -1;
+        }
+    }
+    return -1;
+}
+
+/* alloc_open_file - takes a free open file
+ *
+ * Inputs: None
+ * Outputs: open file with one reference for the caller, NULL if the table is full
+ * Side Effects: None
+ */
+file_desc_t* alloc_open_file(void) {
+    file_desc_t* file = NULL;   /* free open file */
+    uint32_t i;                 /* loop index */
+    uint32_t save;              /* variable to store flags */
+
+    cli_and_save(save);
+    for (i = STDOUT_FILE + 1; i < MAX_OPEN_FILES; i++) {
+        if (open_file_table[i].refs == 0) {
+            file = &open_file_table[i];
+            file->refs = 1;
+            break;
+        }
+    }
+    restore_flags(save);
+    return file;
+}
+
+/* get_open_file - takes another reference to an open file
+ *
+ * Inputs: file - open file in use
+ * Outputs: None
+ * Side Effects: None
+ */
+void get_open_file(file_desc_t* file) {
+    uint32_t save; /* variable to store flags */
+
+    cli_and_save(save);
+    file->refs++;
+    restore_flags(save);
+}
+
+/* put_open_file - drops a reference to an open file
+ *
+ * Inputs: file - open file
+ * Outputs: None
+ * Side Effects: the last reference frees the entry, the terminal entries are never freed
+ */
+void put_open_file(file_desc_t* file) {
+    uint32_t save; /* variable to store flags */
+
+    cli_and_save(save);
+    file->refs--;
+    if (file->refs == 0 && file > &open_file_table[STDOUT_FILE]) {
+        // clear the open file for safety (not really needed if we never use it)
+        file->fops_table_ptr = NULL;
+        file->inode_num = 0;
+        file->file_pos = 0;
+        file->flags = 0;
+        file->ra_next = 0;
+        file->ra_blocks = 0;
+        file->map_cache.epoch = 0;
+        file->sb = NULL;
+    }
+    restore_flags(save);
+}
+
+/* set_fd - points an fd of the current process at an open file
+ *
+ * Inputs: fd - unused fd the table already holds
+ *         file - open file, the caller's reference passes to the fd
+ * Outputs: None
+ * Side Effects: marks fd as used
+ */
+void set_fd(int32_t fd, file_desc_t* file) {
+    current_PCB->fd_table[fd] = file;
+    current_PCB->fd_map[fd / 32] |= 1 << (fd % 32);
+}
+
+/* release_fd - closes an fd of the current process
+ *      the file's close runs only when the last fd sharing the open file goes away
+ *
+ * Inputs: fd - file descriptor
+ * Outputs: 0 for success, -1 if fd is not open or the file's close failed
+ * Side Effects: frees fd, may free the open file
+ */
+int32_t release_fd(int32_t fd) {
+    file_desc_t* file = get_file_desc(fd); /* open file of fd */
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    // call the respective file's close syscall while fd still points at the file
+    if (file->refs == 1 && file->fops_table_ptr->close != NULL && file->fops_table_ptr->close(fd) == -1) {
+        return -1;
+    }
+
+    // clear the corresponding bit only after we know the respective close syscall worked
+    current_PCB->fd_map[fd / 32] &= ~(1 << (fd % 32));
+    current_PCB->fd_table[fd] = NULL;
+    put_open_file(file);
+    return 0;
+}
+
+/* release_fds - closes every fd of the current process
+ *
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: frees the fds and the grown fd table, the table is back to FD_INLINE fds
+ */
+void release_fds(void) {
+    int32_t fd;     /* loop index */
+
+    for (fd = 0; fd < (int32_t)current_PCB->fd_limit; fd++) {
+        release_fd(fd); // no error checking because close always returns 0
+    }
+
+    if (current_PCB->fd_table != current_PCB->fd_inline) {
+        current_PCB->fd_table = current_PCB->fd_inline;
+        current_PCB->fd_limit = FD_INLINE;
+    }
+}
@@ -2,12 +2,21 @@
 #define _PROCESS_H
 
 #include "lib.h"
+#include "futex.h"
+#include "signal.h"
+#include "timer.h"
+#include "ioring.h"
+#include "vfs.h"
 #include "./drivers/fsys.h"
 
 #define MAX_PROCESSES 8             // 8 even tho the MP doc wants to support up to 6 simultaneous processes
 #define PROGRAM_START 0x00048000    // address to load user program to
 #define _8KB          8192          // 8kb constant for determining pcb location
-#define MAX_FDS       8             // max number of fds
+#define MAX_FDS       64            // max number of fds of a process
+#define FD_INLINE     8             // fds held in the pcb before its fd table grows
+#define MAX_OPEN_FILES 64           // open files shared by all processes
+#define STDIN_FILE    0             // open file of the terminal input, never freed
+#define STDOUT_FILE   1             // open file of the terminal output, never freed
 
 /* process control block struct, contains parent info for returning and file info for running */
 typedef struct pcb_t {
@@ -15,17 +24,61 @@ typedef struct pcb_t {
     uint32_t parent_pid;            // pid of parent process
     uint32_t parent_esp0;           // ESP0 of the parent process
     uint32_t parent_ebp;            // EBP of the parent process
-    uint8_t open_files;             // one hot encoded for unused (0) and used (1) file descriptors
     uint32_t vidmap_inuse;          // flag to determine if process is using (1) or not using (0) video memory
+    uint32_t mmap_next;             // next free page index in the mmap region
+    vfs_inode_t cwd;                // instance and directory inode of the current directory
     char cmd_args[129];             // arguments into the program
-    file_desc_t file_desc_arr[8];   // file descriptor array
+    uint32_t fd_map[MAX_FDS / 32];  // one hot encoded for unused (0) and used (1) file descriptors
+    uint32_t fd_limit;              // number of fds the fd table holds, FD_INLINE until it grows to MAX_FDS
+    file_desc_t** fd_table;         // open file of each fd, fd_inline or the grown table of the pid
+    file_desc_t* fd_inline[FD_INLINE]; // fd table before it grows
+    futex_waiter_t futex_waiter;    // wait table entry used while blocked in futex
+    signal_state_t signals;         // signal handlers, pending signals and alarm
+    ktimer_t sleep_timer;           // timer the process waits on in usleep
+    ioring_t* ioring;               // registered submission/completion rings, NULL if none
 } pcb_t;
 
 uint32_t activeProcesses;   // one hot encoded for inactive (0) and active (1) processes
 uint32_t currentPID;        // pid of the current process
 pcb_t* current_PCB;         // pcb of the current process
 
+/* open files, an fd points at one and fds made by dup share it along with its position */
+extern file_desc_t open_file_table[MAX_OPEN_FILES];
+
 /* Helper to restore parent process */
 int32_t restore_parent(void);
 
+/* sets up the fd table of a new process with stdin and stdout */
+void init_fds(pcb_t* pcb);
+
+/* sets up the fd table of a child as a copy of the current process' table */
+void inherit_fds(pcb_t* pcb);
+
+/* gets the open file of an fd of the current process */
+file_desc_t* get_file_desc(int32_t fd);
+
+/* makes the fd table of the current process hold an fd */
+int32_t grow_fds(int32_t fd);
+
+/* finds the lowest unused fd of the current process */
+int32_t get_free_fd(void);
+
+/* takes a free open file with one reference */
+file_desc_t* alloc_open_file(void);
+
+/* takes another reference to an open file */
+void get_open_file(file_desc_t* file);
+
+/* drops a reference to an open file */
+void put_open_file(file_desc_t* file);
+
+/* points an unused fd of the current process at an open file */
+void set_fd(int32_t fd, file_desc_t* file);
+
+/* closes an fd of the current process */
+int32_t release_fd(int32_t fd);
+
+/* closes every fd of the current process */
+void release_fds(void);
+
 #endif /* _PROCESS_H */
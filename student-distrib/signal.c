@@ -0,0 +1,152 @@
+#include "lib.h"
+#include "x86_desc.h"
+#include "signal.h"
+#include "process.h"
+#include "page.h"
+#include "syscall.h"
+
+/* flag to determine if exception was raised during program execution */
+extern uint8_t exception_flag;
+
+/* movl $10, %eax; int $0x80; nop - calls sigreturn when a handler returns */
+static uint8_t sig_trampoline[SIG_TRAMPOLINE_SIZE] = {
+    0xB8, 0x0A, 0x00, 0x00, 0x00,       // movl $SYS_SIGRETURN, %eax
+    0xCD, 0x80,                         // int $0x80
+    0x90                                // nop, pads the trampoline to keep the stack aligned
+};
+
+/* init_signal_state - resets the signal state of a new process
+ *
+ * Inputs: state - signal state to reset
+ * Outputs: None
+ * Side Effects: every signal gets its default action, nothing is pending, no alarm is armed
+ */
+void init_signal_state(signal_state_t* state) {
+    uint32_t i; /* loop index */
+
+    for (i = 0; i < NUM_SIGNALS; i++) {
+        state->handlers[i] = NULL;
+    }
+    state->pending = 0;
+    state->masked = 0;
+    timer_setup(&state->alarm_timer, signal_alarm, (uint32_t)state);
+    state->alarm_interval = 0;
+}
+
+/* send_signal - marks a signal as pending
+ *      the signal is delivered the next time the process returns to user space
+ *
+ * Inputs: state - signal state of the receiving process
+ *         signum - signal to send
+ * Outputs: None
+ * Side Effects: sets the pending bit of signum
+ */
+void send_signal(signal_state_t* state, uint32_t signum) {
+    uint32_t save; /* variable to store flags */
+
+    if (signum >= NUM_SIGNALS) {
+        return;
+    }
+
+    cli_and_save(save);
+    state->pending |= 1 << signum;
+    restore_flags(save);
+}
+
+/* signal_catchable - checks if the current process can take a signal in its own handler
+ *
+ * Inputs: signum - signal to check
+ * Outputs: 1 if a handler is installed and signals are not masked, 0 otherwise
+ * Side Effects: None
+ */
+int32_t signal_catchable(uint32_t signum) {
+    signal_state_t* state = &current_PCB->signals; /* current process signal state */
+
+    return signum < NUM_SIGNALS && state->handlers[signum] != NULL && !state->masked;
+}
+
+/* deliver_signals - delivers the lowest pending signal to the current process
+ *      only acts when the context is about to return to user space
+ *      DIV_ZERO, SEGFAULT and INTERRUPT kill the process by default, ALARM and USER1 are ignored
+ *
+ *      user stack built for a handler (top to bottom):
+ *          sigreturn trampoline
+ *          hw_context_t copy of the interrupted context
+ *          signum                      <- argument of the handler
+ *          trampoline address          <- return address of the handler, new user ESP
+ *
+ * Inputs: context - register context on the kernel stack that will be restored by iret
+ * Outputs: None
+ * Side Effects: redirects the iret context into the handler, masks signals, may halt the process
+ */
+void deliver_signals(hw_context_t* context) {
+    signal_state_t* state = &current_PCB->signals; /* current process signal state */
+    uint32_t signum;                                /* signal to deliver */
+    uint32_t user_esp;                              /* user stack pointer while building the frame */
+    uint32_t trampoline_addr;                       /* user address of the copied trampoline */
+
+    // only deliver when going back to user space, and never inside a handler
+    if (context->cs != USER_CS || state->pending == 0 || state->masked) {
+        return;
+    }
+
+    // take the lowest pending signal
+    cli();
+    for (signum = 0; signum < NUM_SIGNALS; signum++) {
+        if (CHECK_FLAG(state->pending, signum)) {
+            break;
+        }
+    }
+    state->pending &= ~(1 << signum);
+    sti();
+
+    // default actions
+    if (state->handlers[signum] == NULL) {
+        if (signum == SIG_DIV_ZERO || signum == SIG_SEGFAULT || signum == SIG_INTERRUPT) {
+            exception_flag = 1; // parent sees 256, same as an unhandled exception
+            halt(0);
+        }
+        return;
+    }
+
+    // make sure the whole frame fits in the user page
+    user_esp = context->esp;
+    if (user_esp > VIRTUAL_USER_BASE_ADDR + _4MB ||
+        user_esp < VIRTUAL_USER_BASE_ADDR + SIG_TRAMPOLINE_SIZE + sizeof(hw_context_t) + 8) {
+        exception_flag = 1;
+        halt(0);
+    }
+
+    // build the handler frame on the user stack
+    user_esp -= SIG_TRAMPOLINE_SIZE;
+    memcpy((void*)user_esp, sig_trampoline, SIG_TRAMPOLINE_SIZE);
+    trampoline_addr = user_esp;
+
+    user_esp -= sizeof(hw_context_t);
+    memcpy((void*)user_esp, context, sizeof(hw_context_t));
+
+    user_esp -= 4;
+    *(uint32_t*)user_esp = signum;
+    user_esp -= 4;
+    *(uint32_t*)user_esp = trampoline_addr;
+
+    // iret into the handler, signals stay masked until sigreturn
+    context->esp = user_esp;
+    context->eip = (uint32_t)state->handlers[signum];
+    state->masked = 1;
+}
+
+/* signal_alarm - alarm timer callback
+ *
+ * Inputs: timer - alarm timer of the process, data holds its signal state
+ * Outputs: None
+ * Side Effects: sends SIG_ALARM, rearms interval alarms
+ */
+void signal_alarm(ktimer_t* timer) {
+    signal_state_t* state = (signal_state_t*)timer->data; /* signal state owning the alarm */
+
+    state->pending |= 1 << SIG_ALARM;
+    if (state->alarm_interval != 0) {
+        timer_add(timer, state->alarm_interval);
+    }
+}
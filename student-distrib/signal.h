@@ -0,0 +1,68 @@
+/* signal.h - user signal delivery and alarms
+ * vim:ts=4 noexpandtab
+ */
+#ifndef _SIGNAL_H
+#define _SIGNAL_H
+
+#include "types.h"
+#include "timer.h"
+
+/* signal numbers, must match enum signums in the user library */
+#define SIG_DIV_ZERO        0
+#define SIG_SEGFAULT        1
+#define SIG_INTERRUPT       2
+#define SIG_ALARM           3
+#define SIG_USER1           4
+#define NUM_SIGNALS         5
+
+/* size of the sigreturn trampoline copied onto the user stack */
+#define SIG_TRAMPOLINE_SIZE 8
+
+/* alarm syscall units, microseconds per tick */
+#define ALARM_TICK_US       10000
+
+/* register context saved by SAVE_REG plus the iret context, in stack order */
+typedef struct hw_context_t {
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+    uint32_t esi;
+    uint32_t edi;
+    uint32_t ebp;
+    uint32_t eax;
+    uint32_t ds;
+    uint32_t es;
+    uint32_t fs;
+    uint32_t gs;
+    uint32_t eip;
+    uint32_t cs;
+    uint32_t eflags;
+    uint32_t esp;                       /* only valid when returning to user space */
+    uint32_t ss;                        /* only valid when returning to user space */
+} hw_context_t;
+
+/* per-process signal state, lives in the PCB */
+typedef struct signal_state_t {
+    void* handlers[NUM_SIGNALS];        /* user handlers, NULL for the default action */
+    uint32_t pending;                   /* one hot encoded pending signals */
+    uint32_t masked;                    /* all signals are masked (1) while a handler runs */
+    ktimer_t alarm_timer;               /* raises SIG_ALARM when it expires, pending while the alarm is armed */
+    uint32_t alarm_interval;            /* microseconds to rearm the alarm with, 0 for one-shot */
+} signal_state_t;
+
+/* resets the signal state of a new process */
+void init_signal_state(signal_state_t* state);
+
+/* marks a signal as pending */
+void send_signal(signal_state_t* state, uint32_t signum);
+
+/* checks if the current process has a handler ready to take signum */
+int32_t signal_catchable(uint32_t signum);
+
+/* delivers a pending signal before returning to user space, called from the x86 wrappers */
+void deliver_signals(hw_context_t* context);
+
+/* alarm timer callback, raises SIG_ALARM */
+void signal_alarm(ktimer_t* timer);
+
+#endif /* _SIGNAL_H */
@@ -6,38 +6,36 @@
 #include "process.h"
 #include "page.h"
 #include "intr.h"
+#include "futex.h"
+#include "signal.h"
+#include "timer.h"
+#include "vfs.h"
 
 #include "./drivers/fsys.h"
 #include "./drivers/rtc.h"
 #include "./drivers/terminal.h"
+#include "./drivers/pit.h"
 
 /* TSS struct */
 extern tss_t tss;
 /* jumptables from their respective drivers */
-extern fops_jumptable_t rtc_jmptable;
 extern fops_jumptable_t file_jmptable;
 extern fops_jumptable_t directory_jmptable;
-extern fops_jumptable_t stdin_jmptable;
-extern fops_jumptable_t stdout_jmptable;
 /* one hot encoded for inactive (0) and active (1) processes */
 extern uint32_t activeProcesses;
 /* flag to determine if exception was raised during program  execution */
 extern uint8_t exception_flag;
 
-/* stdio file descriptors, shared for all processes to copy from */
-static file_desc_t stdout_file_desc = {
-    &stdout_jmptable,
-    0,                      // no inode associated with stdout
-    0,                      // no file position associated with stdout
-    0                       // set to 0, unused
-};
-static file_desc_t stdin_file_desc = {
-    &stdin_jmptable,
-    0,                      // no inode associated with stdin
-    0,                      // no file position associated with stdin
-    0                       // set to 0, unused
-};
 
+/* usleep_expired - sleep timer callback
+ *      nothing to do, timer_run clears the pending flag the sleeper is polling
+ * 
+ * Inputs: timer - sleep timer of the process
+ * Outputs: None
+ * Side Effects: None
+ */
+static void usleep_expired(ktimer_t* timer) {
+}
 
 extern terminal_t* terminal_active;
 
@@ -52,9 +50,16 @@ int32_t halt(uint8_t status) {
     cli();
 
     uint32_t parent_ebp = current_PCB->parent_ebp; /* save parent's execute C function EBP */
+
+    // take the process' timers off the wheel before its PCB gets reused
+    timer_del(&current_PCB->signals.alarm_timer);
+    timer_del(&current_PCB->sleep_timer);
+    // a process killed while blocked in futex must not stay in the wait table
+    futex_cancel(&current_PCB->futex_waiter);
     
     // check attempt to halt base shell
     if (currentPID < MAX_TERMINALS) {
+        release_fds();
         activeProcesses &= ~(1 << currentPID);
         execute((uint8_t*)"shell");
     }
@@ -67,6 +72,8 @@ int32_t halt(uint8_t status) {
     // update current PCB/PID
     terminal_active->currentPCB = current_PCB;
     terminal_active->currentPID = currentPID;
+    // the parent may be using vidmap
+    update_screen_scroll();
 
     // check if program was halted from exception or not
     if (exception_flag) {
@@ -91,14 +98,15 @@ int32_t halt(uint8_t status) {
 int32_t execute(const uint8_t* command) {
     uint32_t i;                     /* loop index */
     uint32_t args_idx;              /* starting index inside command buffer for arguments */
-    char exe_fname[33];             /* executable file name */
+    char exe_fname[MAX_PATH_LEN + 1];   /* executable path */
     char args[128];                 /* arguments from command */
     dentry_t dentry;                /* dentry to fill */
-    uint32_t file_size;             /* executable file size in bytes */
+    vfs_sb_t* sb;                   /* instance holding the executable */
+    vfs_inode_t root;               /* root directory of "/" */
+    stat_t st;                      /* size of the executable */
     pcb_t* process_pcb;             /* PCB of process to be executed */
     uint32_t program_eip;           /* EIP recovered from executable bytes [24, 27] */
     int8_t pid = -1;                /* pid of process to be executed, -1 means not assign/not found */
-    char temp_buf[3];               /* temporary buffer to fill when we check for the ELF magic string */
     char elf_str[4] = "ELF";        /* ELF magic string to check with */
 
     /* critical section to set up PID and processes */
@@ -113,29 +121,33 @@ int32_t execute(const uint8_t* command) {
     while (command[args_idx] != ' ' && command[args_idx] != '\0') {
         args_idx++;
     }
-    // copy the executable file name (up to 32 bytes)
-    if (args_idx >= 32) {
-        strncpy(exe_fname, (int8_t*)command, 32);
-        exe_fname[32] = '\0';
+    // copy the executable path (up to MAX_PATH_LEN bytes)
+    if (args_idx >= MAX_PATH_LEN) {
+        strncpy(exe_fname, (int8_t*)command, MAX_PATH_LEN);
+        exe_fname[MAX_PATH_LEN] = '\0';
     } else {
         strncpy(exe_fname, (int8_t*)command, args_idx);
         exe_fname[args_idx] = '\0';
     }
     // copy the rest of the arguments 
-    strncpy(args, (int8_t*)&command[args_idx], 128 - args_idx);
+    strncpy(args, (int8_t*)&command[args_idx], (args_idx < 128) ? 128 - args_idx : 0);
 
-    // check if filename from argument is valid and fill dentry
-    if (read_dentry_by_name((uint8_t*)exe_fname, &dentry) == -1) {
+    // check if the path from argument is valid and fill dentry, bare names not found
+    // in the current directory are looked up in the root where the programs are
+    for (i = 0; exe_fname[i] != '\0' && exe_fname[i] != '/'; i++);
+    if (vfs_lookup(NULL, (uint8_t*)exe_fname, &sb, &dentry) == -1 &&
+        (exe_fname[i] == '/' || vfs_root(&root) == -1 || vfs_lookup(&root, (uint8_t*)exe_fname, &sb, &dentry) == -1)) {
         sti(); // unmask interrupts before we leave
         return -1;
     }
-
-    // check if file is executable file by checking the ELF magic bytes
-    if (read_data(dentry.inode_idx, 1, (uint8_t*)temp_buf, 3) == -1) { // try reading from disk
+    if (dentry.file_type != REGULAR_FILE_TYPE) {
         sti(); // unmask interrupts before we leave
         return -1;
     }
-    if (strncmp(elf_str, temp_buf, 3)) { // check ELF bytes
+
+    // the image must hold the header and fit in the user page, the header itself is checked once loaded
+    if (sb->ops->stat(sb, REGULAR_FILE_TYPE, dentry.inode_idx, &st) == -1 || st.file_size < ELF_ENTRY_OFFSET + 4 ||
+        VIRTUAL_USER_BASE_ADDR + _4MB - PROGRAM_IMAGE_ADDR < st.file_size) {
         sti(); // unmask interrupts before we leave
         return -1;
     }
@@ -155,20 +167,23 @@ int32_t execute(const uint8_t* command) {
 
     
 
+    // drop file pages mapped by the last process with this pid
+    clear_mmap_pages(pid);
+
     // allocate a 4MB page at physical address 8MB (virtual memory address 128MB)
     set_user_page(pid);
 
     // load user program from disk into allocated page - User-level Program Loader (load from FS to program page)
-    if ((file_size = get_file_length(dentry.file_name)) == -1) {
+    if (sb->ops->read_data(sb, dentry.inode_idx, 0, (uint8_t*)PROGRAM_IMAGE_ADDR, st.file_size) == -1) {
         printf("failed to load executable!\n");
         // reset user page
         set_user_page(currentPID);
         sti(); // unmask interrupts before we leave
         return -1;
     }
-    // copy executable file from disk to virtual memory
-    if (read_data(dentry.inode_idx, 0, (uint8_t*)0x8048000, file_size) == -1) {
-        printf("failed to load executable!\n");
+
+    // check if file is executable file by checking the ELF magic bytes of the loaded image
+    if (strncmp(elf_str, (int8_t*)(PROGRAM_IMAGE_ADDR + ELF_MAGIC_OFFSET), 3)) {
         // reset user page
         set_user_page(currentPID);
         sti(); // unmask interrupts before we leave
@@ -176,22 +191,26 @@ int32_t execute(const uint8_t* command) {
     }
 
     // get the EIP for the executable from bytes [24, 27]
-    if (read_data(dentry.inode_idx, 24, (uint8_t*) &program_eip, 4) == -1) {
-        printf("failed to load executable!\n");
-        // reset user page
-        set_user_page(currentPID);
-        sti(); // unmask interrupts before we leave
-        return -1;
-    }
+    program_eip = *(uint32_t*)(PROGRAM_IMAGE_ADDR + ELF_ENTRY_OFFSET);
 
     // initialize pcb and allocate kernel memory for program stack
     process_pcb = (pcb_t*) (USER_MEM_BASE_ADDR - (pid+1)*_8KB); //8mb - 8kb
     process_pcb->id = pid;
     process_pcb->parent_pid = currentPID;
-    process_pcb->open_files = 0x03;                     // set bits 1 and 0 for stdio
     process_pcb->vidmap_inuse = 0;                      // not using vidmap
-    process_pcb->file_desc_arr[0] = stdin_file_desc;    // fd=0 stdin
-    process_pcb->file_desc_arr[1] = stdout_file_desc;   // fd=1 stdout
+    process_pcb->mmap_next = 0;                         // no file pages mapped
+    process_pcb->ioring = NULL;                         // no rings registered
+    process_pcb->futex_waiter.queued = 0;               // not waiting on a futex
+    // base shells start at the root with fd=0 stdin, fd=1 stdout, children inherit the parent's
+    if (pid < MAX_TERMINALS) {
+        vfs_root(&process_pcb->cwd);
+        init_fds(process_pcb);
+    } else {
+        vfs_cwd(&process_pcb->cwd);
+        inherit_fds(process_pcb);
+    }
+    init_signal_state(&process_pcb->signals);           // default signal actions, no alarm
+    timer_setup(&process_pcb->sleep_timer, usleep_expired, pid);
     if (args[0] == '\0') { // no arguments or argument too long
         process_pcb->cmd_args[0] = '\0'; // indicate no arguments
     } else {
@@ -218,6 +237,8 @@ int32_t execute(const uint8_t* command) {
     // update current PCB/PID
     terminal_active->currentPCB = current_PCB;
     terminal_active->currentPID = currentPID;
+    // the new program does not use vidmap yet
+    update_screen_scroll();
 
     sti();
     /* critical section end */
@@ -244,17 +265,10 @@ int32_t execute(const uint8_t* command) {
  */
 
 int32_t read(int32_t fd, void* buf, int32_t nbytes) {
-    file_desc_t* file_desc_ptr; /* current file desciptor */
-
-    // check if the fd is in range [0, 8), cannot read from stdout (fd=1)
-    if (fd < 0 || fd == 1 || MAX_FDS <= fd) {
-        return -1;
-    }
-
-    file_desc_ptr = &(current_PCB->file_desc_arr[fd]);
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* current file desciptor */
 
-    // check fd bit of open_files for file availability
-    if (!CHECK_FLAG(current_PCB->open_files, fd)) {
+    // check the fd is open, cannot read from stdout
+    if (file_desc_ptr == NULL || file_desc_ptr->fops_table_ptr->read == NULL) {
         return -1; // attempting to read from unopen fd
     }
 
@@ -265,22 +279,342 @@ int32_t read(int32_t fd, void* buf, int32_t nbytes) {
 /* write - does a write syscall on a file or function
  * 
  * Inputs: int32_t fd - integer that indexes into process FD array to find the file to write to, *buf - externally provided buffer to be written from, nbytes - uint32_t* number of bytes to write
- * Outputs: uint32_t - indicates successful write
+ * Outputs: uint32_t - indicates successful write, -1 if a regular file is given a buffer outside user memory
  * Side Effects: Writes info from the buffer into the targted file.
  */
 int32_t write(int32_t fd, const void* buf, int32_t nbytes) {
-    // check if the fd is in range [1, 8), cannot write to stdin (fd=0)
-    if (fd < 1 || MAX_FDS <= fd) {
-        return -1;
-    }
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* current file desciptor */
 
-    // check fd bit of open_files for file availability
-    if (!CHECK_FLAG(current_PCB->open_files, fd)) {
+    // check the fd is open, cannot write to stdin
+    if (file_desc_ptr == NULL || file_desc_ptr->fops_table_ptr->write == NULL) {
         return -1; // attempting to write into unopen fd
     }
 
+    // file data ends up in the image, so it must come from the user page; sendfile hands
+    // image addresses to the file's write directly
+    if (file_desc_ptr->fops_table_ptr == &file_jmptable && (nbytes < 0 || _4MB < nbytes ||
+        (uint32_t)buf < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB - nbytes < (uint32_t)buf)) {
+        return -1;
+    }
+
     // get the file descriptor and write
-    return (current_PCB->file_desc_arr[fd]).fops_table_ptr->write(fd, buf, nbytes);
+    return file_desc_ptr->fops_table_ptr->write(fd, buf, nbytes);
+}
+
+/* check_iovec - checks that an iovec array and all of its segments lie within user memory
+ * 
+ * Inputs: const iovec_t* iov - user iovec array, int32_t iovcnt - number of segments
+ * Outputs: 0 if valid, -1 otherwise
+ * Side Effects: None
+ */
+static int32_t check_iovec(const iovec_t* iov, int32_t iovcnt) {
+    int32_t i; /* segment idx */
+
+    if (iovcnt < 0 || MAX_IOVCNT < iovcnt) {
+        return -1;
+    }
+
+    // the array itself must be in the user page
+    if ((uint32_t)iov < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB - iovcnt*sizeof(iovec_t) < (uint32_t)iov) {
+        return -1;
+    }
+
+    // and so must every segment
+    for (i = 0; i < iovcnt; i++) {
+        if (iov[i].len < 0 || _4MB < iov[i].len ||
+            (uint32_t)iov[i].base < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB - iov[i].len < (uint32_t)iov[i].base) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* readv - reads a file into several buffers with one syscall
+ * 
+ * Inputs: int32_t fd - fd to read from, const iovec_t* iov - segments to fill in order, int32_t iovcnt - number of segments
+ * Outputs: total bytes read, -1 for a bad fd or iovec array
+ * Side Effects: uses the file's readv if it has one, otherwise reads segment by segment
+ *               and stops at the first short read
+ */
+int32_t readv(int32_t fd, const iovec_t* iov, int32_t iovcnt) {
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* file to read */
+    fops_jumptable_t* fops; /* operations of the file */
+    int32_t i;              /* segment idx */
+    int32_t ret;            /* bytes read into the current segment */
+    int32_t total;          /* bytes read over all segments */
+
+    // same fd checks as read
+    if (file_desc_ptr == NULL || file_desc_ptr->fops_table_ptr->read == NULL) {
+        return -1;
+    }
+    if (check_iovec(iov, iovcnt) == -1) {
+        return -1;
+    }
+
+    fops = file_desc_ptr->fops_table_ptr;
+    if (fops->readv != NULL) {
+        return fops->readv(fd, iov, iovcnt);
+    }
+
+    total = 0;
+    for (i = 0; i < iovcnt; i++) {
+        ret = fops->read(fd, iov[i].base, iov[i].len);
+        if (ret < 0) {
+            return (total == 0) ? -1 : total;
+        }
+        total += ret;
+        if (ret < iov[i].len) {
+            break;
+        }
+    }
+    return total;
+}
+
+/* writev - writes several buffers to a file with one syscall
+ * 
+ * Inputs: int32_t fd - fd to write to, const iovec_t* iov - segments to write in order, int32_t iovcnt - number of segments
+ * Outputs: what the file's writev returns, otherwise the sum of the per segment writes, -1 for a bad fd or iovec array
+ * Side Effects: uses the file's writev if it has one, otherwise writes segment by segment
+ */
+int32_t writev(int32_t fd, const iovec_t* iov, int32_t iovcnt) {
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* file to write */
+    fops_jumptable_t* fops; /* operations of the file */
+    int32_t i;              /* segment idx */
+    int32_t ret;            /* result of the current segment */
+    int32_t total;          /* sum over all segments */
+
+    // same fd checks as write
+    if (file_desc_ptr == NULL || file_desc_ptr->fops_table_ptr->write == NULL) {
+        return -1;
+    }
+    if (check_iovec(iov, iovcnt) == -1) {
+        return -1;
+    }
+
+    fops = file_desc_ptr->fops_table_ptr;
+    if (fops->writev != NULL) {
+        return fops->writev(fd, iov, iovcnt);
+    }
+
+    total = 0;
+    for (i = 0; i < iovcnt; i++) {
+        ret = fops->write(fd, iov[i].base, iov[i].len);
+        if (ret < 0) {
+            return (total == 0) ? -1 : total;
+        }
+        total += ret;
+    }
+    return total;
+}
+
+/* lseek - moves the position of an open regular file
+ * 
+ * Inputs: int32_t fd - fd of the file, int32_t offset - bytes to move by, int32_t whence - SEEK_SET, SEEK_CUR or SEEK_END
+ * Outputs: the new file position, -1 if fd is not an open regular file or the position is out of range
+ * Side Effects: the next read or write on fd starts at the new position
+ */
+int32_t lseek(int32_t fd, int32_t offset, int32_t whence) {
+    // only regular files have a byte position
+    if (get_file_desc(fd) == NULL || get_file_desc(fd)->fops_table_ptr != &file_jmptable) {
+        return -1;
+    }
+    return file_lseek(fd, offset, whence);
+}
+
+/* pread - reads an open regular file at an offset without moving its position
+ * 
+ * Inputs: int32_t fd - fd of the file, void* buf - buffer to fill, int32_t nbytes - bytes to read, uint32_t offset - byte to start at
+ * Outputs: number of bytes read, 0 past the end of the file, -1 if fd is not an open regular file or buf is outside user memory
+ * Side Effects: fills buf
+ */
+int32_t pread(int32_t fd, void* buf, int32_t nbytes, uint32_t offset) {
+    // only regular files have a byte position
+    if (get_file_desc(fd) == NULL || get_file_desc(fd)->fops_table_ptr != &file_jmptable) {
+        return -1;
+    }
+
+    // the whole buffer must be in the user page
+    if (nbytes < 0 || _4MB < nbytes ||
+        (uint32_t)buf < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB - nbytes < (uint32_t)buf) {
+        return -1;
+    }
+    return file_pread(fd, buf, nbytes, offset);
+}
+
+/* getdents - reads as many dentries of an open directory as fit in a buffer
+ * 
+ * Inputs: int32_t fd - fd of the directory, void* buf - buffer for dirent_t records, int32_t nbytes - size of buf
+ * Outputs: bytes filled, 0 at the end of the directory, -1 for a bad fd or buffer
+ * Side Effects: fills buf, moves the directory position the same way read does
+ */
+int32_t getdents(int32_t fd, void* buf, int32_t nbytes) {
+    if (get_file_desc(fd) == NULL || get_file_desc(fd)->fops_table_ptr != &directory_jmptable) {
+        return -1;
+    }
+
+    // the whole buffer must be in the user page
+    if (nbytes < 0 || (uint32_t)buf < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB - nbytes < (uint32_t)buf) {
+        return -1;
+    }
+    return directory_getdents(fd, buf, nbytes);
+}
+
+/* stat - describes the file at a path
+ * 
+ * Inputs: const uint8_t* path - path of the file, stat_t* buf - user buffer to fill
+ * Outputs: 0 for success, -1 if the path is not found, buf is outside user memory or the inode is bad
+ * Side Effects: fills buf with the type, inode, size and block count
+ */
+int32_t stat(const uint8_t* path, stat_t* buf) {
+    dentry_t dentry;    /* dentry the path resolves to */
+    vfs_sb_t* sb;       /* instance holding the path */
+
+    // validate buf is within user memory
+    if ((uint32_t)buf < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB - sizeof(stat_t) < (uint32_t)buf) {
+        return -1;
+    }
+    if (vfs_lookup(NULL, path, &sb, &dentry) == -1) {
+        return -1;
+    }
+    return sb->ops->stat(sb, dentry.file_type, dentry.inode_idx, buf);
+}
+
+/* fstat - describes the file an fd was opened on
+ * 
+ * Inputs: int32_t fd - open fd other than stdin/stdout, stat_t* buf - user buffer to fill
+ * Outputs: 0 for success, -1 for a bad fd, buf outside user memory or a bad inode
+ * Side Effects: fills buf with the type, inode, size and block count
+ */
+int32_t fstat(int32_t fd, stat_t* buf) {
+    file_desc_t* file_desc_ptr;     /* file descriptor to describe */
+    uint32_t file_type;             /* type the fd was opened as */
+
+    // stdin and stdout have no instance to describe them
+    file_desc_ptr = get_file_desc(fd);
+    if (file_desc_ptr == NULL || file_desc_ptr->sb == NULL) {
+        return -1;
+    }
+    if ((uint32_t)buf < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB - sizeof(stat_t) < (uint32_t)buf) {
+        return -1;
+    }
+
+    // the jumptable open picked tells the type back
+    for (file_type = 0; file_type < VFS_NUM_FILE_TYPES; file_type++) {
+        if (file_desc_ptr->sb->ops->fops[file_type] == file_desc_ptr->fops_table_ptr) {
+            break;
+        }
+    }
+    return file_desc_ptr->sb->ops->stat(file_desc_ptr->sb, file_type, file_desc_ptr->inode_num, buf);
+}
+
+/* ring_setup - registers the submission/completion rings of the current process
+ * 
+ * Inputs: ioring_t* ring - page aligned ioring_t in user memory, NULL to unregister
+ * Outputs: 0 for success, -1 if ring is not a page of user memory
+ * Side Effects: empties both rings
+ */
+int32_t ring_setup(ioring_t* ring) {
+    if (ring == NULL) {
+        current_PCB->ioring = NULL;
+        return 0;
+    }
+
+    // the rings have to be one whole page of the user page
+    if ((uint32_t)ring < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB - IORING_SIZE < (uint32_t)ring ||
+        ((uint32_t)ring & (IORING_SIZE - 1))) {
+        return -1;
+    }
+
+    ring->sq_head = 0;
+    ring->sq_tail = 0;
+    ring->cq_head = 0;
+    ring->cq_tail = 0;
+    current_PCB->ioring = ring;
+    return 0;
+}
+
+/* ring_enter - runs queued submissions of the registered rings
+ * 
+ * Inputs: uint32_t to_submit - most submissions to run
+ * Outputs: number of submissions run, -1 if no rings are registered or they are inconsistent
+ * Side Effects: runs read/write/open/close for each submission and posts its completion
+ */
+int32_t ring_enter(uint32_t to_submit) {
+    if (current_PCB->ioring == NULL) {
+        return -1;
+    }
+    return ioring_submit(current_PCB->ioring, to_submit);
+}
+
+/* sendfile - copies a regular file to another fd without going through user memory
+ *      blocks are written straight from the disk image, the way mmap maps them, file_write
+ *      syncs the buffer cache so the image is never behind; compressed files are decoded
+ *      a chunk at a time into a kernel stack buffer
+ * 
+ * Inputs: int32_t out_fd - writable fd, int32_t in_fd - open regular file, int32_t count - most bytes to copy
+ * Outputs: bytes copied, 0 at the end of in_fd, -1 for bad fds or if nothing could be copied
+ * Side Effects: advances the file position of in_fd, writes to out_fd
+ */
+int32_t sendfile(int32_t out_fd, int32_t in_fd, int32_t count) {
+    file_desc_t* in_desc;               /* file being copied */
+    file_desc_t* out_desc;              /* file being written */
+    fops_jumptable_t* out_fops;         /* operations of the destination */
+    stat_t st;                          /* size of the file being copied */
+    uint8_t chunk[SENDFILE_CHUNK];      /* decoded data of a compressed file */
+    uint8_t* src;                       /* bytes handed to the destination */
+    uint32_t block_addr;                /* image address of the current block */
+    uint32_t pos;                       /* file position of the current piece */
+    uint32_t len;                       /* bytes in the current piece */
+    int32_t sent;                       /* bytes copied so far */
+
+    in_desc = get_file_desc(in_fd);
+    out_desc = get_file_desc(out_fd);
+    if (in_desc == NULL || in_desc->fops_table_ptr != &file_jmptable) {
+        return -1;
+    }
+    if (out_desc == NULL || out_desc->fops_table_ptr->write == NULL || count < 0) {
+        return -1;
+    }
+    out_fops = out_desc->fops_table_ptr;
+
+    // a file copied onto itself would read blocks it is overwriting
+    if (out_fops == &file_jmptable && out_desc->sb == in_desc->sb && out_desc->inode_num == in_desc->inode_num) {
+        return -1;
+    }
+    if (in_desc->sb->ops->stat(in_desc->sb, REGULAR_FILE_TYPE, in_desc->inode_num, &st) == -1) {
+        return -1;
+    }
+
+    for (sent = 0; sent < count && in_desc->file_pos < st.file_size; sent += len) {
+        // at most the rest of the current block
+        pos = in_desc->file_pos;
+        len = DISK_BLOCK_SIZE - pos % DISK_BLOCK_SIZE;
+        if (len > (uint32_t)(count - sent)) {
+            len = count - sent;
+        }
+        if (len > st.file_size - pos) {
+            len = st.file_size - pos;
+        }
+
+        if (in_desc->sb->ops->block_addr(in_desc->sb, in_desc->inode_num, pos / DISK_BLOCK_SIZE, &block_addr) == 0) {
+            src = (uint8_t*)block_addr + pos % DISK_BLOCK_SIZE;
+        } else {
+            if (len > SENDFILE_CHUNK) {
+                len = SENDFILE_CHUNK;
+            }
+            if ((uint32_t)file_pread(in_fd, chunk, len, pos) != len) {
+                return (sent == 0) ? -1 : sent;
+            }
+            src = chunk;
+        }
+
+        // the terminal returns 0 rather than a byte count, only failure matters
+        if (out_fops->write(out_fd, src, len) < 0) {
+            return (sent == 0) ? -1 : sent;
+        }
+        in_desc->file_pos = pos + len;
+    }
+    return sent;
 }
 
 /* open - adds a file descriptor to fd to have operations done on
@@ -290,94 +624,129 @@ int32_t write(int32_t fd, const void* buf, int32_t nbytes) {
  * Side Effects: alters the current pcb fd array and open files to include the newly open file
  */
 int32_t open(const uint8_t* filename) {
-    uint32_t fd;                                            /* index to fill within file descriptors array */
+    int32_t fd;                                             /* index to fill within file descriptors array */
     dentry_t dentry;                                        /* dentry to fill when retrieving file data */
+    vfs_sb_t* sb;                                           /* instance holding the file */
     file_desc_t* file_desc_ptr;                             /* current file desciptor */
     
-    // calculate an available fd index by bit shifting
-    for (fd = 2; fd < MAX_FDS; fd++) {
-        if (!CHECK_FLAG(current_PCB->open_files, fd)) { // check bit fd of open_files 
-            break; // bit fd of open_files is 0 (fd is available)
-        }
-    }
+    // lowest available fd, the fd table grows past FD_INLINE fds
+    fd = get_free_fd();
 
     // check if there are any available file descriptors
-    if (fd == MAX_FDS) { // no available file descriptors
+    if (fd == -1) { // no available file descriptors
         return -1;
     }
 
-    // try to find the given filename
-    if (read_dentry_by_name((uint8_t*)filename, &dentry) == -1) {
+    // try to find the given path
+    if (vfs_lookup(NULL, filename, &sb, &dentry) == -1) {
         return -1;
     }
 
-    // set our current file descriptor to fill
-    file_desc_ptr = &(current_PCB->file_desc_arr[fd]);
+    // the file system of the path gives the jump table of the file type
+    if (dentry.file_type >= VFS_NUM_FILE_TYPES || sb->ops->fops[dentry.file_type] == NULL) {
+        return -1;
+    }
 
-    // conditionally determine jump table from file type
-    switch (dentry.file_type) {
-        case RTC_FILE_TYPE:
-            file_desc_ptr->fops_table_ptr = &rtc_jmptable;
-            break;
-        case DIRECTORY_FILE_TYPE:
-            file_desc_ptr->fops_table_ptr = &directory_jmptable;
-            break;
-        case REGULAR_FILE_TYPE:
-            file_desc_ptr->fops_table_ptr = &file_jmptable;
-            break;
+    // take an open file to fill, shared by every process
+    file_desc_ptr = alloc_open_file();
+    if (file_desc_ptr == NULL) {
+        return -1;
     }
+    file_desc_ptr->fops_table_ptr = sb->ops->fops[dentry.file_type];
+
     // initialize file descriptor
+    file_desc_ptr->sb = sb;
     file_desc_ptr->inode_num = dentry.inode_idx;
     file_desc_ptr->file_pos = 0;      // reset file position to 0
     file_desc_ptr->flags = 0;         // set to 0, unused
+    file_desc_ptr->ra_next = 0;       // a read from the start counts as sequential
+    file_desc_ptr->ra_blocks = 0;
+    file_desc_ptr->map_cache.epoch = 0;
     
     // call the respective file's open syscall
     if (file_desc_ptr->fops_table_ptr->open(filename) == -1) {
+        put_open_file(file_desc_ptr);
         return -1;
     }
 
-    // set the corresponding bit in open_files only after we know the respective open syscall worked
-    current_PCB->open_files |= 1 << fd;
+    // point fd at the file only after we know the respective open syscall worked
+    set_fd(fd, file_desc_ptr);
 
     // return the filled fd
     return fd;
 }
 
 /* close - removes a file from the fd array and calls the close function assigned to the file
+ *      the file's close only runs once no other fd made by dup shares the open file
  * 
  * Inputs: int32_t fd - an index into the currentPCB fd array for file removal
  * Outputs: uint32_t - indicates successful close or unsccuessful close
  * Side Effects: alters the current_pcb fd array to delete the specified file descriptor off the list
  */
 int32_t close(int32_t fd) {
-    file_desc_t* file_desc_ptr = &(current_PCB->file_desc_arr[fd]); /* current file desciptor */
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* current file desciptor */
 
-    // check if the fd is in range [2, 8), cannot close stdin, stdout
-    if (fd < 2 || MAX_FDS <= fd) {
-        return -1;
+    // check the fd is open
+    if (file_desc_ptr == NULL) {
+        return -1; // attempting to close into unopen fd
     }
 
-    // check fd bit of open_files for file availability
-    if (!CHECK_FLAG(current_PCB->open_files, fd)) {
-        return -1; // attempting to close into unopen fd
+    // cannot close stdin, stdout; a copy of them made by dup can be closed
+    if (fd < 2 && file_desc_ptr->fops_table_ptr->close == NULL) {
+        return -1;
     }
 
-    // call the respective file's close syscall
-    if (file_desc_ptr->fops_table_ptr->close(fd) == -1) {
+    return release_fd(fd);
+}
+
+/* dup - makes another fd for an open file
+ * 
+ * Inputs: int32_t fd - open fd to copy
+ * Outputs: the lowest unused fd, now sharing the open file and its position with fd; -1 if fd
+ *          is not open or no fd is free
+ * Side Effects: may grow the fd table
+ */
+int32_t dup(int32_t fd) {
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* file to share */
+    int32_t new_fd;                                 /* fd to fill */
+
+    if (file_desc_ptr == NULL) {
         return -1;
     }
+    new_fd = get_free_fd();
+    if (new_fd == -1) {
+        return -1;
+    }
+
+    get_open_file(file_desc_ptr);
+    set_fd(new_fd, file_desc_ptr);
+    return new_fd;
+}
 
-    // clear respective file descriptor for safety (not really needed if we never use it)
-    file_desc_ptr->fops_table_ptr = NULL;
-    file_desc_ptr->inode_num = 0;
-    file_desc_ptr->file_pos = 0;
-    file_desc_ptr->flags = 0;
+/* dup2 - makes a given fd share the open file of another
+ *      used to redirect stdin or stdout to a file
+ * 
+ * Inputs: int32_t fd - open fd to copy, int32_t new_fd - fd to point at its file, below MAX_FDS
+ * Outputs: new_fd, -1 if fd is not open, new_fd is out of range or whatever new_fd had open
+ *          failed to close
+ * Side Effects: closes new_fd first if it was open, may grow the fd table
+ */
+int32_t dup2(int32_t fd, int32_t new_fd) {
+    file_desc_t* file_desc_ptr = get_file_desc(fd); /* file to share */
 
-    // clear the corresponding bit in open_files only after we know the respective close syscall worked
-    current_PCB->open_files &= ~(1 << fd);
+    if (file_desc_ptr == NULL || grow_fds(new_fd) == -1) {
+        return -1;
+    }
+    if (new_fd == fd) {
+        return new_fd;
+    }
+    if (get_file_desc(new_fd) != NULL && release_fd(new_fd) == -1) {
+        return -1;
+    }
 
-    // success
-    return 0;
+    get_open_file(file_desc_ptr);
+    set_fd(new_fd, file_desc_ptr);
+    return new_fd;
 }
 
 /* getargs - gets the arguments of a program
@@ -416,6 +785,9 @@ int32_t vidmap(uint8_t** screen_start) {
     // set using vidmap flag
     current_PCB->vidmap_inuse = 1;
 
+    // keep the shown screen where the page points
+    update_screen_scroll();
+
     // return virtual address for vidmap to user
     *screen_start = (uint8_t*)VIRTUAL_VMEM_BASE_ADDR;
 
@@ -423,23 +795,265 @@ int32_t vidmap(uint8_t** screen_start) {
     return 0;
 }
 
-/* set_handler
+/* set_handler - installs a user handler for a signal
  * 
- * Inputs: signum - unused
- *         handler_address - unused
- * Outputs: -1
- * Side Effects: does nothing
+ * Inputs: signum - signal to handle
+ *         handler_address - user function taking the signal number, NULL restores the default action
+ * Outputs: 0 for success, -1 for an invalid signal or handler address
+ * Side Effects: changes the handler the next delivery of signum uses
  */
 int32_t set_handler(int32_t signum, void* handler_address) {
-    return -1;
+    // validate signal number
+    if (signum < 0 || NUM_SIGNALS <= signum) {
+        return -1;
+    }
+
+    // validate handler_address is within user memory
+    if (handler_address != NULL &&
+        ((uint32_t)handler_address < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB <= (uint32_t)handler_address)) {
+        return -1;
+    }
+
+    current_PCB->signals.handlers[signum] = handler_address;
+    return 0;
 }
 
-/* sigreturn
+/* sigreturn - returns from a signal handler into the interrupted context
+ *      called by the trampoline deliver_signals left on the user stack, at which point
+ *      the user ESP points at the signum argument right below the saved hw_context_t
  * 
  * Inputs: None
- * Outputs: -1
- * Side Effects: does nothing
+ * Outputs: EAX of the interrupted context, so the syscall return does not clobber it
+ * Side Effects: overwrites this syscall's kernel stack context with the saved user context, unmasks signals
  */
 int32_t sigreturn() {
-    return -1;
+    hw_context_t* context = (hw_context_t*)(tss.esp0 - sizeof(hw_context_t)); /* syscall context on the kernel stack */
+    hw_context_t* saved;                                                        /* context saved on the user stack */
+
+    // only valid inside a signal handler
+    if (!current_PCB->signals.masked) {
+        return -1;
+    }
+
+    // validate the saved context is within user memory
+    saved = (hw_context_t*)(context->esp + 4);
+    if ((uint32_t)saved < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB - sizeof(hw_context_t) < (uint32_t)saved) {
+        return -1;
+    }
+
+    // restore general purpose registers, EIP and ESP
+    context->ebx = saved->ebx;
+    context->ecx = saved->ecx;
+    context->edx = saved->edx;
+    context->esi = saved->esi;
+    context->edi = saved->edi;
+    context->ebp = saved->ebp;
+    context->eax = saved->eax;
+    context->eip = saved->eip;
+    context->esp = saved->esp;
+    // the user may have edited the saved copy, only take the arithmetic flags and keep IF set
+    context->eflags = (saved->eflags & 0x00000CD5) | 0x00000202;
+
+    current_PCB->signals.masked = 0;
+    return context->eax;
+}
+
+/* alarm - raises SIG_ALARM after a number of ticks (10 ms each)
+ * 
+ * Inputs: ticks - ticks until the alarm, 0 disarms the alarm
+ *         interval - ticks to rearm with after each alarm, 0 for a one-shot alarm
+ * Outputs: ticks that were left on the previous alarm rounded up, -1 if a delay is too long
+ * Side Effects: replaces the current process' alarm
+ */
+int32_t alarm(uint32_t ticks, uint32_t interval) {
+    signal_state_t* state = &current_PCB->signals;  /* current process signal state */
+    uint32_t remaining = 0;                         /* ticks left on the previous alarm */
+    uint32_t now;                                   /* current time */
+
+    if (ticks > TIMER_MAX_DELAY / ALARM_TICK_US || interval > TIMER_MAX_DELAY / ALARM_TICK_US) {
+        return -1;
+    }
+
+    cli();
+    now = pit_time();
+    if (state->alarm_timer.pending && TIME_BEFORE(now, state->alarm_timer.expires)) {
+        remaining = (state->alarm_timer.expires - now + ALARM_TICK_US - 1) / ALARM_TICK_US;
+    }
+
+    timer_del(&state->alarm_timer);
+    state->alarm_interval = (ticks != 0) ? interval * ALARM_TICK_US : 0;
+    if (ticks != 0) {
+        timer_add(&state->alarm_timer, ticks * ALARM_TICK_US);
+    }
+    sti();
+
+    return remaining;
+}
+
+/* usleep - suspends the current process for a number of microseconds
+ *      the wait is driven by a one-shot PIT interrupt at the deadline, so the
+ *      resolution is limited by the PIT and the scheduler, not by a tick rate
+ * 
+ * Inputs: usec - microseconds to sleep, at most TIMER_MAX_DELAY
+ * Outputs: 0 when the time passed, -1 if the delay is too long or a signal interrupted the sleep
+ * Side Effects: yields the processor until the sleep timer expires
+ */
+int32_t usleep(uint32_t usec) {
+    ktimer_t* timer = &current_PCB->sleep_timer; /* current process sleep timer */
+
+    if (usec == 0) {
+        return 0;
+    }
+    if (timer_add(timer, usec) == -1) {
+        return -1;
+    }
+
+    // give the slice to other terminals until the timer expires
+    while (timer->pending) {
+        // let a pending signal run its handler or default action
+        if (current_PCB->signals.pending != 0 && !current_PCB->signals.masked) {
+            timer_del(timer);
+            return -1;
+        }
+        schedule_yield();
+    }
+
+    return 0;
+}
+
+/* mmap - maps a regular file's data blocks read-only into the process
+ *      the file system image is memory resident, so each 4KB page of the mapping is the
+ *      data block itself; scattered blocks end up contiguous in virtual memory in file order
+ * 
+ * Inputs: fd - file descriptor of an open regular file
+ *         offset - byte offset in the file to map from, 4KB aligned
+ *         length - number of bytes to map, clamped to the end of the file
+ * Outputs: user virtual address of the mapping, -1 for failure
+ * Side Effects: maps pages in the process' mmap region until the process halts
+ */
+int32_t mmap(int32_t fd, uint32_t offset, uint32_t length) {
+    file_desc_t* file_desc_ptr;     /* file descriptor to map */
+    uint32_t num_pages;             /* pages to map */
+    uint32_t block_addr;            /* address of the current data block */
+    uint32_t i;                     /* loop index */
+
+    // only open regular files can be mapped
+    file_desc_ptr = get_file_desc(fd);
+    if (file_desc_ptr == NULL || file_desc_ptr->fops_table_ptr != &file_jmptable) {
+        return -1;
+    }
+
+    // offset must start a data block
+    if (length == 0 || offset % _4KB != 0) {
+        return -1;
+    }
+
+    // make sure every page is backed by a data block of the file
+    num_pages = (length + _4KB - 1) / _4KB;
+    if (num_pages > PAGE_TABLE_NUM - current_PCB->mmap_next) {
+        return -1;
+    }
+    for (i = 0; i < num_pages; i++) {
+        if (file_desc_ptr->sb->ops->block_addr(file_desc_ptr->sb, file_desc_ptr->inode_num, offset / _4KB + i, &block_addr) == -1) {
+            // the end of the file, or a bad inode if nothing could be mapped
+            if (i == 0) {
+                return -1;
+            }
+            num_pages = i;
+            break;
+        }
+    }
+
+    // map the blocks in file order
+    for (i = 0; i < num_pages; i++) {
+        file_desc_ptr->sb->ops->block_addr(file_desc_ptr->sb, file_desc_ptr->inode_num, offset / _4KB + i, &block_addr);
+        set_mmap_page(currentPID, current_PCB->mmap_next + i, block_addr);
+    }
+
+    current_PCB->mmap_next += num_pages;
+    return VIRTUAL_MMAP_BASE_ADDR + (current_PCB->mmap_next - num_pages) * _4KB;
+}
+
+/* create - creates an empty regular file
+ * 
+ * Inputs: filename - path of the file, its name is 1 to 32 characters
+ * Outputs: 0 for success, -1 for failure
+ * Side Effects: adds the file to the file system
+ */
+int32_t create(const uint8_t* filename) {
+    return vfs_create(filename);
+}
+
+/* unlink - removes a regular file or an empty directory
+ * 
+ * Inputs: filename - path of the file
+ * Outputs: 0 for success, -1 for failure
+ * Side Effects: removes the file from the file system and frees its blocks
+ */
+int32_t unlink(const uint8_t* filename) {
+    return vfs_unlink(filename);
+}
+
+/* chdir - changes the current directory of the process
+ *      children started by execute inherit it
+ * 
+ * Inputs: path - path of the directory
+ * Outputs: 0 for success, -1 if the path is not a directory
+ * Side Effects: relative paths of the process now start at the new directory
+ */
+int32_t chdir(const uint8_t* path) {
+    dentry_t dentry;    /* dentry of the directory */
+    vfs_sb_t* sb;       /* instance holding the directory */
+
+    if (vfs_lookup(NULL, path, &sb, &dentry) == -1 || dentry.file_type != DIRECTORY_FILE_TYPE) {
+        return -1;
+    }
+
+    current_PCB->cwd.sb = sb;
+    current_PCB->cwd.inode = dentry.inode_idx;
+    return 0;
+}
+
+/* mkdir - creates an empty directory
+ * 
+ * Inputs: path - path of the directory, its name is 1 to 32 characters
+ * Outputs: 0 for success, -1 for failure
+ * Side Effects: adds the directory to the file system
+ */
+int32_t mkdir(const uint8_t* path) {
+    return vfs_mkdir(path);
+}
+
+/* futex - waits on or wakes up a user-space lock word
+ *      the wait table is keyed by the physical address of the word, so the key
+ *      stays the same no matter which process or mapping names the word
+ * 
+ * Inputs: uaddr - 4 byte aligned user pointer to the futex word
+ *         op - FUTEX_WAIT or FUTEX_WAKE
+ *         val - FUTEX_WAIT: value *uaddr must still hold to block
+ *               FUTEX_WAKE: maximum number of waiters to wake up
+ * Outputs: FUTEX_WAIT: 0 when woken up, -1 if *uaddr != val or a signal interrupted the wait
+ *          FUTEX_WAKE: number of waiters woken up
+ *          -1 for an invalid pointer or operation
+ * Side Effects: FUTEX_WAIT blocks the calling process
+ */
+int32_t futex(uint32_t* uaddr, int32_t op, uint32_t val) {
+    uint32_t key; /* physical address of the futex word */
+
+    // validate uaddr is an aligned word within user memory
+    if ((uint32_t)uaddr < VIRTUAL_USER_BASE_ADDR || VIRTUAL_USER_BASE_ADDR + _4MB - 4 < (uint32_t)uaddr || ((uint32_t)uaddr & 0x3)) {
+        return -1;
+    }
+
+    // the user page of pid is backed by the physical 4MB page at 8MB + pid*4MB
+    key = USER_MEM_BASE_ADDR + currentPID*_4MB + ((uint32_t)uaddr - VIRTUAL_USER_BASE_ADDR);
+
+    switch (op) {
+        case FUTEX_WAIT:
+            return futex_wait(key, uaddr, val, &current_PCB->futex_waiter);
+        case FUTEX_WAKE:
+            return futex_wake(key, val);
+        default:
+            return -1;
+    }
 }
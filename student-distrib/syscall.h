@@ -2,6 +2,15 @@
 #define _SYSCALL_H
 
 #include "lib.h"
+#include "drivers/fsys.h"
+#include "ioring.h"
+
+/* executable header fields execute reads from the loaded image */
+#define ELF_MAGIC_OFFSET    1   /* "ELF" after the 0x7F byte */
+#define ELF_ENTRY_OFFSET    24  /* 32-bit entry point */
+
+/* bytes of a compressed file sendfile decodes at a time, kept small since it lives on the kernel stack */
+#define SENDFILE_CHUNK      512
 
 /* x86 functions from syscall_asm.S */
 /* Assembly for the execute, iret context switching occurs, allocation of pcb and pid*/
@@ -11,7 +20,7 @@ extern void execute_asm(uint32_t ss, uint32_t esp, uint32_t eflags, uint32_t cs,
 extern void halt_asm(uint32_t parent_ebp, uint32_t ret_val);
 
 
-/* System calls starting from 1 to 10 */
+/* System calls starting from 1 to 30 */
 int32_t halt(uint8_t status);
 int32_t execute(const uint8_t* command);
 int32_t read(int32_t fd, void* buf, int32_t nbytes);
@@ -22,5 +31,25 @@ int32_t getargs(uint8_t* buf, int32_t nbytes);
 int32_t vidmap(uint8_t** screen_start);
 int32_t set_handler(int32_t signum, void* handler_address);
 int32_t sigreturn(void);
+int32_t futex(uint32_t* uaddr, int32_t op, uint32_t val);
+int32_t alarm(uint32_t ticks, uint32_t interval);
+int32_t usleep(uint32_t usec);
+int32_t mmap(int32_t fd, uint32_t offset, uint32_t length);
+int32_t create(const uint8_t* filename);
+int32_t unlink(const uint8_t* filename);
+int32_t chdir(const uint8_t* path);
+int32_t mkdir(const uint8_t* path);
+int32_t readv(int32_t fd, const iovec_t* iov, int32_t iovcnt);
+int32_t writev(int32_t fd, const iovec_t* iov, int32_t iovcnt);
+int32_t lseek(int32_t fd, int32_t offset, int32_t whence);
+int32_t pread(int32_t fd, void* buf, int32_t nbytes, uint32_t offset);
+int32_t getdents(int32_t fd, void* buf, int32_t nbytes);
+int32_t stat(const uint8_t* path, stat_t* buf);
+int32_t fstat(int32_t fd, stat_t* buf);
+int32_t ring_setup(ioring_t* ring);
+int32_t ring_enter(uint32_t to_submit);
+int32_t sendfile(int32_t out_fd, int32_t in_fd, int32_t count);
+int32_t dup(int32_t fd);
+int32_t dup2(int32_t fd, int32_t new_fd);
 
 #endif /* _SYSCALL_H */
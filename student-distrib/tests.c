@@ -3,8 +3,11 @@
 
 #include "tests.h"
 #include "page.h"
+#include "process.h"
+#include "syscall.h"
 
 #include "./drivers/fsys.h"
+#include "./drivers/lz4.h"
 #include "./drivers/rtc.h"
 #include "./drivers/terminal.h"
 
@@ -26,6 +29,64 @@ static inline void assertion_failure() {
 	asm volatile("int $15");
 }
 
+/* pid the tests run syscalls as, free since the tests run before the PIT starts the shells */
+#define TEST_PID	(MAX_PROCESSES - 1)
+/* scratch buffers in the test process's user page, syscalls reject buffers outside of it */
+#define TEST_BUF	((uint8_t*)VIRTUAL_USER_BASE_ADDR)
+
+static uint32_t test_saved_pid;		/* pid that was current before the test process */
+static pcb_t* test_saved_pcb;		/* pcb that was current before the test process */
+
+/* test_process_start
+ * 		makes a process at TEST_PID current so tests can call syscalls like a program would,
+ * 		it has stdin, stdout, the root as its directory and its user page mapped
+ * 
+ * Inputs: None
+ * Outputs: 0 for success, -1 if TEST_PID is in use
+ * Side Effects: changes the current process and the user page
+ */
+static int32_t test_process_start() {
+	pcb_t* pcb = (pcb_t*)(USER_MEM_BASE_ADDR - (TEST_PID + 1) * _8KB);
+
+	if (CHECK_FLAG(activeProcesses, TEST_PID)) {
+		return -1;
+	}
+
+	pcb->id = TEST_PID;
+	pcb->parent_pid = currentPID;
+	pcb->vidmap_inuse = 0;
+	pcb->mmap_next = 0;
+	pcb->ioring = NULL;
+	pcb->futex_waiter.queued = 0;
+	vfs_root(&pcb->cwd);
+	init_fds(pcb);
+	init_signal_state(&pcb->signals);
+
+	test_saved_pid = currentPID;
+	test_saved_pcb = current_PCB;
+	activeProcesses |= 1 << TEST_PID;
+	currentPID = TEST_PID;
+	current_PCB = pcb;
+	set_user_page(TEST_PID);
+	return 0;
+}
+
+/* test_process_end
+ * 		closes the test process's fds and makes the previous process current again
+ * 
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: changes the current process and the user page
+ */
+static void test_process_end() {
+	release_fds();
+	clear_mmap_pages(TEST_PID);
+	activeProcesses &= ~(1 << TEST_PID);
+	currentPID = test_saved_pid;
+	current_PCB = test_saved_pcb;
+	set_user_page(currentPID);
+}
+
 /* Checkpoint 1 tests */
 
 /* IDT Test - Example
@@ -704,24 +765,100 @@ int file_read_test() {
 	return PASS;
 }
 
-/* file_write_test
- * 		tests file write test syscall
+/* file_write_checks
+ * 		checks writes to an open empty file: bad and empty writes, appends, overwrites
+ * 		and a gap past the end of the file that reads back as 0s
  * 
- * Inputs: None
+ * Inputs: fd - fd of the empty file, open in the test process
  * Outputs: PASS/FAIL
- * Side Effects: None
- * Coverage: file_write
- * Files: fsys.c
+ * Side Effects: writes the file, uses TEST_BUF
  */
-int file_write_test() {
-	// try writing anything
-	if (file_write(0, NULL, 0) != -1) {
+static int file_write_checks(int32_t fd) {
+	uint8_t* data = TEST_BUF;				/* bytes written */
+	uint8_t* back = TEST_BUF + _4KB;		/* bytes read back */
+	stat_t* st = (stat_t*)(TEST_BUF + _8KB);	/* size of the file */
+	uint32_t i;
+
+	// a missing or kernel buffer fails, an empty write does nothing
+	if (write(fd, NULL, 4) != -1 || write(fd, data, -1) != -1 || write(fd, data, 0) != 0) {
+		return FAIL;
+	}
+	if (write(fd, (uint8_t*)_4MB, 4) != -1 || write(fd, TEST_BUF + _4MB - 2, 4) != -1 ||
+		fstat(fd, st) != 0 || st->file_size != 0) {
 		return FAIL;
 	}
 
+	// append 100 'a's, then overwrite 10 of them in the middle
+	memset(data, 'a', 100);
+	if (write(fd, data, 100) != 100) {
+		return FAIL;
+	}
+	memset(data, 'b', 10);
+	if (lseek(fd, 50, SEEK_SET) != 50 || write(fd, data, 10) != 10 || lseek(fd, 0, SEEK_CUR) != 60) {
+		return FAIL;
+	}
+
+	// a write past the end leaves a gap of 0s
+	data[0] = 'c';
+	if (lseek(fd, 200, SEEK_SET) != 200 || write(fd, data, 1) != 1) {
+		return FAIL;
+	}
+	if (fstat(fd, st) != 0 || st->file_size != 201 || pread(fd, back, 300, 0) != 201) {
+		return FAIL;
+	}
+	for (i = 0; i < 201; i++) {
+		if (back[i] != ((i >= 50 && i < 60) ? 'b' : (i < 100) ? 'a' : (i < 200) ? 0 : 'c')) {
+			return FAIL;
+		}
+	}
+
 	return PASS;
 }
 
+/* test_file_run
+ * 		runs checks on a new empty file in the test process, then removes the file
+ * 
+ * Inputs: name - name of the file, must not exist
+ * 		   checks - checks to run on an fd of the file
+ * Outputs: PASS/FAIL
+ * Side Effects: creates and unlinks name in the root directory
+ */
+static int test_file_run(const char* name, int (*checks)(int32_t fd)) {
+	int32_t fd;
+	int result;
+
+	if (test_process_start()) {
+		return FAIL;
+	}
+	if (create((uint8_t*)name) != 0) {
+		test_process_end();
+		return FAIL;
+	}
+	fd = open((uint8_t*)name);
+	result = (fd != -1) ? checks(fd) : FAIL;
+	if (close(fd) != 0 || unlink((uint8_t*)name) != 0) {
+		result = FAIL;
+	}
+	test_process_end();
+
+	return result;
+}
+
+/* file_write_test
+ * 		tests file write through the write syscall on a new file
+ * 
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: creates and unlinks "write_test"
+ * Coverage: create, write, lseek, pread, fstat, unlink
+ * Files: fsys.c, syscall.c
+ */
+int file_write_test() {
+	TEST_HEADER;
+
+	return test_file_run("write_test", file_write_checks);
+}
+
 /* directory_open_test
  * 		tests directory open test syscall, opens "."
  * 
@@ -926,84 +1063,609 @@ int directory_write_test() {
  * Inputs: None
  * Outputs: PASS/FAIL
  * Side Effects: prints "$" character at RTC speed using rtc_read
- * Coverage: rtc_read, rtc_write, rtc_open
+ * Coverage: rtc_read, rtc_write, rtc_open, rtc_close
  * Files: rtc.c
  */
 int rtc_demo_test() {
-	uint32_t i = 0;
 	uint32_t start = 0;
-	uint32_t buf[1];
-    buf[0] = 2;
+	uint32_t* buf = (uint32_t*)TEST_BUF;
+	int32_t fd;
+	int result = PASS;
 
-	rtc_open(NULL);
+	if (test_process_start()) {
+		return FAIL;
+	}
+	fd = open((uint8_t*)"rtc");
+	buf[0] = 2;
 
-	if (rtc_write(NULL, buf, 4)) { //initial speed
+	if (fd == -1 || rtc_write(fd, buf, 4)) { //initial speed
+		close(fd);
+		test_process_end();
 		return FAIL;
-    }
+	}
 	printf("2Hz");
-	while(i < 10) {
-		rtc_read(0x0000, NULL, 0x0000);
-		printf("$");
-		start++;
-        if (start == 40) {
-            if (rtc_write(NULL, buf, 4)) {
-				return FAIL;
-            }
-            buf[0] *= 2;
-			i++;
+	// 40 ticks at every rate up to the highest one
+	while (start < 40 || buf[0] < RTC_BASE_FREQ) {
+		if (start == 40) {
+			buf[0] *= 2;
+			if (rtc_write(fd, buf, 4)) {
+				result = FAIL;
+				break;
+			}
 			printf("\n%dHz", buf[0]);
 			start = 0;
 		}
+		rtc_read(fd, NULL, 0);
+		printf("$");
+		start++;
 	}
-	return PASS;
+
+	close(fd);
+	test_process_end();
+	return result;
 }
 
-/* rtc_write_test
- * 		tests rtc
+/* rtc_fd_checks
+ * 		runs the rtc_write_test checks on an open RTC fd
  * 
- * Inputs: None
+ * Inputs: fd - RTC fd of the test process
  * Outputs: PASS/FAIL
- * Side Effects: none
- * Coverage: rtc_write
- * Files: rtc.c
+ * Side Effects: changes the fd's frequency and read mode
  */
-int rtc_write_test() {
-	TEST_HEADER;
-
-	uint32_t buf[1];
-	rtc_open(NULL);
+static int rtc_fd_checks(int32_t fd) {
+	uint32_t* buf = (uint32_t*)TEST_BUF;
+	uint32_t kernel_buf[2] = {2, 0};
 
 	if (PRINTING) {
 		printf("Writing bad RTC values\n");
 	}
-	
+
 	buf[0] = 1025;
-	if (rtc_write(NULL, buf, 4) != -1) {
+	if (rtc_write(fd, buf, 4) != -1) {
 		return FAIL;
 	}
 
 	buf[0] = 2048;
-	if (rtc_write(NULL, buf, 4) != -1) {
+	if (rtc_write(fd, buf, 4) != -1) {
 		return FAIL;
 	}
 
 	buf[0] = 5;
-	if (rtc_write(NULL, buf, 4) != -1) {
+	if (rtc_write(fd, buf, 4) != -1) {
+		return FAIL;
+	}
+
+	// buffers outside of the user page are refused
+	if (rtc_write(fd, kernel_buf, 4) != -1 || rtc_read(fd, kernel_buf, 4) != -1) {
 		return FAIL;
 	}
 
+	// a blocking read waits for a tick and reports the count
+	buf[0] = 1024;
+	if (rtc_write(fd, buf, 4) != 0 || rtc_read(fd, buf, 4) != 4 || buf[0] < 1) {
+		return FAIL;
+	}
+
+	// right after a restart at 2Hz no tick is pending, a non-blocking read reports 0
 	buf[0] = 2;
-	if (rtc_write(NULL, buf, 4) != 0) {
+	buf[1] = RTC_NONBLOCK;
+	if (rtc_write(fd, buf, 8) != 0 || rtc_read(fd, buf, 4) != 4 || buf[0] != 0) {
+		return FAIL;
+	}
+
+	// writing mode 0 makes reads block again
+	buf[0] = 1024;
+	buf[1] = 0;
+	if (rtc_write(fd, buf, 8) != 0 || rtc_read(fd, buf, 4) != 4 || buf[0] < 1) {
 		return FAIL;
 	}
 
+	// a pending signal interrupts a blocking read
+	buf[0] = 2;
+	if (rtc_write(fd, buf, 4) != 0) {
+		return FAIL;
+	}
+	current_PCB->signals.pending |= 1 << SIG_ALARM;
+	if (rtc_read(fd, buf, 4) != -1) {
+		current_PCB->signals.pending = 0;
+		return FAIL;
+	}
+	current_PCB->signals.pending = 0;
+
 	return PASS;
 }
 
+/* rtc_write_test
+ * 		tests rtc frequencies, the tick count and the non-blocking mode on a real RTC fd
+ * 
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: none
+ * Coverage: rtc_write, rtc_read
+ * Files: rtc.c
+ */
+int rtc_write_test() {
+	TEST_HEADER;
+
+	int32_t fd;
+	int result;
+
+	if (test_process_start()) {
+		return FAIL;
+	}
+	fd = open((uint8_t*)"rtc");
+	result = (fd != -1) ? rtc_fd_checks(fd) : FAIL;
+	close(fd);
+	test_process_end();
+
+	return result;
+}
+
 /* Checkpoint 3 tests */
 /* Checkpoint 4 tests */
 /* Checkpoint 5 tests */
 
+/* lz4_test
+ * 		decompresses hand-built LZ4 blocks, good ones and ones that must be refused
+ * 
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: lz4_decompress, literal and match lengths, offsets, output bounds
+ * Files: lz4.c
+ */
+int lz4_test() {
+	TEST_HEADER;
+
+	uint8_t literals[] = {0x50, 'h', 'e', 'l', 'l', 'o'};		/* "hello", no match */
+	uint8_t overlap[] = {0x12, 'a', 0x01, 0x00, 0x10, 'b'};	/* 'a', 6 bytes from 1 back, 'b' */
+	uint8_t far[] = {0x10, 'a', 0x02, 0x00, 0x00};			/* match 2 back after 1 byte */
+	uint8_t zero[] = {0x10, 'a', 0x00, 0x00, 0x00};			/* offset 0 */
+	uint8_t short_offset[] = {0x10, 'a', 0x01};				/* block ends inside the offset */
+	uint8_t cut_run[] = {0xF0, 0xFF};						/* block ends inside a 255 run */
+	uint8_t run[3 + 270];									/* 15 + 255 + 0 literals */
+	uint8_t out[300];
+	uint32_t i;
+
+	// literals only
+	if (lz4_decompress(literals, sizeof(literals), out, sizeof(out)) != 5 || strncmp((int8_t*)out, "hello", 5) != 0) {
+		return FAIL;
+	}
+
+	// a match that overlaps the bytes it produces repeats them
+	if (lz4_decompress(overlap, sizeof(overlap), out, sizeof(out)) != 8 || strncmp((int8_t*)out, "aaaaaaab", 8) != 0) {
+		return FAIL;
+	}
+
+	// a length continued over a 255 byte
+	run[0] = 0xF0;
+	run[1] = 0xFF;
+	run[2] = 0x00;
+	memset(run + 3, 'z', 270);
+	if (lz4_decompress(run, sizeof(run), out, sizeof(out)) != 270) {
+		return FAIL;
+	}
+	for (i = 0; i < 270; i++) {
+		if (out[i] != 'z') {
+			return FAIL;
+		}
+	}
+
+	// offsets before the start of the output, cut off blocks and full outputs are refused
+	if (lz4_decompress(far, sizeof(far), out, sizeof(out)) != -1 || lz4_decompress(zero, sizeof(zero), out, sizeof(out)) != -1 ||
+		lz4_decompress(short_offset, sizeof(short_offset), out, sizeof(out)) != -1 ||
+		lz4_decompress(cut_run, sizeof(cut_run), out, sizeof(out)) != -1 ||
+		lz4_decompress(run, sizeof(run) - 1, out, sizeof(out)) != -1) {
+		return FAIL;
+	}
+	if (lz4_decompress(literals, sizeof(literals), out, 4) != -1 || lz4_decompress(overlap, sizeof(overlap), out, 5) != -1 ||
+		lz4_decompress(overlap, sizeof(overlap), out, 7) != -1) {
+		return FAIL;
+	}
+
+	return PASS;
+}
+
+/* test_first_block
+ * 		finds where the first data block of a file is
+ * 
+ * Inputs: name - path of the file
+ * 		   addr - filled with the address of the block
+ * Outputs: 0 for success, -1 if the file is missing or empty
+ * Side Effects: None
+ */
+static int32_t test_first_block(const char* name, uint32_t* addr) {
+	vfs_sb_t* sb;
+	dentry_t dentry;
+
+	if (vfs_lookup(NULL, (uint8_t*)name, &sb, &dentry) == -1) {
+		return -1;
+	}
+	return sb->ops->block_addr(sb, dentry.inode_idx, 0, addr);
+}
+
+/* file_unlink_test
+ * 		creates a file, writes it, reads it back and unlinks it, twice; the second file
+ * 		must get the data block the first one freed
+ * 
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: creates and unlinks "unlink_test"
+ * Coverage: create, write, read, unlink, freeing data blocks
+ * Files: fsys.c, syscall.c
+ */
+int file_unlink_test() {
+	TEST_HEADER;
+
+	char* name = "unlink_test";
+	uint8_t* data = TEST_BUF;			/* bytes written */
+	uint8_t* back = TEST_BUF + _4KB;	/* bytes read back */
+	uint32_t block[2];					/* first data block of each round */
+	int32_t fd;
+	uint32_t round, i;
+	int result = PASS;
+
+	if (test_process_start()) {
+		return FAIL;
+	}
+
+	for (i = 0; i < 3000; i++) {
+		data[i] = i;
+	}
+
+	for (round = 0; round < 2 && result == PASS; round++) {
+		// the name is taken until the unlink
+		if (create((uint8_t*)name) != 0 || create((uint8_t*)name) != -1) {
+			result = FAIL;
+			break;
+		}
+
+		fd = open((uint8_t*)name);
+		if (fd == -1) {
+			result = FAIL;
+		} else {
+			if (write(fd, data, 3000) != 3000 || lseek(fd, 0, SEEK_SET) != 0 ||
+				read(fd, back, 4000) != 3000 || read(fd, back, 10) != 0) {
+				result = FAIL;
+			}
+			for (i = 0; i < 3000 && result == PASS; i++) {
+				if (back[i] != data[i]) {
+					result = FAIL;
+				}
+			}
+			if (test_first_block(name, &block[round]) != 0 || close(fd) != 0) {
+				result = FAIL;
+			}
+		}
+
+		// the file and its name are gone
+		if (unlink((uint8_t*)name) != 0 || unlink((uint8_t*)name) != -1 || open((uint8_t*)name) != -1) {
+			result = FAIL;
+		}
+	}
+
+	// the same allocation lands on the block the first file freed
+	if (result == PASS && block[0] != block[1]) {
+		result = FAIL;
+	}
+
+	test_process_end();
+	return result;
+}
+
+/* open_unlink_test
+ * 		unlinking an open file fails, so the fd never reaches a file created after it
+ * 
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: creates and unlinks "open_test" and "open_test2"
+ * Coverage: unlink, create, write through an fd of a file unlink refused
+ * Files: fsys.c, syscall.c
+ */
+int open_unlink_test() {
+	TEST_HEADER;
+
+	uint8_t* buf = TEST_BUF;
+	stat_t* st = (stat_t*)(TEST_BUF + _4KB);
+	int32_t fd, new_fd;
+	int result = PASS;
+
+	if (test_process_start()) {
+		return FAIL;
+	}
+	if (create((uint8_t*)"open_test") != 0) {
+		test_process_end();
+		return FAIL;
+	}
+
+	// the open file keeps its name and inode
+	fd = open((uint8_t*)"open_test");
+	if (fd == -1 || unlink((uint8_t*)"open_test") != -1 || create((uint8_t*)"open_test2") != 0) {
+		result = FAIL;
+	}
+	new_fd = open((uint8_t*)"open_test2");
+
+	// a write through the old fd lands in the old file only
+	memset(buf, 'x', 10);
+	if (new_fd == -1 || write(fd, buf, 10) != 10 ||
+		fstat(fd, st) != 0 || st->file_size != 10 || fstat(new_fd, st) != 0 || st->file_size != 0) {
+		result = FAIL;
+	}
+
+	// once closed both go away
+	close(fd);
+	close(new_fd);
+	if (unlink((uint8_t*)"open_test") != 0 || unlink((uint8_t*)"open_test2") != 0) {
+		result = FAIL;
+	}
+
+	test_process_end();
+	return result;
+}
+
+/* dcache_test
+ * 		a missed lookup is cached, and create, mkdir and unlink forget it
+ * 
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: creates and unlinks "dcache_test", "dcache_dir" and "dcache_hidden"
+ * Coverage: vfs_lookup negative entries, vfs_create, vfs_mkdir, vfs_unlink
+ * Files: vfs.c
+ */
+int dcache_test() {
+	TEST_HEADER;
+
+	vfs_sb_t* sb;
+	dentry_t dentry;
+	int32_t fd;
+	int result = PASS;
+
+	if (test_process_start()) {
+		return FAIL;
+	}
+
+	// a miss is cached: a file made behind the VFS stays hidden until the tree changes through it
+	if (vfs_lookup(NULL, (uint8_t*)".", &sb, &dentry) != 0 || open((uint8_t*)"dcache_hidden") != -1 ||
+		sb->ops->create(sb, sb->root, (uint8_t*)"dcache_hidden") != 0 ||
+		vfs_lookup(NULL, (uint8_t*)"dcache_hidden", &sb, &dentry) != -1) {
+		result = FAIL;
+	}
+
+	// create forgets the miss of the name it creates, and every other one
+	if (open((uint8_t*)"dcache_test") != -1 || open((uint8_t*)"/dcache_test") != -1 || create((uint8_t*)"dcache_test") != 0) {
+		result = FAIL;
+	}
+	fd = open((uint8_t*)"dcache_test");
+	if (fd == -1 || close(fd) != 0 || vfs_lookup(NULL, (uint8_t*)"/dcache_test", &sb, &dentry) != 0 ||
+		vfs_lookup(NULL, (uint8_t*)"dcache_hidden", &sb, &dentry) != 0) {
+		result = FAIL;
+	}
+
+	// unlink forgets the hits
+	if (unlink((uint8_t*)"dcache_test") != 0 || open((uint8_t*)"dcache_test") != -1 ||
+		vfs_lookup(NULL, (uint8_t*)"/dcache_test", &sb, &dentry) != -1) {
+		result = FAIL;
+	}
+
+	// mkdir forgets misses too
+	if (open((uint8_t*)"dcache_dir") != -1 || mkdir((uint8_t*)"dcache_dir") != 0) {
+		result = FAIL;
+	}
+	fd = open((uint8_t*)"dcache_dir");
+	if (fd == -1 || close(fd) != 0 || unlink((uint8_t*)"dcache_dir") != 0 || open((uint8_t*)"dcache_dir") != -1) {
+		result = FAIL;
+	}
+
+	// clean up whatever a failed check left
+	unlink((uint8_t*)"dcache_hidden");
+	unlink((uint8_t*)"dcache_test");
+	unlink((uint8_t*)"dcache_dir");
+	test_process_end();
+	return result;
+}
+
+/* lseek_pread_checks
+ * 		checks lseek and pread bounds on an open empty file
+ * 
+ * Inputs: fd - fd of the empty file, open in the test process
+ * Outputs: PASS/FAIL
+ * Side Effects: writes the file, uses TEST_BUF
+ */
+static int lseek_pread_checks(int32_t fd) {
+	uint8_t* buf = TEST_BUF;
+	uint8_t kernel_buf[4];
+
+	memset(buf, 'x', 100);
+	if (write(fd, buf, 100) != 100) {
+		return FAIL;
+	}
+
+	// lseek stays in [0, FSYS_MAX_POS] and leaves the position alone when it fails
+	if (lseek(fd, 0, SEEK_END) != 100 || lseek(fd, -1, SEEK_SET) != -1 || lseek(fd, -101, SEEK_END) != -1 ||
+		lseek(fd, 0, 3) != -1 || lseek(fd, 0, SEEK_CUR) != 100) {
+		return FAIL;
+	}
+	if (lseek(fd, FSYS_MAX_POS, SEEK_SET) != FSYS_MAX_POS || lseek(fd, 1, SEEK_CUR) != -1 ||
+		lseek(fd, -FSYS_MAX_POS, SEEK_CUR) != 0) {
+		return FAIL;
+	}
+
+	// pread stops at the end of the file and does not move the position
+	if (lseek(fd, 30, SEEK_SET) != 30 || pread(fd, buf, 20, 90) != 10 || pread(fd, buf, 20, 100) != 0 ||
+		pread(fd, buf, 20, 0xFFFFFFFF) != 0 || lseek(fd, 0, SEEK_CUR) != 30) {
+		return FAIL;
+	}
+
+	// buffers outside the user page and fds without a position fail
+	if (pread(fd, kernel_buf, 4, 0) != -1 || pread(fd, buf, -1, 0) != -1 || pread(fd, buf, _4MB + 1, 0) != -1 ||
+		pread(fd, TEST_BUF + _4MB - 2, 4, 0) != -1) {
+		return FAIL;
+	}
+	if (lseek(0, 0, SEEK_SET) != -1 || pread(1, buf, 4, 0) != -1 || lseek(-1, 0, SEEK_SET) != -1) {
+		return FAIL;
+	}
+
+	return PASS;
+}
+
+/* lseek_pread_test
+ * 		tests lseek and pread bounds on a new file
+ * 
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: creates and unlinks "lseek_test"
+ * Coverage: lseek, pread
+ * Files: fsys.c, syscall.c
+ */
+int lseek_pread_test() {
+	TEST_HEADER;
+
+	return test_file_run("lseek_test", lseek_pread_checks);
+}
+
+/* getdents_checks
+ * 		checks that getdents packs whole records and matches read on the same directory
+ * 
+ * Inputs: fd - fd of "." for getdents
+ * 		   names_fd - another fd of "." for read
+ * Outputs: PASS/FAIL
+ * Side Effects: reads both fds to the end, uses TEST_BUF
+ */
+static int getdents_checks(int32_t fd, int32_t names_fd) {
+	dirent_t* dirents = (dirent_t*)TEST_BUF;		/* records from getdents */
+	int8_t* name = (int8_t*)(TEST_BUF + _4KB);		/* name from read */
+	dirent_t kernel_dirent;
+	int32_t bytes;
+	uint32_t i, count = 0;
+
+	// a buffer must hold a whole record and be in the user page
+	if (getdents(fd, dirents, sizeof(dirent_t) - 1) != -1 || getdents(fd, &kernel_dirent, sizeof(dirent_t)) != -1 ||
+		getdents(fd, dirents, -1) != -1) {
+		return FAIL;
+	}
+
+	// room for two and a half records returns two until the directory runs out
+	do {
+		bytes = getdents(fd, dirents, 2 * sizeof(dirent_t) + sizeof(dirent_t) / 2);
+		if (bytes < 0 || bytes % sizeof(dirent_t) != 0 || bytes > 2 * sizeof(dirent_t) ||
+			(count == 0 && bytes != 2 * sizeof(dirent_t))) {
+			return FAIL;
+		}
+		for (i = 0; i < bytes / sizeof(dirent_t); i++, count++) {
+			if (read(names_fd, name, FILENAME_LEN) <= 0 || strncmp(dirents[i].file_name, name, FILENAME_LEN) != 0) {
+				return FAIL;
+			}
+		}
+	} while (bytes != 0);
+
+	// both reached the end together
+	if (read(names_fd, name, FILENAME_LEN) != 0 || getdents(fd, dirents, sizeof(dirent_t)) != 0) {
+		return FAIL;
+	}
+
+	return PASS;
+}
+
+/* getdents_test
+ * 		tests getdents on the root directory
+ * 
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: getdents, directory read
+ * Files: fsys.c, syscall.c
+ */
+int getdents_test() {
+	TEST_HEADER;
+
+	int32_t fd, names_fd;
+	int result;
+
+	if (test_process_start()) {
+		return FAIL;
+	}
+	fd = open((uint8_t*)".");
+	names_fd = open((uint8_t*)".");
+	result = (fd != -1 && names_fd != -1) ? getdents_checks(fd, names_fd) : FAIL;
+	close(fd);
+	close(names_fd);
+	test_process_end();
+
+	return result;
+}
+
+/* dup_checks
+ * 		checks that dup and dup2 share the open file, its position and its references
+ * 
+ * Inputs: fd - fd of an empty file, open in the test process
+ * Outputs: PASS/FAIL
+ * Side Effects: writes the file, opens and closes fds, uses TEST_BUF
+ */
+static int dup_checks(int32_t fd) {
+	file_desc_t* file = get_file_desc(fd);	/* open file every copy shares */
+	file_desc_t* other;						/* open file replaced by dup2 */
+	uint8_t* buf = TEST_BUF;
+	int32_t copy, other_fd;
+
+	strncpy((int8_t*)buf, "abcdef", 6);
+	if (write(fd, buf, 6) != 6 || lseek(fd, 0, SEEK_SET) != 0 || file->refs != 1) {
+		return FAIL;
+	}
+
+	// dup takes a reference and shares the position
+	copy = dup(fd);
+	if (copy == -1 || get_file_desc(copy) != file || file->refs != 2) {
+		return FAIL;
+	}
+	if (read(copy, buf, 3) != 3 || strncmp((int8_t*)buf, "abc", 3) != 0 ||
+		read(fd, buf, 3) != 3 || strncmp((int8_t*)buf, "def", 3) != 0) {
+		return FAIL;
+	}
+
+	// dup2 past FD_INLINE grows the table, onto itself it does nothing
+	if (dup2(fd, MAX_FDS - 1) != MAX_FDS - 1 || file->refs != 3 || dup2(fd, fd) != fd || file->refs != 3) {
+		return FAIL;
+	}
+
+	// dup2 onto an open fd drops the file that was there
+	other_fd = open((uint8_t*)".");
+	other = get_file_desc(other_fd);
+	if (other_fd == -1 || dup2(fd, other_fd) != other_fd || other->refs != 0 || file->refs != 4) {
+		return FAIL;
+	}
+
+	// bad fds fail without touching the references
+	if (dup(-1) != -1 || dup(MAX_FDS) != -1 || dup2(fd, MAX_FDS) != -1 || dup2(fd, -1) != -1 || dup2(-1, copy) != -1 ||
+		file->refs != 4) {
+		return FAIL;
+	}
+
+	// closing the copies gives back their references, the open file stays for fd
+	if (close(copy) != 0 || close(MAX_FDS - 1) != 0 || close(other_fd) != 0 || close(copy) != -1 || file->refs != 1) {
+		return FAIL;
+	}
+	if (pread(fd, buf, 6, 0) != 6 || strncmp((int8_t*)buf, "abcdef", 6) != 0) {
+		return FAIL;
+	}
+
+	return PASS;
+}
+
+/* dup_test
+ * 		tests dup and dup2 reference counts on a new file
+ * 
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: creates and unlinks "dup_test"
+ * Coverage: dup, dup2, close, growing the fd table
+ * Files: process.c, syscall.c
+ */
+int dup_test() {
+	TEST_HEADER;
+
+	return test_file_run("dup_test", dup_checks);
+}
+
 
 /* Test suite entry point */
 void launch_tests() {
@@ -1036,7 +1698,6 @@ void launch_tests() {
 	
 	// TEST_OUTPUT("file_open_test", file_open_test());
 	// TEST_OUTPUT("file_close_test", file_close_test());
-	// TEST_OUTPUT("file_write_test", file_write_test());
 	// TEST_OUTPUT("file_read_test", file_read_test());
 
 	// TEST_OUTPUT("directory_open_test", directory_open_test());
@@ -1044,6 +1705,16 @@ void launch_tests() {
 	// TEST_OUTPUT("directory_write_test", directory_write_test());
 	// TEST_OUTPUT("directory_read_test", directory_read_test());
 
+	/* checkpoint 5 */
+	TEST_OUTPUT("lz4_test", lz4_test());
+	TEST_OUTPUT("file_write_test", file_write_test());
+	TEST_OUTPUT("file_unlink_test", file_unlink_test());
+	TEST_OUTPUT("open_unlink_test", open_unlink_test());
+	TEST_OUTPUT("dcache_test", dcache_test());
+	TEST_OUTPUT("lseek_pread_test", lseek_pread_test());
+	TEST_OUTPUT("getdents_test", getdents_test());
+	TEST_OUTPUT("dup_test", dup_test());
+
 	printf("Tests complete!\n");
 }
 
@@ -0,0 +1,275 @@
+#include "lib.h"
+#include "timer.h"
+
+#include "./drivers/pit.h"
+
+/* wheel ticks are microseconds >> TIMER_TICK_SHIFT, so they wrap at 2^(32 - TIMER_TICK_SHIFT) */
+#define TIMER_TICK_MASK     (0xFFFFFFFF >> TIMER_TICK_SHIFT)
+/* check if tick a is before tick b, safe across the tick wrap */
+#define TICK_BEFORE(a, b)   ((int32_t)(((a) - (b)) << TIMER_TICK_SHIFT) < 0)
+
+/* wheel levels, each slot is a singly linked list of timers */
+static ktimer_t* tv1[TIMER_TV1_SIZE];
+static ktimer_t* tv2[TIMER_TVN_SIZE];
+static ktimer_t* tv3[TIMER_TVN_SIZE];
+
+static uint32_t timer_clk;          /* next wheel tick that has not been fully expired */
+static uint32_t timer_clk_ready;    /* higher levels were already cascaded for timer_clk (1) or not (0) */
+
+/* timer_link - pushes a timer onto a slot
+ *
+ * Inputs: head - slot to push onto
+ *         timer - timer to push
+ * Outputs: None
+ * Side Effects: None
+ */
+static void timer_link(ktimer_t** head, ktimer_t* timer) {
+    timer->next = *head;
+    if (*head != NULL) {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+/* timer_unlink - removes a timer from whatever slot it is in
+ *
+ * Inputs: timer - timer to remove
+ * Outputs: None
+ * Side Effects: None
+ */
+static void timer_unlink(ktimer_t* timer) {
+    *timer->pprev = timer->next;
+    if (timer->next != NULL) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+/* timer_enqueue - puts a timer in the slot matching its deadline
+ *
+ * Inputs: timer - timer to queue, expires must already be set
+ * Outputs: None
+ * Side Effects: None
+ */
+static void timer_enqueue(ktimer_t* timer) {
+    uint32_t tick = (timer->expires >> TIMER_TICK_SHIFT);  /* wheel tick the timer expires in */
+    uint32_t delta;                                         /* wheel ticks from timer_clk */
+
+    // deadlines in ticks that were already passed go in the current slot
+    if (TICK_BEFORE(tick, timer_clk)) {
+        tick = timer_clk;
+    }
+    delta = (tick - timer_clk) & TIMER_TICK_MASK;
+
+    if (delta < TIMER_TV1_SIZE) {
+        timer_link(&tv1[tick & TIMER_TV1_MASK], timer);
+    } else if (delta < (1 << (TIMER_TV1_BITS + TIMER_TVN_BITS))) {
+        timer_link(&tv2[(tick >> TIMER_TV1_BITS) & TIMER_TVN_MASK], timer);
+    } else {
+        timer_link(&tv3[(tick >> (TIMER_TV1_BITS + TIMER_TVN_BITS)) & TIMER_TVN_MASK], timer);
+    }
+}
+
+/* timer_cascade - moves every timer of a higher level slot down the wheel
+ *
+ * Inputs: slot - slot to empty
+ * Outputs: None
+ * Side Effects: None
+ */
+static void timer_cascade(ktimer_t** slot) {
+    ktimer_t* timer; /* timer being moved */
+
+    while ((timer = *slot) != NULL) {
+        timer_unlink(timer);
+        timer_enqueue(timer);
+    }
+}
+
+/* init_timers - timer wheel initialization
+ *
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: empties the wheel, must run before init_PIT starts the clock at 0
+ */
+void init_timers(void) {
+    uint32_t i; /* loop index */
+
+    for (i = 0; i < TIMER_TV1_SIZE; i++) {
+        tv1[i] = NULL;
+    }
+    for (i = 0; i < TIMER_TVN_SIZE; i++) {
+        tv2[i] = NULL;
+        tv3[i] = NULL;
+    }
+
+    timer_clk = 0;
+    timer_clk_ready = 0;
+}
+
+/* timer_setup - sets up a timer that is not queued
+ *
+ * Inputs: timer - timer to set up
+ *         callback - function to run when the timer expires
+ *         data - owner data for the callback
+ * Outputs: None
+ * Side Effects: None
+ */
+void timer_setup(ktimer_t* timer, void (*callback)(ktimer_t*), uint32_t data) {
+    timer->expires = 0;
+    timer->pending = 0;
+    timer->callback = callback;
+    timer->data = data;
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+/* timer_add - queues a timer
+ *      a timer that is already queued is moved to the new deadline
+ *
+ * Inputs: timer - timer to queue
+ *         delay - microseconds from now until the timer expires, at most TIMER_MAX_DELAY
+ * Outputs: 0 for success, -1 if the delay is too long
+ * Side Effects: brings the next PIT interrupt forward if this is the earliest deadline
+ */
+int32_t timer_add(ktimer_t* timer, uint32_t delay) {
+    uint32_t save; /* variable to store flags */
+
+    if (delay > TIMER_MAX_DELAY) {
+        return -1;
+    }
+
+    cli_and_save(save);
+
+    if (timer->pending) {
+        timer_unlink(timer);
+    }
+    timer->expires = pit_time() + delay;
+    timer->pending = 1;
+    timer_enqueue(timer);
+
+    // make sure the PIT fires in time for this deadline
+    pit_set_next_event(timer->expires);
+
+    restore_flags(save);
+    return 0;
+}
+
+/* timer_del - removes a timer from the wheel
+ *
+ * Inputs: timer - timer to remove, may or may not be queued
+ * Outputs: None
+ * Side Effects: the timer's callback will not run
+ */
+void timer_del(ktimer_t* timer) {
+    uint32_t save; /* variable to store flags */
+
+    cli_and_save(save);
+    if (timer->pending) {
+        timer_unlink(timer);
+        timer->pending = 0;
+    }
+    restore_flags(save);
+}
+
+/* timer_run - expires every timer that is due
+ *      walks the wheel one tick at a time up to the tick holding now, so the cost
+ *      is the number of ticks elapsed plus the number of timers expired
+ *      must be called with interrupts disabled
+ *
+ * Inputs: now - current time in microseconds
+ * Outputs: None
+ * Side Effects: runs callbacks of expired timers
+ */
+void timer_run(uint32_t now) {
+    uint32_t now_tick = (now >> TIMER_TICK_SHIFT); /* wheel tick holding now */
+    uint32_t idx;                                   /* tv1 slot of timer_clk */
+    ktimer_t* work;                                 /* timers of the slot being expired */
+    ktimer_t* timer;                                /* current timer */
+
+    while (!TICK_BEFORE(now_tick, timer_clk)) {
+        idx = timer_clk & TIMER_TV1_MASK;
+
+        // tv1 wrapped around, pull the next range of deadlines down from the higher levels
+        if (!timer_clk_ready) {
+            if (idx == 0) {
+                if (((timer_clk >> TIMER_TV1_BITS) & TIMER_TVN_MASK) == 0) {
+                    timer_cascade(&tv3[(timer_clk >> (TIMER_TV1_BITS + TIMER_TVN_BITS)) & TIMER_TVN_MASK]);
+                }
+                timer_cascade(&tv2[(timer_clk >> TIMER_TV1_BITS) & TIMER_TVN_MASK]);
+            }
+            timer_clk_ready = 1;
+        }
+
+        // move the slot to a private list, callbacks may add or delete timers
+        work = tv1[idx];
+        tv1[idx] = NULL;
+        if (work != NULL) {
+            work->pprev = &work;
+        }
+
+        while ((timer = work) != NULL) {
+            timer_unlink(timer);
+            if (TIME_BEFORE(now, timer->expires)) {
+                // same tick but a later microsecond, keep it for the next interrupt
+                timer_link(&tv1[idx], timer);
+            } else {
+                timer->pending = 0;
+                timer->callback(timer);
+            }
+        }
+
+        // the tick holding now is not over yet
+        if (timer_clk == now_tick) {
+            break;
+        }
+        timer_clk = (timer_clk + 1) & TIMER_TICK_MASK;
+        timer_clk_ready = 0;
+    }
+}
+
+/* timer_next_expiry - finds the earliest deadline before limit
+ *      only looks at tv1 slots up to limit, and stops at the next tv1 wrap so
+ *      timers still waiting in higher levels get cascaded in time
+ *      must be called with interrupts disabled, right after timer_run
+ *
+ * Inputs: now - current time in microseconds
+ *         limit - latest time the caller wants to wake up at
+ * Outputs: earliest deadline, or limit if nothing expires before it
+ * Side Effects: None
+ */
+uint32_t timer_next_expiry(uint32_t now, uint32_t limit) {
+    uint32_t next = limit;                              /* earliest deadline found */
+    uint32_t tick = timer_clk;                          /* wheel tick being checked */
+    uint32_t last_tick = (limit >> TIMER_TICK_SHIFT);   /* wheel tick holding limit */
+    ktimer_t* timer;                                    /* current timer */
+
+    while (!TICK_BEFORE(last_tick, tick)) {
+        // higher levels cascade when tv1 wraps around
+        if ((tick & TIMER_TV1_MASK) == 0 && tick != timer_clk) {
+            if (TIME_BEFORE(tick << TIMER_TICK_SHIFT, next)) {
+                next = tick << TIMER_TICK_SHIFT;
+            }
+            break;
+        }
+
+        for (timer = tv1[tick & TIMER_TV1_MASK]; timer != NULL; timer = timer->next) {
+            if (TIME_BEFORE(timer->expires, next)) {
+                next = timer->expires;
+            }
+        }
+
+        // every later slot holds later deadlines
+        if (TIME_BEFORE(next, ((tick + 1) & TIMER_TICK_MASK) << TIMER_TICK_SHIFT)) {
+            break;
+        }
+        tick = (tick + 1) & TIMER_TICK_MASK;
+    }
+
+    // never ask for a deadline that is already behind us
+    if (TIME_BEFORE(next, now)) {
+        next = now;
+    }
+    return next;
+}
@@ -0,0 +1,60 @@
+/* timer.h - hierarchical timer wheel for kernel timers
+ * vim:ts=4 noexpandtab
+ */
+#ifndef _TIMER_H
+#define _TIMER_H
+
+#include "types.h"
+
+/*
+ * Deadlines are absolute microsecond times from pit_time(), compared
+ * wrap-safely. The wheel advances in ticks of 2^TIMER_TICK_SHIFT us:
+ *      level 1 - 256 slots of 1 tick      (~262 ms)
+ *      level 2 -  64 slots of 256 ticks   (~16.7 s)
+ *      level 3 -  64 slots of 16384 ticks (~17.9 min)
+ * Adding, deleting and expiring a timer is O(1); slots of higher levels are
+ * cascaded down one level each time the level below wraps around.
+ */
+#define TIMER_TICK_SHIFT    10
+#define TIMER_TV1_BITS      8
+#define TIMER_TVN_BITS      6
+#define TIMER_TV1_SIZE      (1 << TIMER_TV1_BITS)
+#define TIMER_TVN_SIZE      (1 << TIMER_TVN_BITS)
+#define TIMER_TV1_MASK      (TIMER_TV1_SIZE - 1)
+#define TIMER_TVN_MASK      (TIMER_TVN_SIZE - 1)
+
+/* longest delay the wheel can hold, in microseconds */
+#define TIMER_MAX_DELAY     (((1 << (TIMER_TV1_BITS + 2*TIMER_TVN_BITS)) - 1) << TIMER_TICK_SHIFT)
+
+/* check if time a is before time b, safe across the 32-bit microsecond wrap */
+#define TIME_BEFORE(a, b)   ((int32_t)((a) - (b)) < 0)
+
+/* a kernel timer, embedded in whatever owns it */
+typedef struct ktimer_t {
+    uint32_t expires;                       /* absolute deadline in microseconds */
+    uint32_t pending;                       /* queued in the wheel (1) or not (0) */
+    void (*callback)(struct ktimer_t*);     /* runs in the PIT interrupt when the timer expires */
+    uint32_t data;                          /* owner data for the callback */
+    struct ktimer_t* next;                  /* next timer in the same slot */
+    struct ktimer_t** pprev;                /* link pointing to this timer, for O(1) removal */
+} ktimer_t;
+
+/* initializes the timer wheel */
+void init_timers(void);
+
+/* sets up a timer that is not queued */
+void timer_setup(ktimer_t* timer, void (*callback)(ktimer_t*), uint32_t data);
+
+/* queues a timer to expire delay microseconds from now */
+int32_t timer_add(ktimer_t* timer, uint32_t delay);
+
+/* removes a timer from the wheel if it is queued */
+void timer_del(ktimer_t* timer);
+
+/* expires every timer due at time now, called from the PIT interrupt */
+void timer_run(uint32_t now);
+
+/* finds the earliest deadline before limit */
+uint32_t timer_next_expiry(uint32_t now, uint32_t limit);
+
+#endif /* _TIMER_H */
@@ -0,0 +1,330 @@
+#include "lib.h"
+#include "vfs.h"
+#include "process.h"
+
+/* one mounted instance */
+typedef struct vfs_mount_t {
+    vfs_sb_t* sb;                           // mounted instance, NULL for a free entry
+    int8_t name[FILENAME_LEN + 1];          // name in the root, empty for "/"
+} vfs_mount_t;
+
+/* one looked up path, found or not */
+typedef struct vfs_dentry_t {
+    vfs_sb_t* sb;                           // instance the path was looked up in, NULL for a free entry
+    uint32_t dir;                           // directory a relative path started at, the root for an absolute one
+    uint32_t found;                         // the path exists (1), or the entry only records that it does not (0)
+    int8_t path[VFS_DCACHE_PATH_LEN + 1];   // path within the instance
+    dentry_t dentry;                        // dentry the path resolved to when found
+} vfs_dentry_t;
+
+/* entry 0 is "/", the others are mounted under a name in the root */
+static vfs_mount_t vfs_mounts[VFS_MAX_MOUNTS];
+
+/* direct mapped, a new lookup replaces whatever was in its slot */
+static vfs_dentry_t vfs_dcache[VFS_DCACHE_SIZE];
+
+/* path of the root of an instance */
+static const uint8_t vfs_root_path[] = "/";
+
+/* vfs_dcache_hash - picks the dentry cache slot of a lookup
+ *      FNV-1a over the path, then the instance and directory
+ *
+ * Inputs: sb - instance the path is looked up in
+ *         dir - directory the lookup starts at
+ *         path - path within the instance
+ * Outputs: slot index below VFS_DCACHE_SIZE
+ * Side Effects: None
+ */
+static uint32_t vfs_dcache_hash(vfs_sb_t* sb, uint32_t dir, const uint8_t* path) {
+    uint32_t hash = 2166136261U;    /* FNV offset basis */
+
+    while (*path != '\0') {
+        hash ^= *path++;
+        hash *= 16777619;           /* FNV prime */
+    }
+    hash ^= (uint32_t)sb;
+    hash *= 16777619;
+    hash ^= dir;
+    hash *= 16777619;
+
+    return (hash ^ (hash >> 16)) & (VFS_DCACHE_SIZE - 1);
+}
+
+/* vfs_dcache_flush - forgets the cached lookups of an instance whose tree changed
+ *
+ * Inputs: sb - instance, NULL for every instance
+ * Outputs: None
+ * Side Effects: frees the slots
+ */
+static void vfs_dcache_flush(vfs_sb_t* sb) {
+    uint32_t i; /* loop index */
+
+    for (i = 0; i < VFS_DCACHE_SIZE; i++) {
+        if (sb == NULL || vfs_dcache[i].sb == sb) {
+            vfs_dcache[i].sb = NULL;
+        }
+    }
+}
+
+/* vfs_mount - mounts an instance
+ *      a mount other than "/" takes one name in the root, like "/mod1"
+ *
+ * Inputs: path - "/", or '/' followed by 1 to FILENAME_LEN characters other than '/'
+ *         sb - instance filled in by its file system
+ * Outputs: 0 for success, -1 for a bad path, a path already mounted or a full mount table
+ * Side Effects: lookups cached before the mount are forgotten, it may hide a name of "/"
+ */
+int32_t vfs_mount(const int8_t* path, vfs_sb_t* sb) {
+    vfs_mount_t* mount = NULL;  /* entry to fill */
+    uint32_t len;               /* length of the name */
+    uint32_t i;                 /* loop index */
+    uint32_t save;              /* variable to store flags */
+
+    if (path == NULL || path[0] != '/' || sb == NULL) {
+        return -1;
+    }
+    path++;
+    len = strlen(path);
+    for (i = 0; i < len; i++) {
+        if (path[i] == '/') {
+            return -1;
+        }
+    }
+    if (len > FILENAME_LEN) {
+        return -1;
+    }
+
+    cli_and_save(save);
+
+    if (len == 0) {
+        mount = &vfs_mounts[0];
+        if (mount->sb != NULL) {
+            mount = NULL;
+        }
+    } else {
+        for (i = 1; i < VFS_MAX_MOUNTS; i++) {
+            if (vfs_mounts[i].sb != NULL && strncmp(vfs_mounts[i].name, path, FILENAME_LEN + 1) == 0) {
+                mount = NULL;
+                break;
+            }
+            if (vfs_mounts[i].sb == NULL && mount == NULL) {
+                mount = &vfs_mounts[i];
+            }
+        }
+    }
+    if (mount == NULL) {
+        restore_flags(save);
+        return -1;
+    }
+
+    strcpy(mount->name, path);
+    mount->sb = sb;
+    vfs_dcache_flush(NULL);
+
+    restore_flags(save);
+    return 0;
+}
+
+/* vfs_root - gets the root directory of the "/" mount
+ *
+ * Inputs: root - filled with the directory
+ * Outputs: 0 for success, -1 if nothing is mounted at "/"
+ * Side Effects: root->sb is NULL on failure
+ */
+int32_t vfs_root(vfs_inode_t* root) {
+    root->sb = vfs_mounts[0].sb;
+    root->inode = (root->sb != NULL) ? root->sb->root : 0;
+    return (root->sb != NULL) ? 0 : -1;
+}
+
+/* vfs_cwd - gets the current directory of the running process
+ *      a directory removed since the process entered it falls back to the root
+ *
+ * Inputs: cwd - filled with the directory
+ * Outputs: None
+ * Side Effects: cwd->sb is NULL when no process is running and nothing is mounted at "/"
+ */
+void vfs_cwd(vfs_inode_t* cwd) {
+    if (current_PCB == NULL || !CHECK_FLAG(activeProcesses, current_PCB->id) || current_PCB->cwd.sb == NULL ||
+        !current_PCB->cwd.sb->ops->is_dir(current_PCB->cwd.sb, current_PCB->cwd.inode)) {
+        vfs_root(cwd);
+        return;
+    }
+    *cwd = current_PCB->cwd;
+}
+
+/* vfs_resolve - finds the instance a path is in
+ *      an absolute path whose first component is a mount name continues in the root of that
+ *      mount, any other absolute path is in "/", and a relative path starts at start
+ *
+ * Inputs: start - directory a relative path begins at, NULL for the current directory
+ *         path - path to resolve
+ *         dir - filled with the instance and the directory the rest begins at
+ *         rest - filled with the path within the instance, "/" for the root of a mount
+ * Outputs: 0 for success, -1 for an empty path or if no instance holds it
+ * Side Effects: None
+ */
+static int32_t vfs_resolve(const vfs_inode_t* start, const uint8_t* path, vfs_inode_t* dir, const uint8_t** rest) {
+    const uint8_t* name;    /* first component of an absolute path */
+    uint32_t len;           /* length of the first component */
+    uint32_t i;             /* loop index */
+
+    if (path == NULL || path[0] == '\0') {
+        return -1;
+    }
+
+    if (path[0] != '/') {
+        if (start != NULL) {
+            *dir = *start;
+        } else {
+            vfs_cwd(dir);
+        }
+        *rest = path;
+        return (dir->sb != NULL) ? 0 : -1;
+    }
+
+    for (name = path; *name == '/'; name++);
+    for (len = 0; name[len] != '/' && name[len] != '\0'; len++);
+    for (i = 1; len != 0 && len <= FILENAME_LEN && i < VFS_MAX_MOUNTS; i++) {
+        if (vfs_mounts[i].sb != NULL && strncmp(vfs_mounts[i].name, (int8_t*)name, len) == 0 && vfs_mounts[i].name[len] == '\0') {
+            dir->sb = vfs_mounts[i].sb;
+            dir->inode = dir->sb->root;
+            *rest = (name[len] != '\0') ? name + len : vfs_root_path;
+            return 0;
+        }
+    }
+
+    *rest = path;
+    return vfs_root(dir);
+}
+
+/* vfs_lookup - resolves a path to its instance and dentry
+ *      the result is cached by instance, starting directory and path; a path that is not
+ *      found is cached too, so looking it up again costs one probe
+ *
+ * Inputs: start - directory a relative path begins at, NULL for the current directory
+ *         path - path to find
+ *         sb - filled with the instance holding the path
+ *         dentry - dentry to fill, a directory named by its path gets a "." dentry
+ * Outputs: 0 for success, -1 if the path is empty or not found
+ * Side Effects: may replace a cached lookup
+ */
+int32_t vfs_lookup(const vfs_inode_t* start, const uint8_t* path, vfs_sb_t** sb, dentry_t* dentry) {
+    vfs_inode_t dir;        /* instance and directory the rest begins at */
+    const uint8_t* rest;    /* path within the instance */
+    vfs_dentry_t* entry;    /* cache slot of the lookup */
+    int32_t ret;            /* return value */
+    uint32_t save;          /* variable to store flags */
+
+    if (vfs_resolve(start, path, &dir, &rest) == -1) {
+        return -1;
+    }
+    *sb = dir.sb;
+
+    // an absolute path does not depend on the directory, every start shares its entry
+    if (rest[0] == '/') {
+        dir.inode = dir.sb->root;
+    }
+    if (strlen((int8_t*)rest) > VFS_DCACHE_PATH_LEN) {
+        return dir.sb->ops->lookup(dir.sb, dir.inode, rest, dentry);
+    }
+
+    cli_and_save(save);
+
+    entry = &vfs_dcache[vfs_dcache_hash(dir.sb, dir.inode, rest)];
+    if (entry->sb == dir.sb && entry->dir == dir.inode && strncmp(entry->path, (int8_t*)rest, VFS_DCACHE_PATH_LEN + 1) == 0) {
+        if (entry->found) {
+            memcpy(dentry, &entry->dentry, DENTRY_SIZE);
+        }
+        ret = (entry->found) ? 0 : -1;
+        restore_flags(save);
+        return ret;
+    }
+
+    ret = dir.sb->ops->lookup(dir.sb, dir.inode, rest, dentry);
+    entry->sb = dir.sb;
+    entry->dir = dir.inode;
+    entry->found = (ret == 0);
+    strcpy(entry->path, (int8_t*)rest);
+    if (ret == 0) {
+        memcpy(&entry->dentry, dentry, DENTRY_SIZE);
+    }
+
+    restore_flags(save);
+    return ret;
+}
+
+/* vfs_create - creates an empty regular file
+ *
+ * Inputs: path - path of the file, relative to the current directory unless it starts with '/'
+ * Outputs: 0 for success, -1 for failure
+ * Side Effects: adds the file, forgets the cached lookups of its instance
+ */
+int32_t vfs_create(const uint8_t* path) {
+    vfs_inode_t dir;        /* instance and directory the rest begins at */
+    const uint8_t* rest;    /* path within the instance */
+    int32_t ret;            /* return value */
+    uint32_t save;          /* variable to store flags */
+
+    if (vfs_resolve(NULL, path, &dir, &rest) == -1 || dir.sb->ops->create == NULL) {
+        return -1;
+    }
+
+    cli_and_save(save);
+    ret = dir.sb->ops->create(dir.sb, dir.inode, rest);
+    if (ret == 0) {
+        vfs_dcache_flush(dir.sb);
+    }
+    restore_flags(save);
+    return ret;
+}
+
+/* vfs_mkdir - creates an empty directory
+ *
+ * Inputs: path - path of the directory, relative to the current directory unless it starts with '/'
+ * Outputs: 0 for success, -1 for failure
+ * Side Effects: adds the directory, forgets the cached lookups of its instance
+ */
+int32_t vfs_mkdir(const uint8_t* path) {
+    vfs_inode_t dir;        /* instance and directory the rest begins at */
+    const uint8_t* rest;    /* path within the instance */
+    int32_t ret;            /* return value */
+    uint32_t save;          /* variable to store flags */
+
+    if (vfs_resolve(NULL, path, &dir, &rest) == -1 || dir.sb->ops->mkdir == NULL) {
+        return -1;
+    }
+
+    cli_and_save(save);
+    ret = dir.sb->ops->mkdir(dir.sb, dir.inode, rest);
+    if (ret == 0) {
+        vfs_dcache_flush(dir.sb);
+    }
+    restore_flags(save);
+    return ret;
+}
+
+/* vfs_unlink - removes a regular file or an empty directory
+ *
+ * Inputs: path - path of the file, relative to the current directory unless it starts with '/'
+ * Outputs: 0 for success, -1 for failure
+ * Side Effects: removes the file, forgets the cached lookups of its instance
+ */
+int32_t vfs_unlink(const uint8_t* path) {
+    vfs_inode_t dir;        /* instance and directory the rest begins at */
+    const uint8_t* rest;    /* path within the instance */
+    int32_t ret;            /* return value */
+    uint32_t save;          /* variable to store flags */
+
+    if (vfs_resolve(NULL, path, &dir, &rest) == -1 || dir.sb->ops->unlink == NULL) {
+        return -1;
+    }
+
+    cli_and_save(save);
+    ret = dir.sb->ops->unlink(dir.sb, dir.inode, rest);
+    if (ret == 0) {
+        vfs_dcache_flush(dir.sb);
+    }
+    restore_flags(save);
+    return ret;
+}
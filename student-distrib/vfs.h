@@ -0,0 +1,83 @@
+/* vfs.h - mount table and path lookup over the mounted file systems
+ * vim:ts=4 noexpandtab
+ */
+#ifndef _VFS_H
+#define _VFS_H
+
+#include "types.h"
+#include "./drivers/fsys.h"
+
+#define VFS_MAX_MOUNTS          4       /* "/" plus the images mounted under it */
+#define VFS_NUM_FILE_TYPES      3       /* RTC, directory and regular dentries */
+
+/* dentry cache, power of 2 so the hash can be masked */
+#define VFS_DCACHE_SIZE         64
+#define VFS_DCACHE_PATH_LEN     64      /* longest path kept in the cache, longer ones are always walked */
+
+/*
+ * "/" is mounted first; every other image is mounted under a single name in
+ * the root, such as "/mod1", and a path whose first component is that name
+ * is looked up in the image's own root. A relative path starts at the
+ * current directory and stays in the image it is in, so ".." at the root of
+ * a mounted image stays there and other images are reached by absolute
+ * paths. Mount points are not dentries of "/" and do not show up when it is
+ * listed.
+ */
+
+struct vfs_sb_t;
+
+/* operations a file system provides for each mounted instance */
+typedef struct vfs_ops_t {
+    /* finds a path, relative to dir unless it starts with '/' */
+    int32_t (*lookup)(struct vfs_sb_t* sb, uint32_t dir, const uint8_t* path, dentry_t* dentry);
+    /* checks that an inode is still a directory */
+    uint32_t (*is_dir)(struct vfs_sb_t* sb, uint32_t inode);
+    /* describes an inode of the given file type */
+    int32_t (*stat)(struct vfs_sb_t* sb, uint32_t file_type, uint32_t inode, stat_t* st);
+    /* reads bytes of a regular file */
+    int32_t (*read_data)(struct vfs_sb_t* sb, uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length);
+    /* gets the address of a file block in memory, -1 if it has none */
+    int32_t (*block_addr)(struct vfs_sb_t* sb, uint32_t inode, uint32_t block, uint32_t* addr);
+    /* create, mkdir and unlink take a path the same way lookup does */
+    int32_t (*create)(struct vfs_sb_t* sb, uint32_t dir, const uint8_t* path);
+    int32_t (*mkdir)(struct vfs_sb_t* sb, uint32_t dir, const uint8_t* path);
+    int32_t (*unlink)(struct vfs_sb_t* sb, uint32_t dir, const uint8_t* path);
+    /* jumptable open gives an fd on a dentry of each file type, NULL if it cannot be opened */
+    fops_jumptable_t* fops[VFS_NUM_FILE_TYPES];
+} vfs_ops_t;
+
+/* one mounted instance of a file system, filled in by the file system */
+typedef struct vfs_sb_t {
+    vfs_ops_t* ops;                 /* operations of the file system */
+    uint32_t root;                  /* directory inode of the root */
+    void* fs_data;                  /* file system state of the instance */
+} vfs_sb_t;
+
+/* a directory or file of a mounted instance */
+typedef struct vfs_inode_t {
+    vfs_sb_t* sb;                   /* instance holding the inode, NULL for none */
+    uint32_t inode;                 /* inode number within the instance */
+} vfs_inode_t;
+
+/* mounts an instance at "/" or under a single name in the root */
+int32_t vfs_mount(const int8_t* path, vfs_sb_t* sb);
+
+/* gets the root directory of the "/" mount */
+int32_t vfs_root(vfs_inode_t* root);
+
+/* gets the current directory of the running process */
+void vfs_cwd(vfs_inode_t* cwd);
+
+/* resolves a path to the instance holding it and its dentry */
+int32_t vfs_lookup(const vfs_inode_t* start, const uint8_t* path, vfs_sb_t** sb, dentry_t* dentry);
+
+/* creates an empty regular file */
+int32_t vfs_create(const uint8_t* path);
+
+/* creates an empty directory */
+int32_t vfs_mkdir(const uint8_t* path);
+
+/* removes a regular file or an empty directory */
+int32_t vfs_unlink(const uint8_t* path);
+
+#endif /* _VFS_H */
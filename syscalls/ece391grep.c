@@ -5,12 +5,14 @@
 
 #define BUFSIZE 1024
 #define SBUFSIZE 33
+#define NUM_DIRENTS 16
 
 int32_t
 do_one_file (const char* s, const char* fname) 
 {
     int32_t fd, cnt, last, line_start, line_end, check, s_len;
     uint8_t data[BUFSIZE+1];
+    struct ece391_iovec iov[4];
 
     s_len = ece391_strlen ((uint8_t*)s);
     if (-1 == (fd = ece391_open ((uint8_t*)fname))) {
@@ -42,10 +44,15 @@ do_one_file (const char* s, const char* fname)
 	    for (check = line_start; check < line_end; check++) {
 		if (s[0] == data[check] && 
 		    0 == ece391_strncmp ((uint8_t*)(data + check), (uint8_t*)s, s_len)) {
-		    ece391_fdputs (1, (uint8_t*)fname);
-		    ece391_fdputs (1, (uint8_t*)":");
-		    ece391_fdputs (1, data + line_start);
-		    ece391_fdputs (1, (uint8_t*)"\n");
+		    iov[0].base = (void*)fname;
+		    iov[0].len = ece391_strlen ((uint8_t*)fname);
+		    iov[1].base = ":";
+		    iov[1].len = 1;
+		    iov[2].base = data + line_start;
+		    iov[2].len = line_end - line_start;
+		    iov[3].base = "\n";
+		    iov[3].len = 1;
+		    (void)ece391_writev (1, iov, 4);
 		    break;
 		}
 	    }
@@ -67,7 +74,8 @@ do_one_file (const char* s, const char* fname)
 
 int main ()
 {
-    int32_t fd, cnt;
+    int32_t fd, cnt, i, j;
+    struct ece391_dirent ents[NUM_DIRENTS];
     uint8_t buf[SBUFSIZE];
     uint8_t search[BUFSIZE];
 
@@ -81,16 +89,21 @@ int main ()
 	return 2;
     }
 
-    while (0 != (cnt = ece391_read (fd, buf, SBUFSIZE-1))) {
+    while (0 != (cnt = ece391_getdents (fd, ents, sizeof (ents)))) {
         if (-1 == cnt) {
 	    ece391_fdputs (1, (uint8_t*)"directory entry read failed\n");
 	    return 3;
 	}
-	if ('.' == buf[0]) /* a directory... */
-	    continue;
-	buf[cnt] = '\0';
-	if (0 != do_one_file ((char*)search, (char*)buf))
-	    return 3;
+	for (i = 0; i < cnt / (int32_t)sizeof (ents[0]); i++) {
+	    /* only non-empty regular files can match */
+	    if (2 != ents[i].type || 0 == ents[i].size)
+	        continue;
+	    for (j = 0; j < SBUFSIZE-1 && '\0' != ents[i].name[j]; j++)
+	        buf[j] = ents[i].name[j];
+	    buf[j] = '\0';
+	    if (0 != do_one_file ((char*)search, (char*)buf))
+	        return 3;
+	}
     }
 
     return 0;
@@ -3,25 +3,32 @@
 #include "ece391support.h"
 #include "ece391syscall.h"
 
-#define SBUFSIZE 33
+#define NUM_DIRENTS 16
 
 int main ()
 {
-    int32_t fd, cnt;
-    uint8_t buf[SBUFSIZE];
+    int32_t fd, cnt, i, j, len;
+    struct ece391_dirent ents[NUM_DIRENTS];
+    uint8_t buf[NUM_DIRENTS * 33];
 
     if (-1 == (fd = ece391_open ((uint8_t*)"."))) {
         ece391_fdputs (1, (uint8_t*)"directory open failed\n");
         return 2;
     }
 
-    while (0 != (cnt = ece391_read (fd, buf, SBUFSIZE-1))) {
+    while (0 != (cnt = ece391_getdents (fd, ents, sizeof (ents)))) {
         if (-1 == cnt) {
 	        ece391_fdputs (1, (uint8_t*)"directory entry read failed\n");
 	        return 3;
 	    }
-	    buf[cnt] = '\n';
-	    if (-1 == ece391_write (1, buf, cnt + 1))
+	    /* one line per name, printed with a single write */
+	    len = 0;
+	    for (i = 0; i < cnt / (int32_t)sizeof (ents[0]); i++) {
+	        for (j = 0; j < 32 && '\0' != ents[i].name[j]; j++)
+	            buf[len++] = ents[i].name[j];
+	        buf[len++] = '\n';
+	    }
+	    if (-1 == ece391_write (1, buf, len))
 	        return 3;
     }
 
@@ -102,3 +102,92 @@ uint8_t* ece391_strrev(uint8_t* s)
    return s;
 }
 
+/* Atomically replace *p with v, returning the old value */
+static uint32_t ece391_xchg(volatile uint32_t* p, uint32_t v)
+{
+    asm volatile ("xchgl %0, %1"
+                  : "+r" (v), "+m" (*p)
+                  :
+                  : "memory");
+    return v;
+}
+
+/* Atomically replace *p with new if it holds old, returning the value seen */
+static uint32_t ece391_cmpxchg(volatile uint32_t* p, uint32_t old, uint32_t new)
+{
+    uint32_t prev;
+
+    asm volatile ("lock; cmpxchgl %2, %1"
+                  : "=a" (prev), "+m" (*p)
+                  : "r" (new), "0" (old)
+                  : "memory");
+    return prev;
+}
+
+/* Atomically add v to *p, returning the old value */
+static uint32_t ece391_xadd(volatile uint32_t* p, uint32_t v)
+{
+    asm volatile ("lock; xaddl %0, %1"
+                  : "+r" (v), "+m" (*p)
+                  :
+                  : "memory");
+    return v;
+}
+
+void ece391_mutex_lock(ece391_mutex_t* m)
+{
+    uint32_t c;
+
+    /* fast path: 0 -> 1 without a system call */
+    if (0 == (c = ece391_cmpxchg(&m->state, 0, 1)))
+        return;
+
+    /* contended: mark the lock as having waiters and sleep until it is free */
+    if (2 != c)
+        c = ece391_xchg(&m->state, 2);
+    while (0 != c) {
+        (void)ece391_futex(&m->state, FUTEX_WAIT, 2);
+        c = ece391_xchg(&m->state, 2);
+    }
+}
+
+int32_t ece391_mutex_trylock(ece391_mutex_t* m)
+{
+    return (0 == ece391_cmpxchg(&m->state, 0, 1)) ? 0 : -1;
+}
+
+void ece391_mutex_unlock(ece391_mutex_t* m)
+{
+    /* only enter the kernel if someone may be sleeping on the lock */
+    if (2 == ece391_xchg(&m->state, 0))
+        (void)ece391_futex(&m->state, FUTEX_WAKE, 1);
+}
+
+void ece391_cond_wait(ece391_cond_t* c, ece391_mutex_t* m)
+{
+    uint32_t seq = c->seq;
+
+    (void)ece391_xadd(&c->waiters, 1);
+    ece391_mutex_unlock(m);
+    /* returns immediately if a signal bumped seq after we sampled it */
+    (void)ece391_futex(&c->seq, FUTEX_WAIT, seq);
+    (void)ece391_xadd(&c->waiters, (uint32_t)-1);
+
+    /* other waiters may be queued behind us, so reacquire as contended */
+    while (0 != ece391_xchg(&m->state, 2))
+        (void)ece391_futex(&m->state, FUTEX_WAIT, 2);
+}
+
+void ece391_cond_signal(ece391_cond_t* c)
+{
+    (void)ece391_xadd(&c->seq, 1);
+    if (0 != c->waiters)
+        (void)ece391_futex(&c->seq, FUTEX_WAKE, 1);
+}
+
+void ece391_cond_broadcast(ece391_cond_t* c)
+{
+    (void)ece391_xadd(&c->seq, 1);
+    if (0 != c->waiters)
+        (void)ece391_futex(&c->seq, FUTEX_WAKE, c->waiters);
+}
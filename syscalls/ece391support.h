@@ -9,5 +9,29 @@ extern int32_t ece391_strncmp(const uint8_t* s1, const uint8_t* s2, uint32_t n);
 extern uint8_t *ece391_itoa(uint32_t value, uint8_t* buf, int32_t radix);
 extern uint8_t *ece391_strrev(uint8_t* s);
 
+/* 
+ * Mutex and condition variable built on ece391_futex.  The lock word is
+ * 0 when unlocked, 1 when locked, and 2 when locked with possible waiters,
+ * so neither locking nor unlocking an uncontended mutex enters the kernel.
+ */
+typedef struct ece391_mutex {
+    volatile uint32_t state;
+} ece391_mutex_t;
+
+typedef struct ece391_cond {
+    volatile uint32_t seq;
+    volatile uint32_t waiters;
+} ece391_cond_t;
+
+#define ECE391_MUTEX_INITIALIZER {0}
+#define ECE391_COND_INITIALIZER {0, 0}
+
+extern void ece391_mutex_lock(ece391_mutex_t* m);
+extern int32_t ece391_mutex_trylock(ece391_mutex_t* m);
+extern void ece391_mutex_unlock(ece391_mutex_t* m);
+extern void ece391_cond_wait(ece391_cond_t* c, ece391_mutex_t* m);
+extern void ece391_cond_signal(ece391_cond_t* c);
+extern void ece391_cond_broadcast(ece391_cond_t* c);
+
 #endif /* ECE391SUPPORT_H */
 
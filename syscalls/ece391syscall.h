@@ -5,6 +5,57 @@
 
 /* All calls return >= 0 on success or -1 on failure. */
 
+/* one buffer of a readv/writev */
+struct ece391_iovec {
+    void* base;
+    int32_t len;
+};
+#define ECE391_IOV_MAX 16
+
+/* one getdents record */
+struct ece391_dirent {
+    uint8_t name[32];           /* not NUL terminated when 32 characters long */
+    uint32_t type;              /* 0 RTC, 1 directory, 2 regular file */
+    uint32_t inode;
+    uint32_t size;
+};
+
+/* stat/fstat result */
+struct ece391_stat {
+    uint32_t type;              /* same values as ece391_dirent */
+    uint32_t inode;
+    uint32_t size;
+    uint32_t blocks;            /* 4 KB data blocks used, indirect blocks included */
+};
+
+/* submission/completion rings, heads and tails index the rings modulo ECE391_RING_ENTRIES */
+#define ECE391_RING_ENTRIES 64
+#define RING_OP_READ  0
+#define RING_OP_WRITE 1
+#define RING_OP_OPEN  2
+#define RING_OP_CLOSE 3
+struct ece391_sqe {
+    uint32_t opcode;
+    int32_t fd;
+    void* addr;                 /* buffer, or path for RING_OP_OPEN */
+    int32_t len;
+    uint32_t user_data;
+    uint32_t reserved[3];
+};
+struct ece391_cqe {
+    uint32_t user_data;
+    int32_t res;
+};
+struct ece391_ioring {
+    volatile uint32_t sq_head;  /* advanced by the kernel */
+    uint32_t sq_tail;
+    uint32_t cq_head;
+    volatile uint32_t cq_tail;  /* advanced by the kernel */
+    uint32_t reserved[4];
+    struct ece391_sqe sqes[ECE391_RING_ENTRIES];
+    struct ece391_cqe cqes[ECE391_RING_ENTRIES];
+} __attribute__((aligned(4096)));
+
 /*  
  * Note that the system call for halt will have to make sure that only
  * the low byte of EBX (the status argument) is returned to the calling
@@ -21,6 +72,61 @@ extern int32_t ece391_getargs (uint8_t* buf, int32_t nbytes);
 extern int32_t ece391_vidmap (uint8_t** screen_start);
 extern int32_t ece391_set_handler (int32_t signum, void* handler);
 extern int32_t ece391_sigreturn (void);
+extern int32_t ece391_futex (volatile uint32_t* uaddr, int32_t op, uint32_t val);
+/* Raise ALARM after ticks PIT ticks (10 ms each), then every interval ticks if nonzero. */
+extern int32_t ece391_alarm (uint32_t ticks, uint32_t interval);
+/* Sleep for usec microseconds; returns -1 if a signal arrives first. */
+extern int32_t ece391_usleep (uint32_t usec);
+/* Map a regular file read-only from a 4 KB aligned offset; returns (void*)-1 on failure. */
+extern void* ece391_mmap (int32_t fd, uint32_t offset, uint32_t length);
+/* Create an empty regular file / remove a regular file or an empty directory.
+   Writes to an open file overwrite at the file position and append past the end. */
+extern int32_t ece391_create (const uint8_t* filename);
+extern int32_t ece391_unlink (const uint8_t* filename);
+/* Change the current directory / create an empty directory. Paths are '/'
+   separated and start at the current directory unless they begin with '/'. */
+extern int32_t ece391_chdir (const uint8_t* path);
+extern int32_t ece391_mkdir (const uint8_t* path);
+/* Read into / write from up to ECE391_IOV_MAX buffers with one call. readv stops
+   at the first short segment; both return the bytes transferred. */
+extern int32_t ece391_readv (int32_t fd, const struct ece391_iovec* iov, int32_t iovcnt);
+extern int32_t ece391_writev (int32_t fd, const struct ece391_iovec* iov, int32_t iovcnt);
+/* Move the position of an open regular file; returns the new position. Writes
+   past the end fill the gap with 0s. pread reads at offset and leaves the position alone. */
+extern int32_t ece391_lseek (int32_t fd, int32_t offset, int32_t whence);
+extern int32_t ece391_pread (int32_t fd, void* buf, int32_t nbytes, uint32_t offset);
+/* Fill buf with as many struct ece391_dirent records of an open directory as fit;
+   returns the bytes filled, 0 at the end of the directory. */
+extern int32_t ece391_getdents (int32_t fd, void* buf, int32_t nbytes);
+/* Describe the file at a path / behind an open fd other than stdin and stdout. */
+extern int32_t ece391_stat (const uint8_t* path, struct ece391_stat* buf);
+extern int32_t ece391_fstat (int32_t fd, struct ece391_stat* buf);
+/* Register a page aligned struct ece391_ioring (NULL to unregister), then queue
+   entries at sq_tail and run up to to_submit of them with one ring_enter, which
+   returns how many ran. Each gets a completion at cq_tail holding user_data and
+   what the matching read/write/open/close returned. */
+extern int32_t ece391_ring_setup (struct ece391_ioring* ring);
+extern int32_t ece391_ring_enter (uint32_t to_submit);
+/* Copy up to count bytes of an open regular file, from its position, to out_fd
+   without a user buffer; returns the bytes copied, 0 at the end of the file. */
+extern int32_t ece391_sendfile (int32_t out_fd, int32_t in_fd, int32_t count);
+/* Make the lowest unused fd (dup) or new_fd (dup2) share fd's open file and
+   position; dup2 closes new_fd first. Returns the new fd. */
+extern int32_t ece391_dup (int32_t fd);
+extern int32_t ece391_dup2 (int32_t fd, int32_t new_fd);
+
+/* lseek whence */
+#define SEEK_SET 0
+#define SEEK_CUR 1
+#define SEEK_END 2
+
+/* futex operations */
+#define FUTEX_WAIT 0
+#define FUTEX_WAKE 1
+
+/* RTC read mode, written after the frequency: ece391_write (fd, {freq, mode}, 8).
+   Reads return the number of ticks since the last read. */
+#define RTC_NONBLOCK 0x1
 
 enum signums {
 	DIV_ZERO = 0,
@@ -91,7 +91,7 @@ int err_big_fd(void) {
 
 
 /* TEST 3 err_open_lots
- * calls open correctly seven times
+ * calls open correctly seven times, the fd table grows past 8 fds
  * prints "[TEST_NAME]: PASS" if behavior is EXPECTED
  *     and then returns 0
  * prints "[TEST_NAME]: FAIL" if behavior is UNEXPECTED
@@ -100,20 +100,20 @@ int err_big_fd(void) {
 int err_open_lots(void) {
     int32_t i, cnt = 0;
 	
-	// fd = 0,1 taken, so we should be able to open 6 files (2,3,4,5,6,7)
-	// the last file open should fail
+	// fd = 0,1 taken, so the files get fds 2 through 8
+	// every open should succeed
     for (i = 0; i < 7; i++) {
 	    if (-1 == ece391_open ((uint8_t*)".")) {
 			cnt++;
         }
     }
     //close all fds that were just opened.
-    for(i = 2; i < 8; i++)
+    for(i = 2; i < 9; i++)
     {
     	ece391_close(i);
     }
     
-	if (cnt == 1) {
+	if (cnt == 0) {
 		ece391_fdputs(1, (uint8_t*)"err_open_lots: PASS\n");
 		return 0;
 	} else {
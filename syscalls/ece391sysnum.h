@@ -11,5 +11,25 @@
 #define SYS_VIDMAP  8
 #define SYS_SET_HANDLER  9
 #define SYS_SIGRETURN  10
+#define SYS_FUTEX   11
+#define SYS_ALARM   12
+#define SYS_USLEEP  13
+#define SYS_MMAP    14
+#define SYS_CREATE  15
+#define SYS_UNLINK  16
+#define SYS_CHDIR   17
+#define SYS_MKDIR   18
+#define SYS_READV   19
+#define SYS_WRITEV  20
+#define SYS_LSEEK   21
+#define SYS_PREAD   22
+#define SYS_GETDENTS 23
+#define SYS_STAT    24
+#define SYS_FSTAT   25
+#define SYS_RING_SETUP 26
+#define SYS_RING_ENTER 27
+#define SYS_SENDFILE 28
+#define SYS_DUP     29
+#define SYS_DUP2    30
 
 #endif /* ECE391SYSNUM_H */